@@ -1,8 +1,21 @@
 #include "array2d.h"
 
+#include <algorithm>
+#include <functional>
 #include <iostream>
 #include <iterator>
 
+// multiplication table computed by the compiler
+template <size_t N>
+constexpr std::array2d<int, N, N> multiplication_table()
+{
+  std::array2d<int, N, N> t;
+  for (size_t c = 0; c < N; ++c)
+    for (size_t r = 0; r < N; ++r)
+      t(c, r) = int((c + 1) * (r + 1));
+  return t;
+}
+
 int main(int argc, char **argv)
 {
   // array2d<int, 2, 3> test;
@@ -14,5 +27,28 @@ int main(int argc, char **argv)
     std::cout << v << ", ";
   std::cout << std::endl;
 
+  // iterate over the elements of a row
+  for (auto v : test.row(1))
+    std::cout << v << ", ";
+  std::cout << std::endl;
+
+  // sort the first row in place and zero a sub-block, without copies
+  auto r = test.row(0);
+  std::sort(r.begin(), r.end(), std::greater<int>());
+  auto b = test.block(1, 1, 1, 2);
+  std::fill(b.begin(), b.end(), 0);
+
+  for (auto v : test)
+    std::cout << v << ", ";
+  std::cout << std::endl;
+
+  // lookup tables built at compile time and placed in read-only data
+  static constexpr std::array2d<int, 9, 9> table = multiplication_table<9>();
+  static_assert(table(6, 7) == 56, "evaluated at compile time");
+
+  for (auto v : table.col(2))
+    std::cout << v << ", ";
+  std::cout << std::endl;
+
   return 0;
 }
\ No newline at end of file
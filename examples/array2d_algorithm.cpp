@@ -0,0 +1,50 @@
+#include "array2d_algorithm.h"
+#include "timer.h"
+
+#include <cmath>
+#include <functional>
+#include <iostream>
+
+int main(int argc, char **argv)
+{
+  std::cout << "threads : " << ThreadPool::global().num_threads() << std::endl;
+
+  const size_t sizes[] = {1024, 4096};
+  for (size_t n : sizes)
+  {
+    std::vector2d<float> a(n, n), b(n, n);
+    const float mp = float(n * n) / 1e3f; // mega elements per second from ms
+
+    // the serial loops the algorithms replace
+    float tlinear, tloop, tseq, tpar, tunseq;
+    BENCH_TIME(for (size_t i = 0; i < a.num(); ++i) a(i) = float(int(i % n)) * 0.5f, 5, tlinear)
+    BENCH_TIME(for (size_t c = 0; c < n; ++c) for (size_t r = 0; r < n; ++r) a(c, r) = float(int(r)) * 0.5f, 5, tloop)
+    BENCH_TIME(std::for_each_index(std::execution2d::seq, a, [](size_t, size_t r, float &x) { x = float(int(r)) * 0.5f; }), 5, tseq)
+    BENCH_TIME(std::for_each_index(std::execution2d::par, a, [](size_t, size_t r, float &x) { x = float(int(r)) * 0.5f; }), 5, tpar)
+    BENCH_TIME(std::for_each_index(std::execution2d::par_unseq, a, [](size_t, size_t r, float &x) { x = float(int(r)) * 0.5f; }), 5, tunseq)
+
+    std::cout << n << "x" << n << std::endl
+              << "  fill by index : operator()(i) " << mp / tlinear << " ME/s, double loop " << mp / tloop << " ME/s, "
+              << "seq " << mp / tseq << " ME/s, par " << mp / tpar << " ME/s, par_unseq " << mp / tunseq << " ME/s" << std::endl;
+
+    auto f = [](float x) { return std::sqrt(x * x + 1.f); };
+    BENCH_TIME(for (size_t c = 0; c < n; ++c) for (size_t r = 0; r < n; ++r) b(c, r) = f(a(c, r)), 5, tloop)
+    BENCH_TIME(std::transform(std::execution2d::seq, a, b, f), 5, tseq)
+    BENCH_TIME(std::transform(std::execution2d::par, a, b, f), 5, tpar)
+    BENCH_TIME(std::transform(std::execution2d::par_unseq, a, b, f), 5, tunseq)
+    std::cout << "  transform     : double loop " << mp / tloop << " ME/s, "
+              << "seq " << mp / tseq << " ME/s, par " << mp / tpar << " ME/s, par_unseq " << mp / tunseq << " ME/s" << std::endl;
+
+    double sloop = 0., sseq, spar, sunseq;
+    auto sq = [](float x) { return double(x) * double(x); };
+    BENCH_TIME(sloop = 0.; for (size_t c = 0; c < n; ++c) for (size_t r = 0; r < n; ++r) sloop += sq(a(c, r)), 5, tloop)
+    BENCH_TIME(sseq = std::transform_reduce(std::execution2d::seq, a, 0., std::plus<>(), sq), 5, tseq)
+    BENCH_TIME(spar = std::transform_reduce(std::execution2d::par, a, 0., std::plus<>(), sq), 5, tpar)
+    BENCH_TIME(sunseq = std::transform_reduce(std::execution2d::par_unseq, a, 0., std::plus<>(), sq), 5, tunseq)
+    std::cout << "  sum of squares: double loop " << mp / tloop << " ME/s, "
+              << "seq " << mp / tseq << " ME/s, par " << mp / tpar << " ME/s, par_unseq " << mp / tunseq << " ME/s"
+              << " (relative error " << std::abs(sunseq - sloop) / sloop << ", par " << (spar == sseq ? "==" : "!=") << " seq)" << std::endl;
+  }
+
+  return 0;
+}
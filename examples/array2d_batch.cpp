@@ -0,0 +1,89 @@
+#include "array2d_batch.h"
+#include "timer.h"
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+typedef std::array2d<float, 4, 4> mat4;
+typedef std::array2d<float, 1, 3> vec3;
+
+// the same kernels on an array of structures, one matrix at a time
+void aos_matmul(const std::vector<mat4> &a, const std::vector<mat4> &b, std::vector<mat4> &c)
+{
+  for (size_t i = 0; i < a.size(); ++i)
+    for (size_t col = 0; col < 4; ++col)
+      for (size_t row = 0; row < 4; ++row)
+      {
+        float s = 0.f;
+        for (size_t k = 0; k < 4; ++k)
+          s += a[i](k, row) * b[i](col, k);
+        c[i](col, row) = s;
+      }
+}
+
+void aos_transform(const std::vector<mat4> &m, const std::vector<vec3> &p, std::vector<vec3> &out)
+{
+  for (size_t i = 0; i < m.size(); ++i)
+  {
+    float v[4];
+    for (size_t row = 0; row < 4; ++row)
+      v[row] = m[i](0, row) * p[i](0, 0) + m[i](1, row) * p[i](0, 1) + m[i](2, row) * p[i](0, 2) + m[i](3, row);
+    for (size_t row = 0; row < 3; ++row)
+      out[i](0, row) = v[row] / v[3];
+  }
+}
+
+int main(int argc, char **argv)
+{
+  std::cout << "isa : " << std::simd_isa_name(std::simd_isa_detect()) << std::endl;
+
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+
+  const size_t n = 200000;
+  std::vector<mat4> a(n), b(n), c(n);
+  std::vector<vec3> p(n), q(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    for (size_t e = 0; e < 16; ++e)
+    {
+      a[i].data()[e] = dist(gen) + (e % 5 == 0 ? 4.f : 0.f); // diagonally dominant, hence invertible
+      b[i].data()[e] = dist(gen);
+    }
+    for (size_t e = 0; e < 3; ++e)
+      p[i].data()[e] = dist(gen);
+  }
+
+  std::array2d_batch<float, 4, 4> ba, bb, bc;
+  std::array2d_batch<float, 1, 3> bp, bq;
+  float tgather, tscatter, taos_mul, tmul, tinv, ttr, taos_tf, ttf;
+  BENCH_TIME(ba.gather(a.data(), n); bb.gather(b.data(), n), 10, tgather)
+  BENCH_TIME(aos_matmul(a, b, c), 10, taos_mul)
+  BENCH_TIME(std::batch_matmul(ba, bb, bc), 10, tmul)
+  BENCH_TIME(bc.scatter(c.data()), 10, tscatter)
+  BENCH_TIME(std::batch_inverse(ba, bc), 10, tinv)
+  BENCH_TIME(std::batch_transpose(ba, bc), 10, ttr)
+
+  bp.gather(p.data(), n);
+  BENCH_TIME(aos_transform(a, p, q), 10, taos_tf)
+  BENCH_TIME(std::batch_transform_points(ba, bp, bq), 10, ttf)
+
+  // largest error of a[i] * a[i]^-1 against the identity
+  std::batch_inverse(ba, bc);
+  std::batch_matmul(ba, bc, bb);
+  float err = 0.f;
+  for (size_t i = 0; i < n; ++i)
+    for (size_t col = 0; col < 4; ++col)
+      for (size_t row = 0; row < 4; ++row)
+        err = std::max(err, std::abs(bb(i, col, row) - (col == row ? 1.f : 0.f)));
+
+  const float mn = float(n) / 1e3f; // millions of matrices per second from ms
+  std::cout << n << " 4x4 matrices : gather " << tgather / 2 << "ms, scatter " << tscatter << "ms" << std::endl
+            << "  multiply  : aos " << mn / taos_mul << " M/s, batch " << mn / tmul << " M/s" << std::endl
+            << "  inverse   : batch " << mn / tinv << " M/s (max error " << err << ")" << std::endl
+            << "  transpose : batch " << mn / ttr << " M/s" << std::endl
+            << "  transform : aos " << mn / taos_tf << " M/s, batch " << mn / ttf << " M/s" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include "array2d_convert.h"
+#include "timer.h"
+
+#include <iostream>
+#include <random>
+
+// element by element conversion with std::clamp and std::lround
+template <typename T, typename U>
+void naive_convert(const std::vector2d<T> &src, std::vector2d<U> &dst, double scale, double offset)
+{
+  for (size_t c = 0; c < src.num_col(); ++c)
+    for (size_t r = 0; r < src.num_row(); ++r)
+    {
+      const double v = double(src(c, r)) * scale + offset;
+      if constexpr (std::is_integral<U>::value)
+        dst(c, r) = U(std::lround(std::clamp(v, double(std::numeric_limits<U>::lowest()), double(std::numeric_limits<U>::max()))));
+      else
+        dst(c, r) = U(v);
+    }
+}
+
+template <typename T, typename U>
+void bench(const char *name, size_t n, double scale, double offset)
+{
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<double> dist(0.0, 1.0);
+
+  std::vector2d<T> src(n, n);
+  std::vector2d<U> dst(n, n), ref(n, n);
+  for (T &x : src)
+    x = std::saturate_round<T>(dist(gen) * (std::is_integral<T>::value ? double(std::numeric_limits<T>::max()) : 1.0));
+
+  // throughput in mega pixels per second
+  float tnaive, tseq, tpar;
+  BENCH_TIME(naive_convert(src, ref, scale, offset), 5, tnaive)
+  BENCH_TIME(std::convert(src, dst, scale, offset), 20, tseq)
+  BENCH_TIME(std::convert(std::execution2d::par, src, dst, scale, offset), 20, tpar)
+
+  // the naive loop rounds ties away from zero
+  double err = 0.0;
+  for (size_t i = 0; i < ref.num(); ++i)
+    err = std::max(err, std::abs(double(ref.data()[i]) - double(dst.data()[i])));
+
+  const float mp = float(src.num()) / 1e3f;
+  std::cout << "  " << name << " : naive " << mp / tnaive << " MP/s, convert " << mp / tseq
+            << " MP/s, par " << mp / tpar << " MP/s (max difference " << err << ")" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  std::cout << "threads : " << ThreadPool::global().num_threads()
+            << ", isa : " << std::simd_isa_name(std::simd_isa_detect()) << std::endl;
+
+  const size_t sizes[] = {1024, 4096};
+  for (size_t n : sizes)
+  {
+    std::cout << n << "x" << n << std::endl;
+    bench<uint8_t, float>("uint8 -> float", n, 1.0 / 255.0, 0.0);
+    bench<float, uint8_t>("float -> uint8", n, 255.0, 0.0);
+    bench<uint16_t, uint8_t>("uint16 -> uint8", n, 1.0 / 257.0, 0.0);
+    bench<uint8_t, uint16_t>("uint8 -> uint16", n, 257.0, 0.0);
+    bench<float, uint16_t>("float -> uint16", n, 65535.0, 0.0);
+    bench<uint16_t, float>("uint16 -> float", n, 1.0 / 65535.0, 0.0);
+    bench<double, float>("double -> float", n, 2.0, -1.0);
+    bench<float, double>("float -> double", n, 1.0, 0.0);
+    bench<double, uint8_t>("double -> uint8", n, 300.0, -20.0);
+  }
+
+  return 0;
+}
@@ -0,0 +1,86 @@
+#include "array2d.h"
+#include "vector2d.h"
+#include "timer.h"
+
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+// element by element loops, as written before the bulk operations
+template <typename A>
+void loop_fill(A &a, float v)
+{
+  for (size_t c = 0; c < a.num_col(); ++c)
+    for (size_t r = 0; r < a.num_row(); ++r)
+      a(c, r) = v;
+}
+
+template <typename A>
+void loop_assign(A &a, const float *src)
+{
+  for (size_t c = 0; c < a.num_col(); ++c)
+    for (size_t r = 0; r < a.num_row(); ++r)
+      a(c, r) = *src++;
+}
+
+template <typename A>
+void loop_copy_to(const A &a, float *dst)
+{
+  for (size_t c = 0; c < a.num_col(); ++c)
+    for (size_t r = 0; r < a.num_row(); ++r)
+      *dst++ = a(c, r);
+}
+
+template <typename A>
+void loop_row_major(A &a, const float *src)
+{
+  for (size_t c = 0; c < a.num_col(); ++c)
+    for (size_t r = 0; r < a.num_row(); ++r)
+      a(c, r) = src[r * a.num_col() + c];
+}
+
+// n is the number of repetitions, gb the number of bytes written by one call
+template <typename A>
+void bench(const char *name, A &a, size_t n)
+{
+  std::vector<float> buf(a.num());
+  std::iota(buf.begin(), buf.end(), 0.f);
+  A b = a;
+
+  const float gb = a.num() * sizeof(float) / 1e9f;
+  auto gbs = [gb](float ms) { return gb / (ms * 1e-3f); };
+
+  float tlf, tf, tla, ta, tlc, tc, tlr, tr, tsw;
+  BENCH_TIME(loop_fill(a, 1.f), n, tlf)
+  BENCH_TIME(a.fill(2.f), n, tf)
+  BENCH_TIME(loop_assign(a, buf.data()), n, tla)
+  BENCH_TIME(a.assign(buf.data(), buf.size()), n, ta)
+  BENCH_TIME(loop_copy_to(a, buf.data()), n, tlc)
+  BENCH_TIME(a.copy_to(buf.data()), n, tc)
+  BENCH_TIME(loop_row_major(a, buf.data()), n, tlr)
+  BENCH_TIME(a.assign(buf.data(), 1, std::ptrdiff_t(a.num_col())), n, tr)
+  BENCH_TIME(a.swap(b), n, tsw)
+
+  std::cout << name << " (GB/s, loop / bulk) : fill " << gbs(tlf) << " / " << gbs(tf)
+            << ", assign " << gbs(tla) << " / " << gbs(ta)
+            << ", copy_to " << gbs(tlc) << " / " << gbs(tc)
+            << ", row major import " << gbs(tlr) << " / " << gbs(tr)
+            << " | swap " << tsw * 1e3f << "us (check " << a(0, 0) + b(0, 0) << ")" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  static std::array2d<float, 64, 64> small;
+  bench("array2d 64x64", small, 10000);
+
+  std::vector2d<float> v256(256, 256);
+  bench("vector2d 256x256", v256, 1000);
+
+  std::vector2d<float> v2048(2048, 2048);
+  bench("vector2d 2048x2048", v2048, 20);
+
+  std::vector2d<float> p2048 = std::vector2d<float>::pitched(2048, 2000);
+  bench("vector2d 2048x2000 pitched", p2048, 20);
+
+  return 0;
+}
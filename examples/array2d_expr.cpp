@@ -0,0 +1,48 @@
+#include "array2d_expr.h"
+#include "timer.h"
+
+#include <iostream>
+
+// evaluates d = a + b * c - e the naive way, with one temporary array per operator
+void naive(const std::vector2d<float> &a, const std::vector2d<float> &b, const std::vector2d<float> &c,
+           const std::vector2d<float> &e, std::vector2d<float> &d)
+{
+  std::vector2d<float> t0(a.num_col(), a.num_row());
+  for (size_t i = 0; i < t0.num(); ++i)
+    t0[i] = b[i] * c[i];
+
+  std::vector2d<float> t1(a.num_col(), a.num_row());
+  for (size_t i = 0; i < t1.num(); ++i)
+    t1[i] = a[i] + t0[i];
+
+  for (size_t i = 0; i < d.num(); ++i)
+    d[i] = t1[i] - e[i];
+}
+
+int main(int argc, char **argv)
+{
+  // small fixed size arrays
+  std::array2d<int, 2, 3> x{1, -2, 3, -4, 5, -6};
+  std::array2d<int, 2, 3> y;
+  y = std::cwise_abs(x) * 2 + 1;
+
+  for (auto v : y)
+    std::cout << v << ", ";
+  std::cout << std::endl;
+
+  // benchmark fused evaluation against temporaries
+  const size_t sizes[] = {64, 256, 1024, 2048};
+  for (size_t n : sizes)
+  {
+    std::vector2d<float> a(n, n, 1.f), b(n, n, 2.f), c(n, n, 3.f), e(n, n, 4.f), d(n, n);
+
+    float tnaive, tfused;
+    BENCH_TIME(naive(a, b, c, e, d), 20, tnaive)
+    BENCH_TIME(d = a + b * c - e, 20, tfused)
+
+    std::cout << n << "x" << n << " : naive " << tnaive << "ms, fused " << tfused << "ms, speedup x"
+              << tnaive / tfused << " (check " << d(n - 1, n - 1) << ")" << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,71 @@
+#include "array2d_filter.h"
+#include "timer.h"
+
+#include <iostream>
+#include <random>
+
+// gaussian blur written as a double loop with the border clamped on every access
+void naive(const std::vector2d<float> &src, std::vector2d<float> &dst, const std::vector<float> &k)
+{
+  const long nc = long(src.num_col());
+  const long nr = long(src.num_row());
+  const long h = long(k.size() / 2);
+
+  for (long c = 0; c < nc; ++c)
+    for (long r = 0; r < nr; ++r)
+    {
+      float s = 0.f;
+      for (long i = -h; i <= h; ++i)
+        for (long j = -h; j <= h; ++j)
+          s += k[i + h] * k[j + h] * src(std::clamp(c + i, 0l, nc - 1), std::clamp(r + j, 0l, nr - 1));
+      dst(c, r) = s;
+    }
+}
+
+int main(int argc, char **argv)
+{
+  std::cout << "threads : " << ThreadPool::global().num_threads()
+            << ", isa : " << std::simd_isa_name(std::simd_isa_detect()) << std::endl;
+
+  const std::vector<float> gauss = std::gaussian_kernel<float>(2.0);
+  const std::vector<float> sobel_d = {-1.f, 0.f, 1.f};
+  const std::vector<float> sobel_s = {1.f, 2.f, 1.f};
+  const std::array2d<float, 3, 3> laplacian = {0.f, 1.f, 0.f, 1.f, -4.f, 1.f, 0.f, 1.f, 0.f};
+
+  std::vector2d<float> gauss2d(gauss.size(), gauss.size());
+  for (size_t i = 0; i < gauss.size(); ++i)
+    for (size_t j = 0; j < gauss.size(); ++j)
+      gauss2d(i, j) = gauss[i] * gauss[j];
+
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+
+  const size_t sizes[] = {512, 1024, 2048, 4096};
+  for (size_t n : sizes)
+  {
+    std::vector2d<float> img(n, n), a(n, n), b(n, n);
+    for (float &x : img)
+      x = dist(gen);
+
+    // mega pixels per second
+    const float mp = float(n * n) / 1e6f;
+
+    float tnaive, tsep, t2d, tsobel, tlap, tmirror;
+    BENCH_TIME(naive(img, a, gauss), 2, tnaive)
+    BENCH_TIME(std::convolve_separable(img, b, gauss, gauss), 10, tsep)
+    BENCH_TIME(std::convolve(img, a, gauss2d), 5, t2d)
+    BENCH_TIME(std::convolve_separable(img, a, sobel_d, sobel_s), 10, tsobel)
+    BENCH_TIME(std::convolve(img, a, laplacian, std::border_mode::CONSTANT, 0.f), 10, tlap)
+    BENCH_TIME(std::convolve_separable(img, a, gauss, gauss, std::border_mode::MIRROR), 10, tmirror)
+
+    std::cout << n << "x" << n << " (MP/s) : gaussian " << gauss.size() << "x" << gauss.size()
+              << " naive " << mp / (tnaive * 1e-3f)
+              << ", separable " << mp / (tsep * 1e-3f)
+              << ", 2d " << mp / (t2d * 1e-3f)
+              << ", mirror " << mp / (tmirror * 1e-3f)
+              << " | sobel " << mp / (tsobel * 1e-3f)
+              << " | laplacian " << mp / (tlap * 1e-3f) << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,67 @@
+#include "array2d_gemm.h"
+#include "timer.h"
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+// textbook triple loop
+void naive(const std::vector2d<float> &a, const std::vector2d<float> &b, std::vector2d<float> &c)
+{
+  for (size_t i = 0; i < c.num_row(); ++i)
+    for (size_t j = 0; j < c.num_col(); ++j)
+    {
+      float s = 0.f;
+      for (size_t p = 0; p < a.num_col(); ++p)
+        s += a(p, i) * b(j, p);
+      c(j, i) = s;
+    }
+}
+
+int main(int argc, char **argv)
+{
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+
+  std::cout << "cpu isa : " << std::simd_isa_name(std::simd_isa_detect()) << std::endl;
+
+  const size_t sizes[] = {64, 256, 512, 1024};
+  for (size_t n : sizes)
+  {
+    std::vector2d<float> a(n, n), b(n, n), c(n, n);
+    for (auto &v : a)
+      v = dist(gen);
+    for (auto &v : b)
+      v = dist(gen);
+
+    const float gflop = 2.f * n * n * n / 1e9f;
+    std::cout << n << "x" << n << " :";
+
+    if (n <= 512)
+    {
+      float t;
+      BENCH_TIME(naive(a, b, c), 2, t)
+      std::cout << " naive " << gflop / (t * 1e-3f) << " GFlop/s,";
+    }
+
+    for (int isa = int(std::simd_isa::SCALAR); isa <= int(std::simd_isa_detect()); ++isa)
+    {
+      float t;
+      BENCH_TIME(std::gemm(n, n, n, 1.f, a.data(), n, b.data(), n, 0.f, c.data(), n, std::simd_isa(isa)), 5, t)
+      std::cout << " " << std::simd_isa_name(std::simd_isa(isa)) << " " << gflop / (t * 1e-3f) << " GFlop/s,";
+    }
+    std::cout << std::endl;
+  }
+
+  // fixed size products are unrolled
+  std::vector<std::array2d<float, 4, 4>> ms(4096), ps(4096);
+  for (auto &m : ms)
+    for (auto &v : m)
+      v = dist(gen);
+
+  float t;
+  BENCH_TIME(for (size_t i = 0; i < ms.size(); ++i) std::matmul(ms[i], ms[(i + 1) % ms.size()], ps[i]), 100, t)
+  std::cout << "4x4 : " << t * 1e6f / ms.size() << " ns per product (check " << ps[0](0, 0) << ")" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include "array2d_integral.h"
+#include "timer.h"
+
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// summed-area table with the usual recurrence, one element at a time
+void naive(const std::vector2d<uint8_t> &src, std::vector2d<uint64_t> &sat)
+{
+  sat.fill(0);
+  for (size_t c = 0; c < src.num_col(); ++c)
+    for (size_t r = 0; r < src.num_row(); ++r)
+      sat(c + 1, r + 1) = src(c, r) + sat(c, r + 1) + sat(c + 1, r) - sat(c, r);
+}
+
+// sum over a rectangle by visiting all its elements
+uint64_t brute_sum(const std::vector2d<uint8_t> &src, const std::rect2d &rc)
+{
+  uint64_t s = 0;
+  for (size_t c = rc.c0; c < rc.c1; ++c)
+    for (size_t r = rc.r0; r < rc.r1; ++r)
+      s += src(c, r);
+  return s;
+}
+
+int main(int argc, char **argv)
+{
+  std::cout << "threads : " << ThreadPool::global().num_threads() << std::endl;
+
+  std::mt19937 gen(0);
+
+  const size_t sizes[] = {1024, 2048, 4096};
+  for (size_t n : sizes)
+  {
+    std::vector2d<uint8_t> img(n, n);
+    for (uint8_t &x : img)
+      x = uint8_t(gen());
+
+    std::vector2d<uint64_t> sat(n + 1, n + 1), ref(n + 1, n + 1);
+    float tnaive, tsat;
+    BENCH_TIME(naive(img, ref), 3, tnaive)
+    BENCH_TIME(std::integral_image(img, sat), 10, tsat)
+
+    // random boxes of up to 64 x 64 elements
+    const size_t nq = 100000;
+    std::vector<std::rect2d> rects(nq);
+    for (std::rect2d &rc : rects)
+    {
+      rc.c0 = gen() % (n - 64);
+      rc.r0 = gen() % (n - 64);
+      rc.c1 = rc.c0 + 1 + gen() % 64;
+      rc.r1 = rc.r0 + 1 + gen() % 64;
+    }
+
+    std::vector<uint64_t> sums(nq);
+    uint64_t check = 0;
+    float tbrute, tbatch;
+    BENCH_TIME(for (const std::rect2d &rc : rects) check += brute_sum(img, rc), 1, tbrute)
+    BENCH_TIME(std::rect_sum(sat, rects.data(), nq, sums.data()), 10, tbatch)
+
+    std::cout << n << "x" << n << " : table naive " << tnaive << "ms, parallel " << tsat << "ms"
+              << " | " << nq << " box sums, brute force " << tbrute << "ms, table " << tbatch << "ms"
+              << " (check " << (check == std::accumulate(sums.begin(), sums.end(), uint64_t(0)) ? "ok" : "failed") << ")"
+              << std::endl;
+  }
+
+  return 0;
+}
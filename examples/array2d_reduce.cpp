@@ -0,0 +1,68 @@
+#include "array2d_reduce.h"
+#include "timer.h"
+
+#include <iostream>
+#include <random>
+
+// column by column reductions with a single accumulator
+template <typename T>
+double naive_sum(const std::vector2d<T> &a)
+{
+  double s = 0.0;
+  for (size_t c = 0; c < a.num_col(); ++c)
+    for (size_t r = 0; r < a.num_row(); ++r)
+      s += double(a(c, r));
+  return s;
+}
+
+template <typename T>
+std::array<size_t, 2> naive_argmax(const std::vector2d<T> &a)
+{
+  std::array<size_t, 2> best = {0, 0};
+  for (size_t c = 0; c < a.num_col(); ++c)
+    for (size_t r = 0; r < a.num_row(); ++r)
+      if (a(best[0], best[1]) < a(c, r))
+        best = {c, r};
+  return best;
+}
+
+int main(int argc, char **argv)
+{
+  std::cout << "threads : " << ThreadPool::global().num_threads() << std::endl;
+
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+
+  const size_t sizes[] = {1024, 4096};
+  for (size_t n : sizes)
+  {
+    std::vector2d<float> a(n, n), b(n, n);
+    for (float &x : a)
+      x = dist(gen);
+    for (float &x : b)
+      x = dist(gen);
+
+    // throughput in mega elements per second
+    double snaive = 0.0, s = 0.0, d = 0.0;
+    std::array<size_t, 2> anaive, am;
+    std::vector<float> rows;
+    float tnaive, tsum, targnaive, targ, tdot, trows;
+    BENCH_TIME(snaive = naive_sum(a), 3, tnaive)
+    BENCH_TIME(s = std::sum(a), 10, tsum)
+    BENCH_TIME(anaive = naive_argmax(a), 3, targnaive)
+    BENCH_TIME(am = std::argmax(a), 10, targ)
+    BENCH_TIME(d = std::dot(a, b), 10, tdot)
+    BENCH_TIME(rows = std::sum_rows(a), 10, trows)
+
+    const float me = float(a.num()) / 1e3f;
+    std::cout << n << "x" << n << " floats" << std::endl
+              << "  sum    : naive " << me / tnaive << " M/s, sum " << me / tsum << " M/s"
+              << " (relative difference " << std::abs(s - snaive) / snaive << ")" << std::endl
+              << "  argmax : naive " << me / targnaive << " M/s, argmax " << me / targ << " M/s"
+              << " (check " << (anaive == am ? "ok" : "failed") << ")" << std::endl
+              << "  dot " << me / tdot << " M/s, sum_rows " << me / trows << " M/s"
+              << " (" << d << ", " << rows.size() << " rows)" << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,78 @@
+#include "array2d_resample.h"
+#include "timer.h"
+
+#include <iostream>
+#include <random>
+
+// bilinear resampling computing the weights of every element on the fly
+void naive_bilinear(const std::vector2d<float> &src, std::vector2d<float> &dst)
+{
+  const float sc = float(src.num_col()) / float(dst.num_col());
+  const float sr = float(src.num_row()) / float(dst.num_row());
+  const long nc = long(src.num_col());
+  const long nr = long(src.num_row());
+
+  for (size_t c = 0; c < dst.num_col(); ++c)
+    for (size_t r = 0; r < dst.num_row(); ++r)
+    {
+      const float x = (float(c) + 0.5f) * sc - 0.5f;
+      const float y = (float(r) + 0.5f) * sr - 0.5f;
+      const long x0 = long(std::floor(x));
+      const long y0 = long(std::floor(y));
+      const float fx = x - float(x0);
+      const float fy = y - float(y0);
+      const long c0 = std::clamp(x0, 0l, nc - 1), c1 = std::clamp(x0 + 1, 0l, nc - 1);
+      const long r0 = std::clamp(y0, 0l, nr - 1), r1 = std::clamp(y0 + 1, 0l, nr - 1);
+      dst(c, r) = (1.f - fx) * ((1.f - fy) * src(c0, r0) + fy * src(c0, r1)) +
+                  fx * ((1.f - fy) * src(c1, r0) + fy * src(c1, r1));
+    }
+}
+
+int main(int argc, char **argv)
+{
+  std::cout << "threads : " << ThreadPool::global().num_threads()
+            << ", isa : " << std::simd_isa_name(std::simd_isa_detect()) << std::endl;
+
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+
+  const char *names[] = {"nearest", "bilinear", "bicubic", "area"};
+  const std::interpolation modes[] = {std::interpolation::NEAREST, std::interpolation::BILINEAR,
+                                      std::interpolation::BICUBIC, std::interpolation::AREA};
+
+  const size_t sizes[] = {1024, 2048, 4096};
+  for (size_t n : sizes)
+  {
+    std::vector2d<float> img(n, n), half(n / 2, n / 2), twice(2 * n, 2 * n), ref(n / 2, n / 2);
+    for (float &x : img)
+      x = dist(gen);
+
+    // throughput in output mega pixels per second
+    float tnaive;
+    BENCH_TIME(naive_bilinear(img, ref), 2, tnaive)
+    std::resample(img, half, std::interpolation::BILINEAR);
+    float err = 0.f;
+    for (size_t i = 0; i < ref.num(); ++i)
+      err = std::max(err, std::abs(ref.data()[i] - half.data()[i]));
+
+    std::cout << n << "x" << n << " : naive bilinear /2 " << float(half.num()) / 1e3f / tnaive << " MP/s (max error " << err << ")" << std::endl;
+    for (size_t m = 0; m < 4; ++m)
+    {
+      float tdown, tup;
+      BENCH_TIME(std::resample(img, half, modes[m]), 10, tdown)
+      BENCH_TIME(std::resample(img, twice, modes[m]), 5, tup)
+      std::cout << "  " << names[m] << " : /2 " << float(half.num()) / 1e3f / tdown << " MP/s"
+                << ", x2 " << float(twice.num()) / 1e3f / tup << " MP/s" << std::endl;
+    }
+
+    // the buffers of the pyramid are allocated by the first call only
+    std::pyramid2d<float> pyr;
+    std::build_pyramid(img, pyr, 6);
+    float tpyr;
+    BENCH_TIME(std::build_pyramid(img, pyr, 6), 10, tpyr)
+    std::cout << "  pyramid of " << pyr.num_levels() << " levels : " << tpyr << "ms, "
+              << float(img.num()) / 1e3f / tpyr << " MP/s of input" << std::endl;
+  }
+
+  return 0;
+}
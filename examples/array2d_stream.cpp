@@ -0,0 +1,73 @@
+#include "array2d_stream.h"
+#include "timer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+// a few flops per element so that compute and i/o are of the same order
+void kernel(const std::vector2d<float> &in, std::vector2d<float> &out, size_t)
+{
+  for (size_t c = 0; c < in.num_col(); ++c)
+    for (size_t r = 0; r < in.num_row(); ++r)
+      out(c, r) = std::sqrt(in(c, r) * in(c, r) + 1.f) * 0.5f;
+}
+
+void copy(const std::vector2d<float> &in, std::vector2d<float> &out, size_t)
+{
+  out.assign(in.data(), in.num());
+}
+
+int main(int argc, char **argv)
+{
+  const std::string src = argc > 1 ? argv[1] : "stream_src.a2d";
+  const std::string dst = argc > 2 ? argv[2] : "stream_dst.a2d";
+  const size_t ncol = 16384, nrow = 4096, band = 256; // 256MB file, 4MB bands
+
+  // writes the source file band by band
+  {
+    std::band_writer<float> out(src, ncol, nrow, band);
+    for (size_t b = 0; b < out.num_bands(); ++b)
+    {
+      std::vector2d<float> &a = out.band();
+      for (size_t c = 0; c < a.num_col(); ++c)
+        for (size_t r = 0; r < nrow; ++r)
+          a(c, r) = float(out.band_begin() + c) + float(r);
+      out.commit();
+    }
+    out.close();
+  }
+
+  const float mp = float(ncol * nrow) / 1e6f;
+  std::band_reader<float> in(src, band);
+  float tio, tstream, tcompute;
+  {
+    std::band_writer<float> out(dst, ncol, nrow, band);
+    BENCH_TIME(std::transform_bands(in, out, copy), 1, tio)
+  }
+  {
+    std::band_writer<float> out(dst, ncol, nrow, band);
+    BENCH_TIME(std::transform_bands(in, out, kernel), 1, tstream)
+  }
+
+  // the same kernel on bands already in memory
+  std::vector2d<float> a(band, nrow, 1.f), b(band, nrow);
+  BENCH_TIME(for (size_t i = 0; i < in.num_bands(); ++i) kernel(a, b, 0), 1, tcompute)
+
+  // checks a few elements of the result
+  std::mapped_array2d<const float> check(dst);
+  bool ok = true;
+  for (size_t c = 0; c < ncol; c += 997)
+    ok = ok && std::abs(check(c, c % nrow) - std::sqrt(float(c + c % nrow) * float(c + c % nrow) + 1.f) * 0.5f) < 1e-2f;
+
+  std::cout << ncol << "x" << nrow << " floats in bands of " << band << " columns : "
+            << "i/o only " << tio << "ms (" << mp * 1e3f / tio << " MP/s), "
+            << "compute only " << tcompute << "ms, "
+            << "streamed " << tstream << "ms (" << mp * 1e3f / tstream << " MP/s)"
+            << " (check " << (ok ? "ok" : "failed") << ")" << std::endl;
+
+  check.close();
+  std::remove(src.c_str());
+  std::remove(dst.c_str());
+  return 0;
+}
@@ -0,0 +1,98 @@
+#include "array2d_transpose.h"
+#include "timer.h"
+
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+// element by element transposition through operator()
+template <typename T>
+void naive(const std::vector2d<T> &src, std::vector2d<T> &dst)
+{
+  for (size_t c = 0; c < src.num_col(); ++c)
+    for (size_t r = 0; r < src.num_row(); ++r)
+      dst(r, c) = src(c, r);
+}
+
+template <typename T>
+bool equal(const std::vector2d<T> &a, const std::vector2d<T> &b)
+{
+  if (a.num_col() != b.num_col() || a.num_row() != b.num_row())
+    return false;
+  for (size_t c = 0; c < a.num_col(); ++c)
+    for (size_t r = 0; r < a.num_row(); ++r)
+      if (a(c, r) != b(c, r))
+        return false;
+  return true;
+}
+
+// compares transpose, transpose_inplace and the row major conversions with naive on a
+// nc x nr array, padded when pad > 0
+template <typename T>
+bool check(size_t nc, size_t nr, size_t pad)
+{
+  std::vector2d<T> a = std::vector2d<T>::pitched(nc, nr, nr + pad), ref(nr, nc), b;
+  std::iota(a.begin(), a.end(), T(1));
+  naive(a, ref);
+
+  std::transpose(a, b);
+  bool ok = equal(b, ref);
+
+  std::vector<T> rm(nc * nr);
+  std::vector2d<T> back = std::vector2d<T>::pitched(nc, nr, nr + pad);
+  std::to_row_major(a, rm.data());
+  std::from_row_major(rm.data(), back);
+  for (size_t c = 0; c < nc; ++c)
+    for (size_t r = 0; r < nr; ++r)
+      ok = ok && rm[r * nc + c] == a(c, r);
+  ok = ok && equal(back, a);
+
+  if (nc == nr)
+  {
+    std::transpose_inplace(a);
+    ok = ok && equal(a, ref);
+  }
+  return ok;
+}
+
+int main(int argc, char **argv)
+{
+  // sizes around and between multiples of the 16 x 16 tile and of the 4 x 4 SSE blocks
+  const size_t dims[] = {1, 3, 4, 15, 16, 17, 33, 100};
+  bool ok = true;
+  for (size_t nc : dims)
+    for (size_t nr : dims)
+      for (size_t pad : {0, 5})
+        ok = ok && check<float>(nc, nr, pad) && check<double>(nc, nr, pad);
+  ok = ok && check<float>(257, 257, 0) && check<float>(130, 1000, 3);
+  std::cout << "transpose, transpose_inplace and row major conversions against naive : " << (ok ? "ok" : "failed") << std::endl;
+
+  const size_t sizes[] = {256, 1024, 2048, 4096};
+  for (size_t n : sizes)
+  {
+    std::vector2d<float> a(n, n), b(n, n);
+    std::iota(a.begin(), a.end(), 0.f);
+
+    // bytes read and written by one transposition
+    const float gb = 2.f * n * n * sizeof(float) / 1e9f;
+
+    std::vector2d<float> ref(n, n), c;
+    naive(a, ref);
+
+    float tnaive, ttiled, tinplace;
+    BENCH_TIME(naive(a, b), 10, tnaive)
+    BENCH_TIME(std::transpose(a, b), 10, ttiled)
+    BENCH_TIME(std::transpose_inplace(a), 10, tinplace)
+
+    // an even number of in place transpositions leaves a unchanged
+    std::transpose(a, c);
+    const bool same = equal(b, ref) && equal(c, ref);
+
+    std::cout << n << "x" << n << " : naive " << gb / (tnaive * 1e-3f) << "GB/s"
+              << ", tiled " << gb / (ttiled * 1e-3f) << "GB/s"
+              << ", in place " << gb / (tinplace * 1e-3f) << "GB/s"
+              << " (check " << (same ? "ok" : "failed") << ")" << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,100 @@
+#include "attributes.h"
+#include "timer.h"
+
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+
+// the lookup of a hash map of names followed by a dynamic_cast
+template <class T>
+AttributeArray<T> *map_lookup(const std::unordered_map<std::string, BaseAttributeArray *> &dict, const std::string &name)
+{
+  auto it = dict.find(name);
+  return (it == dict.end()) ? nullptr : dynamic_cast<AttributeArray<T> *>(it->second);
+}
+
+int main(int argc, char **argv)
+{
+  const size_t n_attributes = 20;
+  const size_t n_lookups = 1000000;
+
+  ElementAttributeList list(16);
+  std::unordered_map<std::string, BaseAttributeArray *> dict;
+  std::vector<std::string> names;
+  for (size_t i = 0; i < n_attributes; ++i)
+  {
+    names.push_back("attribute_" + std::to_string(i));
+    list.add<float>(names.back(), float(i));
+    dict[names.back()] = list.array(list.handle<float>(names.back()));
+  }
+
+  std::vector<AttributeHandle<float>> handles;
+  for (const std::string &name : names)
+    handles.push_back(list.handle<float>(name));
+
+  // each lookup reads one element so that it is not optimized away
+  float sum_map = 0.f, sum_name = 0.f, sum_handle = 0.f;
+  float tmap, tname, thandle;
+  BENCH_TIME(for (size_t i = 0; i < n_lookups; ++i) sum_map += (*map_lookup<float>(dict, names[i % n_attributes]))[0], 5, tmap)
+  BENCH_TIME(for (size_t i = 0; i < n_lookups; ++i) sum_name += list.get<float>(names[i % n_attributes])[0], 5, tname)
+  BENCH_TIME(for (size_t i = 0; i < n_lookups; ++i) sum_handle += list.get(handles[i % n_attributes])[0], 5, thandle)
+
+  std::cout << n_attributes << " attributes, " << n_lookups << " lookups" << std::endl;
+  std::cout << "  unordered_map + dynamic_cast : " << tmap * 1e6f / float(n_lookups) << " ns/lookup (" << sum_map << ")" << std::endl;
+  std::cout << "  get<T>(name)                 : " << tname * 1e6f / float(n_lookups) << " ns/lookup (" << sum_name << ")" << std::endl;
+  std::cout << "  get(handle)                  : " << thandle * 1e6f / float(n_lookups) << " ns/lookup (" << sum_handle << ")" << std::endl;
+
+  // growth of all the attributes by a million elements
+  const size_t n_elements = 1000000;
+  std::vector<float> values(n_elements, 1.f);
+  // the handles of a list are not valid for its copies
+  auto make_spans = [&](const ElementAttributeList &l) {
+    std::vector<AttributeSpan> spans;
+    for (const std::string &name : names)
+      spans.emplace_back(l.handle<float>(name), values.data());
+    return spans;
+  };
+
+  float tone, tbulk, tspans;
+  BENCH_TIME(ElementAttributeList grown(list); for (size_t i = 0; i < n_elements; ++i) grown.append(1), 3, tone)
+  BENCH_TIME(ElementAttributeList grown(list); grown.append(n_elements), 3, tbulk)
+  BENCH_TIME(ElementAttributeList grown(list); grown.append(n_elements, make_spans(grown)), 3, tspans)
+
+  std::cout << "appending " << n_elements << " elements" << std::endl;
+  std::cout << "  one at a time      : " << tone << " ms" << std::endl;
+  std::cout << "  append(n)          : " << tbulk << " ms" << std::endl;
+  std::cout << "  append(n, spans)   : " << tspans << " ms" << std::endl;
+
+  // deletion of every 10th element
+  ElementAttributeList big(list);
+  big.append(n_elements);
+
+  float tswap, tcompact;
+  BENCH_TIME(ElementAttributeList l(big); for (size_t i = l.size() - l.size() % 10; i > 0; i -= 10) l.swap_and_pop(i - 10), 3, tswap)
+  BENCH_TIME(ElementAttributeList l(big); for (size_t i = 0; i < l.size(); i += 10) l.mark_deleted(i); l.compact(), 3, tcompact)
+
+  std::cout << "deleting " << n_elements / 10 << " elements" << std::endl;
+  std::cout << "  swap_and_pop       : " << tswap << " ms" << std::endl;
+  std::cout << "  mark + compact     : " << tcompact << " ms (order preserved)" << std::endl;
+
+  // reordering by a random key
+  std::mt19937 gen(0);
+  AttributeHandle<uint32_t> hkey = big.add_handle<uint32_t>("key");
+  for (uint32_t &k : big.get(hkey).vector())
+    k = gen();
+
+  std::vector<size_t> perm(big.size());
+  float tstd, tperm, tsort;
+  BENCH_TIME(std::iota(perm.begin(), perm.end(), size_t(0)); std::stable_sort(perm.begin(), perm.end(), [&](size_t a, size_t b) { return big.get(hkey)[a] < big.get(hkey)[b]; }), 3, tstd)
+  BENCH_TIME(ElementAttributeList l(big); l.apply_permutation(perm), 3, tperm)
+  BENCH_TIME(ElementAttributeList l(big); l.sort_by<uint32_t>("key"), 3, tsort)
+
+  std::cout << "sorting " << big.size() << " elements by a uint32 key" << std::endl;
+  std::cout << "  std::stable_sort   : " << tstd << " ms (permutation only)" << std::endl;
+  std::cout << "  apply_permutation  : " << tperm << " ms" << std::endl;
+  std::cout << "  sort_by            : " << tsort << " ms (radix sort + apply_permutation)" << std::endl;
+
+  return 0;
+}
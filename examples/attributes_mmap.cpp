@@ -0,0 +1,38 @@
+#include "attributes_mmap.h"
+#include "timer.h"
+
+#include <cstdio>
+#include <iostream>
+
+int main(int argc, char **argv)
+{
+  const size_t n_attributes = 20;
+  const size_t n_elements = 2000000;
+  const std::string path = "_attributes_mmap.attr";
+
+  ElementAttributeList list(n_elements);
+  for (size_t i = 0; i < n_attributes; ++i)
+    list.add<float>("attribute_" + std::to_string(i), float(i));
+
+  const float mb = float(n_attributes * n_elements * sizeof(float)) / float(1 << 20);
+
+  float twrite, topen, tsum, tcopy;
+  BENCH_TIME(write_attributes(list, path), 3, twrite)
+  BENCH_TIME(MappedAttributeList file(path), 10, topen)
+
+  // the first sum loads the pages of the column
+  MappedAttributeList file(path);
+  double sum = 0.0;
+  BENCH_TIME(for (float x : file.get<float>("attribute_7")) sum += x, 3, tsum)
+  BENCH_TIME(ElementAttributeList copy = file.to_list(), 3, tcopy)
+
+  std::cout << n_attributes << " attributes, " << n_elements << " elements (" << mb << " MB)" << std::endl;
+  std::cout << "  write_attributes   : " << twrite << " ms, " << mb / twrite * 1e3f << " MB/s" << std::endl;
+  std::cout << "  open (mmap)        : " << topen << " ms" << std::endl;
+  std::cout << "  sum of one column  : " << tsum << " ms (" << sum << ")" << std::endl;
+  std::cout << "  to_list (copy)     : " << tcopy << " ms, " << mb / tcopy * 1e3f << " MB/s" << std::endl;
+
+  file.close();
+  std::remove(path.c_str());
+  return 0;
+}
@@ -0,0 +1,80 @@
+#include "compressed_array2d.h"
+#include "timer.h"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+
+template <typename T, size_t TILE = 64>
+void bench(const char *name, const std::vector2d<T> &src)
+{
+  const size_t nc = src.num_col(), nr = src.num_row();
+
+  float tcomp, tdecomp;
+  typedef std::compressed_array2d<T, TILE> compressed;
+  compressed c;
+  BENCH_TIME(c = compressed(src), 3, tcomp)
+  std::vector2d<T> out;
+  BENCH_TIME(c.to_dense(out), 3, tdecomp)
+
+  bool ok = true;
+  for (size_t i = 0; i < src.num() && ok; ++i)
+    ok = std::memcmp(&src.data()[i], &out.data()[i], sizeof(T)) == 0;
+
+  // random accesses, uniformly over the array or along a random walk
+  const size_t nq = 200000;
+  std::mt19937 gen(1);
+  std::vector<std::array<size_t, 2>> uniform(nq), walk(nq);
+  size_t wc = nc / 2, wr = nr / 2;
+  for (size_t i = 0; i < nq; ++i)
+  {
+    uniform[i] = {gen() % nc, gen() % nr};
+    wc = std::min(nc - 1, std::max<size_t>(1, wc) + gen() % 3 - 1);
+    wr = std::min(nr - 1, std::max<size_t>(1, wr) + gen() % 3 - 1);
+    walk[i] = {wc, wr};
+  }
+
+  double s = 0.;
+  float tdense, tuniform, twalk;
+  BENCH_TIME(for (const auto &q : uniform) s += double(src(q[0], q[1])), 3, tdense)
+  BENCH_TIME(for (const auto &q : uniform) s += double(c(q[0], q[1])), 1, tuniform)
+  BENCH_TIME(for (const auto &q : walk) s += double(c(q[0], q[1])), 3, twalk)
+
+  std::cout << name << " " << nc << "x" << nr << ", " << TILE << "x" << TILE << " tiles : ratio " << c.compression_ratio()
+            << " (" << src.num() * sizeof(T) / (1 << 20) << "MB -> " << c.compressed_bytes() / (1 << 20) << "MB, "
+            << c.memory() / (1 << 20) << "MB in memory)"
+            << ", compress " << tcomp << "ms, decompress " << tdecomp << "ms (check " << (ok ? "ok" : "failed") << ")" << std::endl
+            << "  random access latency : dense " << tdense * 1e6f / nq << "ns"
+            << ", uniform " << tuniform * 1e6f / nq << "ns"
+            << ", random walk " << twalk * 1e6f / nq << "ns" << (s == 0. ? " " : "") << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  const size_t n = 4096;
+  std::mt19937 gen(0);
+  std::normal_distribution<float> noise(0.f, 1.f);
+
+  // smooth terrain, quantized to centimeters as int32 and to decimeters as int16
+  std::vector2d<float> smooth(n, n), noisy(n, n);
+  std::vector2d<int32_t> dem32(n, n);
+  std::vector2d<int16_t> dem16(n, n);
+  for (size_t c = 0; c < n; ++c)
+    for (size_t r = 0; r < n; ++r)
+    {
+      const float x = float(c) / float(n), y = float(r) / float(n);
+      const float h = 800.f * std::sin(3.f * x) * std::cos(5.f * y) + 200.f * std::sin(17.f * x * y);
+      smooth(c, r) = h;
+      noisy(c, r) = h + noise(gen);
+      dem32(c, r) = int32_t(std::lround(h * 100.f));
+      dem16(c, r) = int16_t(std::lround(h * 10.f));
+    }
+
+  bench("int16 smooth", dem16);
+  bench("int32 smooth", dem32);
+  bench<int32_t, 32>("int32 smooth", dem32);
+  bench("float smooth", smooth);
+  bench("float noisy ", noisy);
+
+  return 0;
+}
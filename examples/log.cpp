@@ -1,7 +1,9 @@
 #include "log.h"
 #include <iostream>
 
+#if defined _WIN32
 #include <windows.h>
+#endif
 
 int main(int argc, char **argv)
 {
@@ -0,0 +1,104 @@
+#include "array2d_gemm.h"
+#include "sparse_array2d.h"
+#include "timer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <tuple>
+#include <vector>
+
+// largest absolute difference between two vectors
+float max_error(const std::vector<float> &a, const std::vector<float> &b)
+{
+  float e = 0.f;
+  for (size_t i = 0; i < a.size(); ++i)
+    e = std::max(e, std::abs(a[i] - b[i]));
+  return e;
+}
+
+// largest absolute difference between a sparse array and a dense one
+float max_error(const std::sparse_array2d<float> &s, const std::vector2d<float> &d)
+{
+  std::vector2d<float> back = s.to_dense();
+  float e = 0.f;
+  for (size_t c = 0; c < d.num_col(); ++c)
+    for (size_t r = 0; r < d.num_row(); ++r)
+      e = std::max(e, std::abs(back(c, r) - d(c, r)));
+  return e;
+}
+
+int main(int argc, char **argv)
+{
+  std::cout << "threads : " << ThreadPool::global().num_threads() << std::endl;
+
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+
+  const size_t n = 4096;
+  const float densities[] = {0.001f, 0.01f, 0.05f};
+  for (float density : densities)
+  {
+    // random field with about density * n * n non-zeros
+    std::vector2d<float> dense(n, n, 0.f);
+    const size_t count = size_t(density * n * n);
+    for (size_t i = 0; i < count; ++i)
+      dense(gen() % n, gen() % n) = dist(gen);
+
+    std::sparse_array2d<float> sparse;
+    float tconv, tback, tbuild;
+    BENCH_TIME(sparse = std::sparse_array2d<float>(dense), 5, tconv)
+    BENCH_TIME(sparse.to_dense(dense), 5, tback)
+
+    std::sparse_array2d<float>::builder b(n, n);
+    BENCH_TIME(
+        {
+          b.reserve(count);
+          for (size_t i = 0; i < count; ++i)
+            b.add(gen() % n, gen() % n, 1.f);
+          sparse = b.build();
+        },
+        5, tbuild)
+    sparse = std::sparse_array2d<float>(dense);
+    const float econv = max_error(sparse, dense);
+
+    // the non-zeros of dense in random order, each one split into two halves at the same position
+    std::vector<std::tuple<size_t, size_t, float>> triplets;
+    for (size_t c = 0; c < n; ++c)
+      for (size_t r = 0; r < n; ++r)
+        if (dense(c, r) != 0.f)
+        {
+          triplets.emplace_back(c, r, 0.5f * dense(c, r));
+          triplets.emplace_back(c, r, 0.5f * dense(c, r));
+        }
+    std::shuffle(triplets.begin(), triplets.end(), gen);
+    for (const auto &t : triplets)
+      b.add(std::get<0>(t), std::get<1>(t), std::get<2>(t));
+    const std::sparse_array2d<float> built = b.build();
+    const float ebuild = max_error(built, dense);
+
+    std::vector<float> x(n), y(n), yt(n), yd(n), ytd(n, 0.f);
+    for (auto &v : x)
+      v = dist(gen);
+
+    float tspmv, tspmvt, tgemv;
+    BENCH_TIME(sparse.multiply(x, y), 20, tspmv)
+    BENCH_TIME(sparse.multiply_transposed(x, yt), 20, tspmvt)
+    BENCH_TIME(std::gemm(n, 1, n, 1.f, dense.data(), dense.ld(), x.data(), n, 0.f, yd.data(), n), 5, tgemv)
+
+    // y = A^T x on the dense array, one dot product per column
+    for (size_t c = 0; c < n; ++c)
+      for (size_t r = 0; r < n; ++r)
+        ytd[c] += dense(c, r) * x[r];
+
+    std::cout << n << "x" << n << " density " << density << " : " << sparse.nnz() << " non-zeros, "
+              << sparse.memory() / (1 << 20) << "MB (dense " << n * n * sizeof(float) / (1 << 20) << "MB)" << std::endl
+              << "  from/to dense " << tconv << "/" << tback << "ms (max error " << econv << "), builder " << tbuild
+              << "ms (unsorted with duplicates, max error " << ebuild << ")" << std::endl
+              << "  y = A x " << tspmv << "ms (max error " << max_error(y, yd) << "), y = A^T x " << tspmvt
+              << "ms (max error " << max_error(yt, ytd) << "), dense gemv " << tgemv << "ms" << std::endl;
+  }
+
+  return 0;
+}
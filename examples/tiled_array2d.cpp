@@ -0,0 +1,163 @@
+#include "tiled_array2d.h"
+#include "timer.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// 5 point laplacian over the interior of the array, visiting it in B x B blocks
+template <size_t B, typename A>
+void laplacian(const A &in, A &out)
+{
+  const size_t nc = in.num_col() - 1;
+  const size_t nr = in.num_row() - 1;
+  for (size_t c0 = 1; c0 < nc; c0 += B)
+    for (size_t r0 = 1; r0 < nr; r0 += B)
+      for (size_t c = c0; c < std::min(c0 + B, nc); ++c)
+        for (size_t r = r0; r < std::min(r0 + B, nr); ++r)
+          out(c, r) = in(c - 1, r) + in(c + 1, r) + in(c, r - 1) + in(c, r + 1) - 4.f * in(c, r);
+}
+
+// 5 point laplacian of one column of a tile, l and p being the neighboring columns : the rows
+// above and below the tile are in the previous and next tiles of the same tile column
+template <size_t TILE>
+inline void laplacian_column(const float *__restrict l, const float *__restrict m, const float *__restrict p, float *__restrict o)
+{
+  constexpr size_t TE = TILE * TILE;
+  const float *up = m - 1;
+  const float *down = m + 1;
+  for (size_t r = 0; r < TILE; ++r)
+    o[r] = l[r] + p[r] + up[r] + down[r] - 4.f * m[r];
+  o[0] = l[0] + p[0] + *(m - TE + TILE - 1) + m[1] - 4.f * m[0];
+  o[TILE - 1] = l[TILE - 1] + p[TILE - 1] + m[TILE - 2] + m[TE] - 4.f * m[TILE - 1];
+}
+
+// 5 point laplacian over the interior of a tiled array, one tile at a time and one vectorized
+// column at a time, reading the neighbors directly in the tiles
+template <size_t TILE>
+void laplacian_tiled(const std::tiled_array2d<float, TILE> &in, std::tiled_array2d<float, TILE> &out)
+{
+  constexpr size_t TE = TILE * TILE;
+  const size_t stride = in.tile_stride();
+  // the first columns of the next tile column are not read sequentially, they are prefetched ~2KB ahead
+  const size_t ahead = std::max<size_t>(1, 2048 / (TE * sizeof(float))) * TE;
+
+  const size_t nc = in.num_col();
+  const size_t nr = in.num_row();
+  for (size_t tc = 0; tc < in.num_tile_col(); ++tc)
+    for (size_t tr = 0; tr < in.num_tile_row(); ++tr)
+    {
+      const size_t c0 = tc * TILE;
+      const size_t r0 = tr * TILE;
+      if (c0 > 0 && r0 > 0 && c0 + TILE < nc && r0 + TILE < nr)
+      {
+        const float *t = in.tile(tc, tr);
+        float *o = out.tile(tc, tr);
+        __builtin_prefetch(t + stride + ahead);
+
+        laplacian_column<TILE>(t - stride + TE - TILE, t, t + TILE, o);
+        for (size_t c = 1; c + 1 < TILE; ++c)
+          laplacian_column<TILE>(t + (c - 1) * TILE, t + c * TILE, t + (c + 1) * TILE, o + c * TILE);
+        laplacian_column<TILE>(t + TE - 2 * TILE, t + TE - TILE, t + stride, o + TE - TILE);
+      }
+      else
+      {
+        // tiles on the border of the array
+        for (size_t c = std::max<size_t>(c0, 1); c < std::min(c0 + TILE, nc - 1); ++c)
+          for (size_t r = std::max<size_t>(r0, 1); r < std::min(r0 + TILE, nr - 1); ++r)
+            out(c, r) = in(c - 1, r) + in(c + 1, r) + in(c, r - 1) + in(c, r + 1) - 4.f * in(c, r);
+      }
+    }
+}
+
+// sums of the 3x3 neighborhoods of random locations
+template <typename A>
+float neighborhoods(const A &in, const std::vector<std::pair<size_t, size_t>> &queries)
+{
+  float s = 0.f;
+  for (const auto &q : queries)
+    for (size_t c = q.first - 1; c <= q.first + 1; ++c)
+      for (size_t r = q.second - 1; r <= q.second + 1; ++r)
+        s += in(c, r);
+  return s;
+}
+
+// same on a tiled array : when the neighborhood lies in a single tile, its elements are read
+// at fixed offsets from the center, the tile being column major
+template <size_t TILE>
+float neighborhoods_tiled(const std::tiled_array2d<float, TILE> &in, const std::vector<std::pair<size_t, size_t>> &queries)
+{
+  float s = 0.f;
+  for (const auto &q : queries)
+  {
+    if ((q.first + 1) % TILE >= 2 && (q.second + 1) % TILE >= 2)
+    {
+      const float *p = &in(q.first, q.second) - TILE - 1;
+      for (size_t c = 0; c < 3; ++c)
+        for (size_t r = 0; r < 3; ++r)
+          s += p[c * TILE + r];
+    }
+    else
+      for (size_t c = q.first - 1; c <= q.first + 1; ++c)
+        for (size_t r = q.second - 1; r <= q.second + 1; ++r)
+          s += in(c, r);
+  }
+  return s;
+}
+
+template <size_t TILE>
+void bench_tiled(const std::vector2d<float> &src, const std::vector2d<float> &ref, const std::vector<std::pair<size_t, size_t>> &queries)
+{
+  std::tiled_array2d<float, TILE> in(src.num_col(), src.num_row()), out(src.num_col(), src.num_row());
+  std::vector2d<float> back(src.num_col(), src.num_row());
+
+  float tfrom, tto, tsweep, ttile, tquery, tfast, s = 0.f, sfast = 0.f;
+  BENCH_TIME(in.from_col_major(src), 5, tfrom)
+  BENCH_TIME(in.to_col_major(back), 5, tto)
+  BENCH_TIME(laplacian<TILE>(in, out), 5, tsweep)
+  BENCH_TIME(laplacian_tiled(in, out), 5, ttile)
+  BENCH_TIME(s += neighborhoods(in, queries), 5, tquery)
+  BENCH_TIME(sfast += neighborhoods_tiled(in, queries), 5, tfast)
+
+  // the per tile stencil must match the column major one on the interior
+  out.to_col_major(back);
+  bool ok = s == sfast;
+  for (size_t c = 1; c + 1 < src.num_col(); ++c)
+    for (size_t r = 1; r + 1 < src.num_row(); ++r)
+      ok = ok && back(c, r) == ref(c, r);
+
+  std::cout << "  tiled " << TILE << "x" << TILE << " : stencil " << tsweep << "ms (per tile " << ttile << "ms), queries " << tquery
+            << "ms (in tile " << tfast << "ms), from/to col major " << tfrom << "/" << tto << "ms (check " << (ok ? "ok" : "failed") << ")" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  std::mt19937 gen(0);
+  const size_t sizes[] = {1024, 2048, 4096};
+  for (size_t n : sizes)
+  {
+    std::vector2d<float> in(n, n), out(n, n);
+    std::uniform_real_distribution<float> dist(0.f, 1.f);
+    for (auto &v : in)
+      v = dist(gen);
+
+    std::uniform_int_distribution<size_t> loc(1, n - 2);
+    std::vector<std::pair<size_t, size_t>> queries(1 << 20);
+    for (auto &q : queries)
+      q = {loc(gen), loc(gen)};
+
+    float tsweep, tquery, s = 0.f;
+    BENCH_TIME(laplacian<1 << 30>(in, out), 5, tsweep)
+    BENCH_TIME(s += neighborhoods(in, queries), 5, tquery)
+
+    std::cout << n << "x" << n << std::endl;
+    std::cout << "  column major : stencil " << tsweep << "ms, queries " << tquery << "ms (check " << s << ")" << std::endl;
+
+    bench_tiled<4>(in, out, queries);
+    bench_tiled<8>(in, out, queries);
+    bench_tiled<16>(in, out, queries);
+  }
+
+  return 0;
+}
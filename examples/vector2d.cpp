@@ -0,0 +1,25 @@
+#include "vector2d.h"
+
+#include <iostream>
+#include <utility>
+
+int main(int argc, char **argv)
+{
+  std::vector2d<int> test(2, 3, {1, 2, 3, 4, 5, 6});
+
+  for (auto v : test)
+    std::cout << v << ", ";
+  std::cout << std::endl;
+
+  // wrap an existing buffer without copying it
+  int buffer[6] = {6, 5, 4, 3, 2, 1};
+  std::vector2d<int> view(buffer, 3, 2);
+  view(0, 1) = 0;
+  std::cout << buffer[1] << std::endl;
+
+  // moving does not copy the elements
+  std::vector2d<int> moved(std::move(test));
+  std::cout << moved.num_col() << "x" << moved.num_row() << " " << test.empty() << std::endl;
+
+  return 0;
+}
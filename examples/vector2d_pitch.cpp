@@ -0,0 +1,46 @@
+#include "vector2d.h"
+#include "timer.h"
+
+#include <iostream>
+
+// walks the array row by row, i.e. with a stride of ld() elements
+float row_walk(const std::vector2d<float> &a)
+{
+  float s = 0.f;
+  for (size_t r = 0; r < a.num_row(); ++r)
+    for (size_t c = 0; c < a.num_col(); ++c)
+      s += a(c, r);
+  return s;
+}
+
+// updates 8 consecutive rows at once, touching 8 cache lines per column
+void row_update(std::vector2d<float> &a)
+{
+  for (size_t r = 0; r + 8 <= a.num_row(); r += 8)
+    for (size_t c = 1; c < a.num_col(); ++c)
+      for (size_t k = 0; k < 8; ++k)
+        a(c, r + k) += 0.5f * a(c - 1, r + k);
+}
+
+int main(int argc, char **argv)
+{
+  const size_t sizes[] = {256, 512, 1024, 2048};
+  for (size_t n : sizes)
+  {
+    std::vector2d<float> dense(n, n, 1.f);
+    std::vector2d<float> pitched = std::vector2d<float>::pitched(n, n);
+    pitched.fill(1.f);
+
+    float s0 = 0.f, s1 = 0.f;
+    float twalk0, twalk1, tupdate0, tupdate1;
+    BENCH_TIME(s0 += row_walk(dense), 5, twalk0)
+    BENCH_TIME(s1 += row_walk(pitched), 5, twalk1)
+    BENCH_TIME(row_update(dense), 5, tupdate0)
+    BENCH_TIME(row_update(pitched), 5, tupdate1)
+
+    std::cout << n << "x" << n << " (ld " << pitched.ld() << ") : row walk " << twalk0 << "ms -> " << twalk1
+              << "ms, row update " << tupdate0 << "ms -> " << tupdate1 << "ms (check " << s0 - s1 << ")" << std::endl;
+  }
+
+  return 0;
+}
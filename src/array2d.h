@@ -27,6 +27,11 @@
 #define __ARRAY_2D__
 
 #include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+#include "array2d_view.h"
 
 /**
  * @Brief
@@ -36,13 +41,24 @@
  * -------
  * std::array2d<float, 2, 3> arr0 {1, 2, 3, 4, 5, 6};
  * std::array2d<float, 2, 3> arr2 {{1, 2, 3,}, {4, 5, 6}};
+ * 
+ * array2d is a literal type, tables can be computed at compile time:
+ * constexpr std::array2d<int, 2, 2> id = {1, 0, 0, 1};
+ * static_assert(id(1, 1) == 1);
+ * 
+ * The columns of an array2d are contiguous, as in a std::array. Columns padded to a pitch are
+ * provided by vector2d::pitched() (see vector2d.h).
  */
 
 //TODO
-// [ ] add an iterator over the elemets of a row
+// [x] add an iterator over the elemets of a row
 
 namespace std
 {
+  // element-wise expressions, see array2d_expr.h
+  template <typename E>
+  class array2d_expr;
+
   template <typename T, size_t COL, size_t ROW>
   class array2d
   {
@@ -69,29 +85,40 @@ namespace std
     //============================================
     //              Initialisation
     //============================================
-    array2d() = default;
-    array2d(const array2d &) = default;
-    array2d(array2d &&) = default;
+    constexpr array2d() = default;
+    constexpr array2d(const array2d &) = default;
+    constexpr array2d(array2d &&) = default;
 
-    virtual ~array2d() = default;
-
-    array2d(const std::initializer_list<T> &list)
+    // the elements are written through their index rather than with an iterator running over
+    // the whole array, which is not allowed to cross columns in constant expressions
+    constexpr array2d(const std::initializer_list<T> &list)
     {
-      iterator itr = begin();
+      size_t i = 0;
       for (const_reference l : list)
-        *itr++ = l;
+        (*this)(i++) = l;
     }
 
-    array2d(const std::initializer_list<std::initializer_list<T>> &list)
+    constexpr array2d(const std::initializer_list<std::initializer_list<T>> &list)
     {
-      iterator itr = begin();
+      size_t i = 0;
       for (const std::initializer_list<T> &col : list)
         for (const_reference l : col)
-          *itr++ = l;
+          (*this)(i++) = l;
     }
 
-    array2d &operator=(const array2d &) = default;
-    array2d &operator=(array2d &&) = default;
+    constexpr array2d &operator=(const array2d &) = default;
+    constexpr array2d &operator=(array2d &&) = default;
+
+    /**
+   * @Brief
+   * Evaluates an element-wise expression into the array in a single pass (see array2d_expr.h).
+  **/
+    template <typename E>
+    array2d &operator=(const array2d_expr<E> &expr)
+    {
+      expr.assign_to(*this);
+      return *this;
+    }
 
     //============================================
     //                Data Access
@@ -101,12 +128,12 @@ namespace std
    * Returns a reference to the element at specified location {col, row}, with bounds checking.
    * If {col, row} is not within the range of the container, an exception of type std::out_of_range is thrown.
   **/
-    reference at(size_t col, std::size_t row)
+    constexpr reference at(size_t col, std::size_t row)
     {
       return mData.at(col).at(row);
     }
 
-    const_reference at(size_t col, std::size_t row) const
+    constexpr const_reference at(size_t col, std::size_t row) const
     {
       return mData.at(col).at(row);
     }
@@ -118,7 +145,7 @@ namespace std
    * 
    * i is the index of the element in a column-major ordering.
   **/
-    reference at(size_t i)
+    constexpr reference at(size_t i)
     {
       std::size_t col = i / ROW;
       std::size_t row = i - col * ROW;
@@ -126,7 +153,7 @@ namespace std
       return at(col, row);
     }
 
-    const_reference at(size_t i) const
+    constexpr const_reference at(size_t i) const
     {
       std::size_t col = i / ROW;
       std::size_t row = i - col * ROW;
@@ -138,12 +165,12 @@ namespace std
    * @Brief
    * Returns a reference to the element at specified location {col, row}. No bounds checking is performed.
   **/
-    reference operator()(size_t col, size_t row) noexcept
+    constexpr reference operator()(size_t col, size_t row) noexcept
     {
       return mData[col][row];
     }
 
-    const_reference operator()(size_t col, size_t row) const noexcept
+    constexpr const_reference operator()(size_t col, size_t row) const noexcept
     {
       return mData[col][row];
     }
@@ -154,7 +181,7 @@ namespace std
    * 
    * i is the index of the element in a column-major ordering.
   **/
-    const_reference operator()(size_t i) const noexcept
+    constexpr const_reference operator()(size_t i) const noexcept
     {
       std::size_t col = i / ROW;
       std::size_t row = i - col * ROW;
@@ -162,7 +189,7 @@ namespace std
       return mData[col][row];
     }
 
-    reference operator()(size_t i) noexcept
+    constexpr reference operator()(size_t i) noexcept
     {
       std::size_t col = i / ROW;
       std::size_t row = i - col * ROW;
@@ -170,7 +197,7 @@ namespace std
       return mData[col][row];
     }
 
-    const_reference operator[](size_t i) const noexcept
+    constexpr const_reference operator[](size_t i) const noexcept
     {
       std::size_t col = i / ROW;
       std::size_t row = i - col * ROW;
@@ -182,12 +209,12 @@ namespace std
    * @Brief
    * Returns a reference to the first element in the container.
   **/
-    reference front()
+    constexpr reference front()
     {
       return at(0, 0);
     }
 
-    const_reference front() const
+    constexpr const_reference front() const
     {
       return at(0, 0);
     }
@@ -196,12 +223,12 @@ namespace std
    * @Brief
    * Returns a reference to the last element in the container.
   **/
-    reference back()
+    constexpr reference back()
     {
       return at(COL - 1, ROW - 1);
     }
 
-    const_reference back() const
+    constexpr const_reference back() const
     {
       return at(COL - 1, ROW - 1);
     }
@@ -211,13 +238,14 @@ namespace std
    * Returns pointer to the underlying array serving as element storage. 
    * The pointer is such that range [data(); data() + size()) is always a valid range, 
    * even if the container is empty (data() is not dereferenceable in that case).
+   * In constant expressions, only the elements of the first column can be read through data().
   **/
-    pointer data()
+    constexpr pointer data()
     {
       return mData.data()->data();
     }
 
-    const_pointer data() const
+    constexpr const_pointer data() const
     {
       return mData.data()->data();
     }
@@ -227,29 +255,62 @@ namespace std
    * Returns a reference to the ith column of the 2d array, with bounds checking.
    * If i is not within the range of the columns, an exception of type std::out_of_range is thrown.
   **/
-    column_type &col(size_t i)
+    constexpr column_type &col(size_t i)
     {
       return mData.at(i);
     }
 
-    const column_type &col(size_t i) const
+    constexpr const column_type &col(size_t i) const
     {
       return mData.at(i);
     }
 
+    /**
+   * @Brief
+   * Returns a view over the elements of the ith row (see array2d_view.h).
+   * If i is not within the range of the rows, an exception of type std::out_of_range is thrown.
+  **/
+    row_view<T> row(size_t i)
+    {
+      return row_view<T>(*this, i);
+    }
+
+    row_view<const T> row(size_t i) const
+    {
+      return row_view<const T>(*this, i);
+    }
+
+    /**
+   * @Brief
+   * Returns a view over the nc x nr block starting at {c0, r0} (see array2d_view.h).
+   * If the block is not within the range of the array, an exception of type std::out_of_range is thrown.
+  **/
+    block_view<T> block(size_t c0, size_t r0, size_t nc, size_t nr)
+    {
+      return block_view<T>(*this, c0, r0, nc, nr);
+    }
+
+    block_view<const T> block(size_t c0, size_t r0, size_t nc, size_t nr) const
+    {
+      return block_view<const T>(*this, c0, r0, nc, nr);
+    }
+
     //============================================
     //                iterators
     //============================================
     /**
    * @Brief
    * Returns an iterator to the first element of the array.
+   * 
+   * In constant expressions an iterator cannot move from one column to the next,
+   * use begin_col / end_col or the indices instead.
   **/
-    iterator begin() noexcept
+    constexpr iterator begin() noexcept
     {
       return mData.front().begin();
     }
 
-    const_iterator begin() const noexcept
+    constexpr const_iterator begin() const noexcept
     {
       return mData.front().begin();
     }
@@ -258,12 +319,12 @@ namespace std
    * @Brief
    * Returns an iterator to the last element of the array.
   **/
-    iterator end() noexcept
+    constexpr iterator end() noexcept
     {
       return mData.back().end();
     }
 
-    const_iterator end() const noexcept
+    constexpr const_iterator end() const noexcept
     {
       return mData.back().end();
     }
@@ -273,12 +334,12 @@ namespace std
    * Returns an iterator to the first element of the ith coloum.
    * If i is not within the range of the columns, an exception of type std::out_of_range is thrown.
   **/
-    iterator begin_col(size_t i)
+    constexpr iterator begin_col(size_t i)
     {
       return mData.at(i).begin();
     }
 
-    const_iterator begin_col(size_t i) const
+    constexpr const_iterator begin_col(size_t i) const
     {
       return mData.at(i).begin();
     }
@@ -291,12 +352,12 @@ namespace std
    * if i is the last column, than it is equal to end().
    * if i is not the last columns, that is is the equal to begin_col(i+1)
   **/
-    iterator end_col(size_t i)
+    constexpr iterator end_col(size_t i)
     {
       return mData.at(i).end();
     }
 
-    const_iterator end_col(size_t i) const
+    constexpr const_iterator end_col(size_t i) const
     {
       return mData.at(i).end();
     }
@@ -308,44 +369,44 @@ namespace std
    * @Brief
    * Returns the 2d size of the array.
   **/
-    inline size_type size() const noexcept { return {COL, ROW}; }
+    constexpr size_type size() const noexcept { return {COL, ROW}; }
 
     /**
    * @Brief
    * Returns the size of a column.
   **/
-    inline size_t size_col() const noexcept { return ROW; }
+    constexpr size_t size_col() const noexcept { return ROW; }
 
     /**
    * @Brief
    * Returns the size of a row.
   **/
-    inline size_t size_row() const noexcept { return COL; }
+    constexpr size_t size_row() const noexcept { return COL; }
 
     /**
    * @Brief
    * Returns the number of elements in the 2d array.
   **/
-    inline size_t num() const noexcept { return COL * ROW; }
-    inline size_t max_size() const noexcept { return COL * ROW; }
+    constexpr size_t num() const noexcept { return COL * ROW; }
+    constexpr size_t max_size() const noexcept { return COL * ROW; }
 
     /**
    * @Brief
    * Returns the number of columns.
   **/
-    inline size_t num_col() const noexcept { return COL; }
+    constexpr size_t num_col() const noexcept { return COL; }
 
     /**
    * @Brief
    * Returns the number of row.
   **/
-    inline size_t num_row() const noexcept { return ROW; }
+    constexpr size_t num_row() const noexcept { return ROW; }
 
     /**
    * @Brief
    * checks whether the number of elemets is 0.
   **/
-    inline bool empty() const noexcept { return num() == 0; }
+    constexpr bool empty() const noexcept { return num() == 0; }
 
     //============================================
     //                operations
@@ -354,17 +415,71 @@ namespace std
    * @Brief
    * Assigns the given value value to all elements in the array.
   **/
-    void fill(const T &value)
+    constexpr void fill(const T &value)
     {
-      iterator itr = begin();
-      iterator finish = end();
-      while (itr != finish)
-        *itr++ = value;
+      for (size_t c = 0; c < COL; ++c)
+        for (size_t r = 0; r < ROW; ++r)
+          mData[c][r] = value;
+    }
+
+    /**
+   * @Brief
+   * Copies the n first elements of src into the array, in column-major order.
+   * If n is larger than the number of elements, an exception of type std::length_error is thrown.
+  **/
+    void assign(const_pointer src, size_t n)
+    {
+      if (n > num())
+        throw std::length_error("array2d::assign");
+      detail::bulk_copy(src, n, data());
+    }
+
+    /**
+   * @Brief
+   * Copies the elements from a strided buffer: element {col, row} is read from src[col * col_stride + row * row_stride].
+   * A row-major buffer has a col_stride of 1 and a row_stride of num_col().
+  **/
+    void assign(const_pointer src, std::ptrdiff_t col_stride, std::ptrdiff_t row_stride)
+    {
+      detail::strided_copy(COL, ROW, src, col_stride, row_stride, data(), std::ptrdiff_t(ROW), 1);
+    }
+
+    /**
+   * @Brief
+   * Copies the elements of the array into dst, in column-major order. dst must hold at least num() elements.
+  **/
+    void copy_to(pointer dst) const
+    {
+      detail::bulk_copy(data(), num(), dst);
+    }
+
+    /**
+   * @Brief
+   * Copies the elements of the array into a strided buffer: element {col, row} is written to dst[col * col_stride + row * row_stride].
+  **/
+    void copy_to(pointer dst, std::ptrdiff_t col_stride, std::ptrdiff_t row_stride) const
+    {
+      detail::strided_copy(COL, ROW, data(), std::ptrdiff_t(ROW), 1, dst, col_stride, row_stride);
+    }
+
+    /**
+   * @Brief
+   * Exchanges the elements of the container with those of other.
+  **/
+    void swap(array2d &other) noexcept(std::is_nothrow_swappable<T>::value)
+    {
+      mData.swap(other.mData);
     }
 
   protected:
-    data_type mData;
+    data_type mData{};
   };
+
+  template <typename T, size_t COL, size_t ROW>
+  inline void swap(array2d<T, COL, ROW> &a, array2d<T, COL, ROW> &b) noexcept(noexcept(a.swap(b)))
+  {
+    a.swap(b);
+  }
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,413 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __ARRAY_2D_ALGORITHM__
+#define __ARRAY_2D_ALGORITHM__
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "array2d.h"
+#include "array2d_expr.h"
+#include "array2d_view.h"
+#include "parallel.h"
+#include "vector2d.h"
+
+/**
+ * @Brief
+ * Element-wise algorithms over 2d arrays (array2d, vector2d and block views) with execution policies.
+ * 
+ * The array is cut into tiles of whole column segments, about 16K elements each, which are walked
+ * with a pointer per column : the position {col, row} of an element is known without the division
+ * done by the linear operator()(i).
+ * 
+ * policies:
+ * --------
+ * execution2d::seq       : the tiles are processed in order by the calling thread.
+ * execution2d::par       : the tiles are processed by the global thread pool, balanced by stealing,
+ *                          f is called concurrently and must be thread safe.
+ * execution2d::par_unseq : as par, and the calls within a column may be interleaved (vectorized),
+ *                          f must then not synchronize nor depend on the order of the calls.
+ * 
+ * transform_reduce combines the partial results of the tiles in tile order, whatever the policy,
+ * so that its result does not depend on the scheduling. As for std::transform_reduce, the
+ * reduction must be associative and commutative.
+ * 
+ * example:
+ * -------
+ * std::vector2d<float> a(4096, 4096), b(4096, 4096);
+ * std::for_each_index(std::execution2d::par, a, [](size_t c, size_t r, float &x) { x = float(c + r); });
+ * std::transform(std::execution2d::par_unseq, a, b, [](float x) { return x * x; });
+ * double s = std::transform_reduce(std::execution2d::par, a, 0.0, std::plus<>(), [](float x) { return double(x); });
+ */
+
+namespace std
+{
+  //============================================
+  //              Execution Policies
+  //============================================
+  namespace execution2d
+  {
+    struct sequenced_policy
+    {
+    };
+
+    struct parallel_policy
+    {
+    };
+
+    struct parallel_unsequenced_policy
+    {
+    };
+
+    inline constexpr sequenced_policy seq{};
+    inline constexpr parallel_policy par{};
+    inline constexpr parallel_unsequenced_policy par_unseq{};
+  }
+
+  template <typename P>
+  struct is_execution_policy2d : std::false_type
+  {
+  };
+
+  template <>
+  struct is_execution_policy2d<execution2d::sequenced_policy> : std::true_type
+  {
+  };
+
+  template <>
+  struct is_execution_policy2d<execution2d::parallel_policy> : std::true_type
+  {
+  };
+
+  template <>
+  struct is_execution_policy2d<execution2d::parallel_unsequenced_policy> : std::true_type
+  {
+  };
+
+  namespace detail
+  {
+    template <typename P>
+    using enable_policy2d = std::enable_if_t<is_execution_policy2d<std::decay_t<P>>::value>;
+
+    template <typename P>
+    using is_unseq2d = std::is_same<std::decay_t<P>, execution2d::parallel_unsequenced_policy>;
+
+    // number of elements per tile, and maximal number of rows of a tile
+    constexpr size_t algorithm_tile = 1 << 14;
+    constexpr size_t algorithm_tile_row = 1 << 12;
+
+    // tiles per thread for the parallel policies, more tiles balance better but cost more tasks
+    constexpr size_t algorithm_tiles_per_thread = 8;
+
+    // cuts nc x nr elements in tiles of tc columns and tr rows, the tiles being numbered column of tiles first
+    struct tile_grid
+    {
+      tile_grid(size_t nc, size_t nr) noexcept
+          : nc(nc), nr(nr), tr(std::max<size_t>(1, std::min(nr, algorithm_tile_row))),
+            tc(std::max<size_t>(1, algorithm_tile / tr)), ntr((nr + tr - 1) / tr)
+      {
+      }
+
+      inline size_t num() const noexcept { return (nc + tc - 1) / tc * ntr; }
+
+      // calls f(c0, c1, r0, r1) with the bounds of the tile t
+      template <typename F>
+      inline void visit(size_t t, F &f) const
+      {
+        const size_t c0 = (t / ntr) * tc;
+        const size_t r0 = (t % ntr) * tr;
+        f(c0, std::min(c0 + tc, nc), r0, std::min(r0 + tr, nr));
+      }
+
+      size_t nc, nr; // dimensions of the array
+      size_t tr, tc; // dimensions of a tile
+      size_t ntr;    // number of tiles along a column
+    };
+
+    // calls f(c0, c1, r0, r1) on every tile of a nc x nr array, following the policy
+    template <typename P, typename F>
+    void for_each_tile(size_t nc, size_t nr, F &&f)
+    {
+      if (nc == 0 || nr == 0)
+        return;
+
+      const tile_grid g(nc, nr);
+      const size_t n = g.num();
+      if constexpr (std::is_same<std::decay_t<P>, execution2d::sequenced_policy>::value)
+      {
+        for (size_t t = 0; t < n; ++t)
+          g.visit(t, f);
+      }
+      else
+      {
+        const size_t grain = std::max<size_t>(1, n / (algorithm_tiles_per_thread * ThreadPool::global().num_threads()));
+        parallel_for_dynamic(0, n, grain, [&](size_t begin, size_t end) {
+          for (size_t t = begin; t < end; ++t)
+            g.visit(t, f);
+        });
+      }
+    }
+
+    // resizes a vector2d destination to nc x nr, otherwise checks its dimensions
+    template <typename B>
+    void algorithm_prepare(B &dst, size_t nc, size_t nr, const char *what)
+    {
+      if constexpr (std::is_same<std::decay_t<B>, vector2d<typename std::decay_t<B>::value_type>>::value)
+      {
+        if (dst.num_col() != nc || dst.num_row() != nr)
+          dst.resize(nc, nr);
+      }
+
+      if (dst.num_col() != nc || dst.num_row() != nr)
+        throw std::length_error(std::string(what) + " : dimension mismatch");
+    }
+  }
+
+  //============================================
+  //              Algorithms
+  //============================================
+  /**
+   * @Brief
+   * Calls f(x) on every element x of a.
+  **/
+  template <typename P, typename A, typename F, typename = detail::enable_policy2d<P>>
+  void for_each(P &&, A &&a, F f)
+  {
+    auto *data = a.data();
+    const size_t ld = detail::leading_dim(a);
+    detail::for_each_tile<P>(a.num_col(), a.num_row(), [&](size_t c0, size_t c1, size_t r0, size_t r1) {
+      for (size_t c = c0; c < c1; ++c)
+      {
+        auto *col = data + c * ld;
+        if constexpr (detail::is_unseq2d<P>::value)
+        {
+          ARRAY2D_VECTORIZE
+          for (size_t r = r0; r < r1; ++r)
+            f(col[r]);
+        }
+        else
+        {
+          for (size_t r = r0; r < r1; ++r)
+            f(col[r]);
+        }
+      }
+    });
+  }
+
+  /**
+   * @Brief
+   * Calls f(col, row, x) on every element x = a(col, row) of a.
+  **/
+  template <typename P, typename A, typename F, typename = detail::enable_policy2d<P>>
+  void for_each_index(P &&, A &&a, F f)
+  {
+    auto *data = a.data();
+    const size_t ld = detail::leading_dim(a);
+    detail::for_each_tile<P>(a.num_col(), a.num_row(), [&](size_t c0, size_t c1, size_t r0, size_t r1) {
+      for (size_t c = c0; c < c1; ++c)
+      {
+        auto *col = data + c * ld;
+        if constexpr (detail::is_unseq2d<P>::value)
+        {
+          ARRAY2D_VECTORIZE
+          for (size_t r = r0; r < r1; ++r)
+            f(c, r, col[r]);
+        }
+        else
+        {
+          for (size_t r = r0; r < r1; ++r)
+            f(c, r, col[r]);
+        }
+      }
+    });
+  }
+
+  /**
+   * @Brief
+   * Computes dst(col, row) = f(src(col, row)). dst may be src.
+   * A vector2d destination is resized, otherwise if the dimensions of dst do not match,
+   * an exception of type std::length_error is thrown.
+  **/
+  template <typename P, typename A, typename B, typename F, typename = detail::enable_policy2d<P>>
+  void transform(P &&, const A &src, B &&dst, F f)
+  {
+    detail::algorithm_prepare(dst, src.num_col(), src.num_row(), "transform");
+
+    const auto *in = src.data();
+    auto *out = dst.data();
+    const size_t lds = detail::leading_dim(src);
+    const size_t ldd = detail::leading_dim(dst);
+    detail::for_each_tile<P>(src.num_col(), src.num_row(), [&](size_t c0, size_t c1, size_t r0, size_t r1) {
+      for (size_t c = c0; c < c1; ++c)
+      {
+        const auto *x = in + c * lds;
+        auto *y = out + c * ldd;
+        if constexpr (detail::is_unseq2d<P>::value)
+        {
+          ARRAY2D_VECTORIZE
+          for (size_t r = r0; r < r1; ++r)
+            y[r] = f(x[r]);
+        }
+        else
+        {
+          for (size_t r = r0; r < r1; ++r)
+            y[r] = f(x[r]);
+        }
+      }
+    });
+  }
+
+  /**
+   * @Brief
+   * Computes dst(col, row) = f(a(col, row), b(col, row)). dst may be a or b.
+   * If a and b do not have the same dimensions, an exception of type std::length_error is thrown.
+   * A vector2d destination is resized, otherwise if the dimensions of dst do not match,
+   * an exception of type std::length_error is thrown.
+  **/
+  template <typename P, typename A, typename B, typename C, typename F, typename = detail::enable_policy2d<P>>
+  void transform(P &&, const A &a, const B &b, C &&dst, F f)
+  {
+    if (a.num_col() != b.num_col() || a.num_row() != b.num_row())
+      throw std::length_error("transform : dimension mismatch");
+    detail::algorithm_prepare(dst, a.num_col(), a.num_row(), "transform");
+
+    const auto *in0 = a.data();
+    const auto *in1 = b.data();
+    auto *out = dst.data();
+    const size_t lda = detail::leading_dim(a);
+    const size_t ldb = detail::leading_dim(b);
+    const size_t ldd = detail::leading_dim(dst);
+    detail::for_each_tile<P>(a.num_col(), a.num_row(), [&](size_t c0, size_t c1, size_t r0, size_t r1) {
+      for (size_t c = c0; c < c1; ++c)
+      {
+        const auto *x = in0 + c * lda;
+        const auto *y = in1 + c * ldb;
+        auto *z = out + c * ldd;
+        if constexpr (detail::is_unseq2d<P>::value)
+        {
+          ARRAY2D_VECTORIZE
+          for (size_t r = r0; r < r1; ++r)
+            z[r] = f(x[r], y[r]);
+        }
+        else
+        {
+          for (size_t r = r0; r < r1; ++r)
+            z[r] = f(x[r], y[r]);
+        }
+      }
+    });
+  }
+
+  namespace detail
+  {
+    // reduce(t(x[r0]), ..., t(x[r1 - 1])) over the columns [c0, c1), with reduce_lanes accumulators when unsequenced
+    template <bool UNSEQ, typename R, typename Reduce, typename Get>
+    R tile_transform_reduce(size_t c0, size_t c1, size_t r0, size_t r1, Reduce &reduce, Get &get)
+    {
+      R acc = get(c0, r0);
+      for (size_t c = c0; c < c1; ++c)
+      {
+        size_t r = (c == c0) ? r0 + 1 : r0;
+        if constexpr (UNSEQ)
+        {
+          constexpr size_t L = 16;
+          if (r + 2 * L <= r1)
+          {
+            R lanes[L];
+            for (size_t l = 0; l < L; ++l)
+              lanes[l] = get(c, r + l);
+            for (r += L; r + L <= r1; r += L)
+              for (size_t l = 0; l < L; ++l)
+                lanes[l] = reduce(lanes[l], R(get(c, r + l)));
+            for (size_t l = 0; l < L; ++l)
+              acc = reduce(acc, lanes[l]);
+          }
+        }
+        for (; r < r1; ++r)
+          acc = reduce(acc, R(get(c, r)));
+      }
+      return acc;
+    }
+
+    template <typename P, typename R, typename Reduce, typename Get>
+    R transform_reduce_tiles(size_t nc, size_t nr, R init, Reduce &reduce, Get &get)
+    {
+      if (nc == 0 || nr == 0)
+        return init;
+
+      // one partial result per tile, combined in order
+      const tile_grid g(nc, nr);
+      std::vector<R> partial(g.num(), init);
+      for_each_tile<P>(nc, nr, [&](size_t c0, size_t c1, size_t r0, size_t r1) {
+        const size_t t = (c0 / g.tc) * g.ntr + r0 / g.tr;
+        partial[t] = tile_transform_reduce<is_unseq2d<P>::value, R>(c0, c1, r0, r1, reduce, get);
+      });
+
+      for (const R &p : partial)
+        init = reduce(init, p);
+      return init;
+    }
+  }
+
+  /**
+   * @Brief
+   * Returns reduce(init, t(x)...) over the elements x of a, e.g. a sum of squares.
+  **/
+  template <typename P, typename A, typename R, typename Reduce, typename Transform, typename = detail::enable_policy2d<P>>
+  R transform_reduce(P &&, const A &a, R init, Reduce reduce, Transform t)
+  {
+    const auto *data = a.data();
+    const size_t ld = detail::leading_dim(a);
+    auto get = [&](size_t c, size_t r) { return R(t(data[c * ld + r])); };
+    return detail::transform_reduce_tiles<P>(a.num_col(), a.num_row(), std::move(init), reduce, get);
+  }
+
+  /**
+   * @Brief
+   * Returns reduce(init, t(x, y)...) over the pairs of elements x = a(col, row), y = b(col, row), e.g. a dot product.
+   * If a and b do not have the same dimensions, an exception of type std::length_error is thrown.
+  **/
+  template <typename P, typename A, typename B, typename R, typename Reduce, typename Transform, typename = detail::enable_policy2d<P>>
+  R transform_reduce(P &&, const A &a, const B &b, R init, Reduce reduce, Transform t)
+  {
+    if (a.num_col() != b.num_col() || a.num_row() != b.num_row())
+      throw std::length_error("transform_reduce : dimension mismatch");
+
+    const auto *x = a.data();
+    const auto *y = b.data();
+    const size_t lda = detail::leading_dim(a);
+    const size_t ldb = detail::leading_dim(b);
+    auto get = [&](size_t c, size_t r) { return R(t(x[c * lda + r], y[c * ldb + r])); };
+    return detail::transform_reduce_tiles<P>(a.num_col(), a.num_row(), std::move(init), reduce, get);
+  }
+}
+
+#endif
@@ -0,0 +1,587 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __ARRAY_2D_BATCH__
+#define __ARRAY_2D_BATCH__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include "array2d.h"
+#include "array2d_expr.h"
+#include "simd.h"
+#include "vector2d.h"
+
+/**
+ * @Brief
+ * Batches of small fixed size matrices stored in structure of arrays form.
+ * 
+ * The matrices are grouped in blocks of LANES matrices, and the element {col, row} of the LANES
+ * matrices of a block are contiguous : the element {col, row} of the matrix i is stored at
+ * block(i / LANES)[(col * ROW + row) * LANES + i % LANES]. With 16 floats per block (one 64 bytes
+ * cache line per element), the batched kernels process a whole block with one vector per element,
+ * with the widest instruction set found at runtime.
+ * 
+ * Matrices follow the convention of array2d_gemm.h : a matrix with m rows and k columns is an
+ * array2d<T, k, m> and its element (i, j) is arr(j, i).
+ * 
+ * The last block is padded up to LANES matrices. The kernels process the padding as well, its
+ * content is unspecified and never returned by scatter().
+ * 
+ * example:
+ * -------
+ * std::vector<std::array2d<float, 4, 4>> transforms(100000);
+ * std::array2d_batch<float, 4, 4> m, inv;
+ * m.gather(transforms.data(), transforms.size());
+ * std::batch_inverse(m, inv);
+ * inv.scatter(transforms.data());
+ */
+
+namespace std
+{
+  template <typename T, size_t COL, size_t ROW, size_t LANES = 16>
+  class array2d_batch
+  {
+    static_assert(COL > 0 && ROW > 0 && LANES > 0, "array2d_batch requires non empty matrices and blocks");
+
+  public:
+    //============================================
+    //              Member Types
+    //============================================
+    typedef T value_type;
+    typedef array2d<T, COL, ROW> matrix_type;
+
+    typedef value_type &reference;
+    typedef const value_type &const_reference;
+
+    typedef value_type *pointer;
+    typedef const value_type *const_pointer;
+
+    static constexpr size_t lanes = LANES;
+    static constexpr size_t block_elements = COL * ROW * LANES;
+
+  public:
+    //============================================
+    //              Initialisation
+    //============================================
+    array2d_batch() noexcept
+        : mSize(0)
+    {
+    }
+
+    /**
+   * @Brief
+   * Creates a batch of n value initialized matrices.
+  **/
+    explicit array2d_batch(size_t n)
+        : mSize(n), mBlocks((n + LANES - 1) / LANES, block_elements)
+    {
+    }
+
+    //============================================
+    //                Data Access
+    //============================================
+    /**
+   * @Brief
+   * Returns a reference to the element {col, row} of the matrix i, with bounds checking.
+   * If i or {col, row} is out of range, an exception of type std::out_of_range is thrown.
+  **/
+    reference at(size_t i, size_t col, size_t row)
+    {
+      check_range(i, col, row);
+      return (*this)(i, col, row);
+    }
+
+    const_reference at(size_t i, size_t col, size_t row) const
+    {
+      check_range(i, col, row);
+      return (*this)(i, col, row);
+    }
+
+    /**
+   * @Brief
+   * Returns a reference to the element {col, row} of the matrix i. No bounds checking is performed.
+  **/
+    reference operator()(size_t i, size_t col, size_t row) noexcept
+    {
+      return block(i / LANES)[(col * ROW + row) * LANES + i % LANES];
+    }
+
+    const_reference operator()(size_t i, size_t col, size_t row) const noexcept
+    {
+      return block(i / LANES)[(col * ROW + row) * LANES + i % LANES];
+    }
+
+    /**
+   * @Brief
+   * Returns a pointer to the block b, i.e. to the element {0, 0} of the matrices [b * LANES, (b + 1) * LANES).
+   * The blocks are aligned on 64 bytes. No bounds checking is performed.
+  **/
+    pointer block(size_t b) noexcept { return mBlocks.data() + b * block_elements; }
+    const_pointer block(size_t b) const noexcept { return mBlocks.data() + b * block_elements; }
+
+    pointer data() noexcept { return mBlocks.data(); }
+    const_pointer data() const noexcept { return mBlocks.data(); }
+
+    /**
+   * @Brief
+   * Returns a copy of the matrix i, or overwrites it with m. No bounds checking is performed.
+  **/
+    matrix_type get(size_t i) const noexcept
+    {
+      matrix_type m;
+      const T *src = block(i / LANES) + i % LANES;
+      T *dst = m.data();
+      for (size_t e = 0; e < COL * ROW; ++e)
+        dst[e] = src[e * LANES];
+      return m;
+    }
+
+    void set(size_t i, const matrix_type &m) noexcept
+    {
+      const T *src = m.data();
+      T *dst = block(i / LANES) + i % LANES;
+      for (size_t e = 0; e < COL * ROW; ++e)
+        dst[e * LANES] = src[e];
+    }
+
+    //============================================
+    //                capacity
+    //============================================
+    inline size_t size() const noexcept { return mSize; }
+    inline bool empty() const noexcept { return mSize == 0; }
+    inline size_t num_blocks() const noexcept { return mBlocks.num_col(); }
+
+    /**
+   * @Brief
+   * Changes the number of matrices, keeping the first min(n, size()) of them.
+   * The new matrices are value initialized.
+  **/
+    void resize(size_t n)
+    {
+      const size_t nb = (n + LANES - 1) / LANES;
+      if (nb != num_blocks())
+      {
+        vector2d<T> tmp(nb, block_elements);
+        std::copy_n(mBlocks.data(), std::min(nb, num_blocks()) * block_elements, tmp.data());
+        mBlocks.swap(tmp);
+      }
+      mSize = n;
+    }
+
+    //============================================
+    //                operations
+    //============================================
+    /**
+   * @Brief
+   * Replaces the content of the batch with the n matrices of the array src (array of structures).
+  **/
+    void gather(const matrix_type *src, size_t n)
+    {
+      resize(n);
+      for (size_t b = 0; b < num_blocks(); ++b)
+      {
+        const size_t nl = std::min(LANES, n - b * LANES);
+        T *dst = block(b);
+        for (size_t l = 0; l < nl; ++l)
+        {
+          const T *m = src[b * LANES + l].data();
+          for (size_t e = 0; e < COL * ROW; ++e)
+            dst[e * LANES + l] = m[e];
+        }
+      }
+    }
+
+    /**
+   * @Brief
+   * Replaces the content of the batch with the n matrices src[index[0]], ..., src[index[n - 1]].
+  **/
+    template <typename I>
+    void gather(const matrix_type *src, const I *index, size_t n)
+    {
+      resize(n);
+      for (size_t i = 0; i < n; ++i)
+        set(i, src[index[i]]);
+    }
+
+    /**
+   * @Brief
+   * Writes the matrices of the batch to the array dst (array of structures), which must hold size() matrices.
+  **/
+    void scatter(matrix_type *dst) const
+    {
+      for (size_t b = 0; b < num_blocks(); ++b)
+      {
+        const size_t nl = std::min(LANES, mSize - b * LANES);
+        const T *src = block(b);
+        for (size_t l = 0; l < nl; ++l)
+        {
+          T *m = dst[b * LANES + l].data();
+          for (size_t e = 0; e < COL * ROW; ++e)
+            m[e] = src[e * LANES + l];
+        }
+      }
+    }
+
+    /**
+   * @Brief
+   * Writes the matrix i of the batch to dst[index[i]] for i in [0, size()).
+  **/
+    template <typename I>
+    void scatter(matrix_type *dst, const I *index) const
+    {
+      for (size_t i = 0; i < mSize; ++i)
+        dst[index[i]] = get(i);
+    }
+
+  protected:
+    void check_range(size_t i, size_t col, size_t row) const
+    {
+      if (i >= mSize || col >= COL || row >= ROW)
+        throw std::out_of_range("array2d_batch::at");
+    }
+
+  protected:
+    size_t mSize;         // number of matrices
+    vector2d<T> mBlocks;  // block b is column b, unpadded so that the blocks are contiguous
+  };
+
+  namespace detail
+  {
+    //============================================
+    //              Block Kernels
+    //============================================
+    // C = A * B on a block, A being R x K and B K x C, through a buffer so that C may be A or B
+    template <size_t C, size_t K, size_t R, size_t L>
+    struct batch_matmul_op
+    {
+      template <typename T>
+      static SIMD_INLINE void block(size_t b, const T *a, const T *x, T *y) noexcept
+      {
+        a += b * K * R * L;
+        x += b * C * K * L;
+        y += b * C * R * L;
+
+        alignas(64) T tmp[C * R * L];
+        for (size_t c = 0; c < C; ++c)
+          for (size_t r = 0; r < R; ++r)
+          {
+            T *o = tmp + (c * R + r) * L;
+            ARRAY2D_VECTORIZE
+            for (size_t l = 0; l < L; ++l)
+              o[l] = a[r * L + l] * x[c * K * L + l];
+            for (size_t k = 1; k < K; ++k)
+            {
+              ARRAY2D_VECTORIZE
+              for (size_t l = 0; l < L; ++l)
+                o[l] += a[(k * R + r) * L + l] * x[(c * K + k) * L + l];
+            }
+          }
+        std::copy_n(tmp, C * R * L, y);
+      }
+    };
+
+    template <size_t C, size_t R, size_t L>
+    struct batch_transpose_op
+    {
+      template <typename T>
+      static SIMD_INLINE void block(size_t b, const T *a, T *y) noexcept
+      {
+        a += b * C * R * L;
+        y += b * C * R * L;
+
+        alignas(64) T tmp[C * R * L];
+        for (size_t c = 0; c < C; ++c)
+          for (size_t r = 0; r < R; ++r)
+            std::copy_n(a + (c * R + r) * L, L, tmp + (r * C + c) * L);
+        std::copy_n(tmp, C * R * L, y);
+      }
+    };
+
+    // inverse by cofactors, the expressions being the same for row major and column major storage
+    template <size_t N, size_t L>
+    struct batch_inverse_op;
+
+    template <size_t L>
+    struct batch_inverse_op<2, L>
+    {
+      template <typename T>
+      static SIMD_INLINE void block(size_t b, const T *a, T *y) noexcept
+      {
+        a += b * 4 * L;
+        y += b * 4 * L;
+        ARRAY2D_VECTORIZE
+        for (size_t l = 0; l < L; ++l)
+        {
+          const T m0 = a[l], m1 = a[L + l], m2 = a[2 * L + l], m3 = a[3 * L + l];
+          const T inv = T(1) / (m0 * m3 - m1 * m2);
+          y[l] = m3 * inv;
+          y[L + l] = -m1 * inv;
+          y[2 * L + l] = -m2 * inv;
+          y[3 * L + l] = m0 * inv;
+        }
+      }
+    };
+
+    template <size_t L>
+    struct batch_inverse_op<3, L>
+    {
+      template <typename T>
+      static SIMD_INLINE void block(size_t b, const T *a, T *y) noexcept
+      {
+        a += b * 9 * L;
+        y += b * 9 * L;
+        ARRAY2D_VECTORIZE
+        for (size_t l = 0; l < L; ++l)
+        {
+          T m[9];
+          for (size_t e = 0; e < 9; ++e)
+            m[e] = a[e * L + l];
+
+          const T b0 = m[4] * m[8] - m[5] * m[7];
+          const T b3 = m[5] * m[6] - m[3] * m[8];
+          const T b6 = m[3] * m[7] - m[4] * m[6];
+          const T inv = T(1) / (m[0] * b0 + m[1] * b3 + m[2] * b6);
+
+          y[0 * L + l] = b0 * inv;
+          y[1 * L + l] = (m[2] * m[7] - m[1] * m[8]) * inv;
+          y[2 * L + l] = (m[1] * m[5] - m[2] * m[4]) * inv;
+          y[3 * L + l] = b3 * inv;
+          y[4 * L + l] = (m[0] * m[8] - m[2] * m[6]) * inv;
+          y[5 * L + l] = (m[2] * m[3] - m[0] * m[5]) * inv;
+          y[6 * L + l] = b6 * inv;
+          y[7 * L + l] = (m[1] * m[6] - m[0] * m[7]) * inv;
+          y[8 * L + l] = (m[0] * m[4] - m[1] * m[3]) * inv;
+        }
+      }
+    };
+
+    template <size_t L>
+    struct batch_inverse_op<4, L>
+    {
+      template <typename T>
+      static SIMD_INLINE void block(size_t b, const T *a, T *y) noexcept
+      {
+        a += b * 16 * L;
+        y += b * 16 * L;
+        ARRAY2D_VECTORIZE
+        for (size_t l = 0; l < L; ++l)
+        {
+          T m[16];
+          for (size_t e = 0; e < 16; ++e)
+            m[e] = a[e * L + l];
+
+          // 2x2 minors of the first two and of the last two lines
+          const T s0 = m[0] * m[5] - m[4] * m[1];
+          const T s1 = m[0] * m[6] - m[4] * m[2];
+          const T s2 = m[0] * m[7] - m[4] * m[3];
+          const T s3 = m[1] * m[6] - m[5] * m[2];
+          const T s4 = m[1] * m[7] - m[5] * m[3];
+          const T s5 = m[2] * m[7] - m[6] * m[3];
+          const T c5 = m[10] * m[15] - m[14] * m[11];
+          const T c4 = m[9] * m[15] - m[13] * m[11];
+          const T c3 = m[9] * m[14] - m[13] * m[10];
+          const T c2 = m[8] * m[15] - m[12] * m[11];
+          const T c1 = m[8] * m[14] - m[12] * m[10];
+          const T c0 = m[8] * m[13] - m[12] * m[9];
+          const T inv = T(1) / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+          y[0 * L + l] = (m[5] * c5 - m[6] * c4 + m[7] * c3) * inv;
+          y[1 * L + l] = (-m[1] * c5 + m[2] * c4 - m[3] * c3) * inv;
+          y[2 * L + l] = (m[13] * s5 - m[14] * s4 + m[15] * s3) * inv;
+          y[3 * L + l] = (-m[9] * s5 + m[10] * s4 - m[11] * s3) * inv;
+          y[4 * L + l] = (-m[4] * c5 + m[6] * c2 - m[7] * c1) * inv;
+          y[5 * L + l] = (m[0] * c5 - m[2] * c2 + m[3] * c1) * inv;
+          y[6 * L + l] = (-m[12] * s5 + m[14] * s2 - m[15] * s1) * inv;
+          y[7 * L + l] = (m[8] * s5 - m[10] * s2 + m[11] * s1) * inv;
+          y[8 * L + l] = (m[4] * c4 - m[5] * c2 + m[7] * c0) * inv;
+          y[9 * L + l] = (-m[0] * c4 + m[1] * c2 - m[3] * c0) * inv;
+          y[10 * L + l] = (m[12] * s4 - m[13] * s2 + m[15] * s0) * inv;
+          y[11 * L + l] = (-m[8] * s4 + m[9] * s2 - m[11] * s0) * inv;
+          y[12 * L + l] = (-m[4] * c3 + m[5] * c1 - m[6] * c0) * inv;
+          y[13 * L + l] = (m[0] * c3 - m[1] * c1 + m[2] * c0) * inv;
+          y[14 * L + l] = (-m[12] * s3 + m[13] * s1 - m[14] * s0) * inv;
+          y[15 * L + l] = (m[8] * s3 - m[9] * s1 + m[10] * s0) * inv;
+        }
+      }
+    };
+
+    // y = M * (x, 1) followed by the division by the last coordinate, M being N x N and x of dimension N - 1
+    template <size_t N, size_t L>
+    struct batch_transform_op
+    {
+      template <typename T>
+      static SIMD_INLINE void block(size_t b, const T *m, const T *x, T *y) noexcept
+      {
+        m += b * N * N * L;
+        x += b * (N - 1) * L;
+        y += b * (N - 1) * L;
+
+        alignas(64) T tmp[N * L];
+        for (size_t r = 0; r < N; ++r)
+        {
+          T *o = tmp + r * L;
+          ARRAY2D_VECTORIZE
+          for (size_t l = 0; l < L; ++l)
+            o[l] = m[((N - 1) * N + r) * L + l];
+          for (size_t c = 0; c + 1 < N; ++c)
+          {
+            ARRAY2D_VECTORIZE
+            for (size_t l = 0; l < L; ++l)
+              o[l] += m[(c * N + r) * L + l] * x[c * L + l];
+          }
+        }
+
+        const T *w = tmp + (N - 1) * L;
+        for (size_t r = 0; r + 1 < N; ++r)
+        {
+          ARRAY2D_VECTORIZE
+          for (size_t l = 0; l < L; ++l)
+            y[r * L + l] = tmp[r * L + l] / w[l];
+        }
+      }
+    };
+
+    //============================================
+    //              Dispatch
+    //============================================
+    // runs Op::block on every block, compiled for each instruction set
+    template <simd_isa ISA>
+    struct batch_kernel
+    {
+      template <typename Op, typename... A>
+      static void run(size_t nb, A... a)
+      {
+        for (size_t b = 0; b < nb; ++b)
+          Op::block(b, a...);
+      }
+    };
+
+    template <>
+    struct batch_kernel<simd_isa::AVX2>
+    {
+      template <typename Op, typename... A>
+      SIMD_TARGET_AVX2 static void run(size_t nb, A... a)
+      {
+        for (size_t b = 0; b < nb; ++b)
+          Op::block(b, a...);
+      }
+    };
+
+    template <>
+    struct batch_kernel<simd_isa::AVX512>
+    {
+      template <typename Op, typename... A>
+      SIMD_TARGET_AVX512 static void run(size_t nb, A... a)
+      {
+        for (size_t b = 0; b < nb; ++b)
+          Op::block(b, a...);
+      }
+    };
+
+    template <typename Op, typename... A>
+    void batch_run(size_t nb, A... a)
+    {
+      switch (simd_isa_detect())
+      {
+      case simd_isa::AVX512:
+        batch_kernel<simd_isa::AVX512>::run<Op>(nb, a...);
+        break;
+      case simd_isa::AVX2:
+        batch_kernel<simd_isa::AVX2>::run<Op>(nb, a...);
+        break;
+      default:
+        batch_kernel<simd_isa::SSE>::run<Op>(nb, a...);
+      }
+    }
+  }
+
+  //============================================
+  //              Batched Kernels
+  //============================================
+  /**
+   * @Brief
+   * Computes c[i] = a[i] * b[i] for every matrix of the batches, a[i] being R x K and b[i] K x C.
+   * c is resized and may be a or b.
+   * If a and b do not hold the same number of matrices, an exception of type std::length_error is thrown.
+  **/
+  template <typename T, size_t C, size_t K, size_t R, size_t L>
+  void batch_matmul(const array2d_batch<T, K, R, L> &a, const array2d_batch<T, C, K, L> &b, array2d_batch<T, C, R, L> &c)
+  {
+    if (a.size() != b.size())
+      throw std::length_error("batch_matmul : size mismatch");
+
+    c.resize(a.size());
+    detail::batch_run<detail::batch_matmul_op<C, K, R, L>>(a.num_blocks(), a.data(), b.data(), c.data());
+  }
+
+  /**
+   * @Brief
+   * Computes at[i] = transpose(a[i]) for every matrix of the batch. at is resized and may be a.
+  **/
+  template <typename T, size_t C, size_t R, size_t L>
+  void batch_transpose(const array2d_batch<T, C, R, L> &a, array2d_batch<T, R, C, L> &at)
+  {
+    at.resize(a.size());
+    detail::batch_run<detail::batch_transpose_op<C, R, L>>(a.num_blocks(), a.data(), at.data());
+  }
+
+  /**
+   * @Brief
+   * Computes inv[i] = a[i]^-1 for every matrix of the batch, by cofactors (2x2, 3x3 and 4x4 matrices).
+   * inv is resized and may be a. The inverse of a singular matrix holds infinite or NaN values.
+  **/
+  template <typename T, size_t N, size_t L>
+  void batch_inverse(const array2d_batch<T, N, N, L> &a, array2d_batch<T, N, N, L> &inv)
+  {
+    static_assert(N >= 2 && N <= 4, "batch_inverse is only implemented for 2x2, 3x3 and 4x4 matrices");
+
+    inv.resize(a.size());
+    detail::batch_run<detail::batch_inverse_op<N, L>>(a.num_blocks(), a.data(), inv.data());
+  }
+
+  /**
+   * @Brief
+   * Transforms the point p[i] by the matrix m[i] in homogeneous coordinates, i.e. computes
+   * m[i] * (p[i], 1) and divides it by its last coordinate, for N x N matrices and points of dimension N - 1
+   * (3x3 matrices and 2d points, 4x4 matrices and 3d points). out is resized and may be p.
+   * If m and p do not hold the same number of elements, an exception of type std::length_error is thrown.
+  **/
+  template <typename T, size_t N, size_t L>
+  void batch_transform_points(const array2d_batch<T, N, N, L> &m, const array2d_batch<T, 1, N - 1, L> &p,
+                              array2d_batch<T, 1, N - 1, L> &out)
+  {
+    static_assert(N >= 2, "batch_transform_points requires at least 2x2 matrices");
+    if (m.size() != p.size())
+      throw std::length_error("batch_transform_points : size mismatch");
+
+    out.resize(p.size());
+    detail::batch_run<detail::batch_transform_op<N, L>>(m.num_blocks(), m.data(), p.data(), out.data());
+  }
+}
+
+#endif
@@ -0,0 +1,271 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __ARRAY_2D_CONVERT__
+#define __ARRAY_2D_CONVERT__
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#include "array2d.h"
+#include "array2d_algorithm.h"
+#include "array2d_expr.h"
+#include "array2d_view.h"
+#include "parallel.h"
+#include "simd.h"
+#include "vector2d.h"
+
+/**
+ * @Brief
+ * Conversions between the element types of 2d arrays, with scaling, saturation and rounding.
+ * 
+ * Each element x of the source becomes saturate_round<U>(x * scale + offset) : integer results are
+ * rounded to the nearest integer (ties to even), clamped to the range of the destination type, NaN
+ * giving 0. Floating point results are only converted.
+ * 
+ * The computation is done in float when it is exact enough (8 and 16 bits integers, float), in double
+ * otherwise. The columns are converted by loops compiled for the widest instruction set found at
+ * runtime, which vectorize the usual conversions (uint8, uint16, float, double), and the execution2d::par
+ * policy (see array2d_algorithm.h) splits large arrays across threads.
+ * 
+ * example:
+ * -------
+ * std::vector2d<uint16_t> raw = read_sensor();
+ * std::vector2d<float> n;
+ * std::convert(raw, n, 1.f / 65535.f);                          // normalized to [0, 1]
+ * std::vector2d<uint8_t> img;
+ * std::convert(std::execution2d::par, n, img, 255.f);           // saturated and rounded to [0, 255]
+ * std::vector2d<double> d = std::convert<double>(img);
+ */
+
+namespace std
+{
+  namespace detail
+  {
+    // type in which x * scale + offset is computed
+    template <typename T, typename U>
+    using convert_work_t = std::conditional_t<(std::is_same<T, double>::value || std::is_same<U, double>::value ||
+                                               (std::is_integral<T>::value && sizeof(T) > 2) ||
+                                               (std::is_integral<U>::value && sizeof(U) > 2)),
+                                              double, float>;
+
+    // range of U in W, the upper bound being rounded up to a power of two when U has more digits than W
+    template <typename U, typename W>
+    inline W convert_lowest() noexcept
+    {
+      return W(std::numeric_limits<U>::lowest());
+    }
+
+    template <typename U, typename W>
+    inline W convert_max() noexcept
+    {
+      return W(std::numeric_limits<U>::max());
+    }
+
+    template <typename U, typename W>
+    SIMD_INLINE U convert_value(W v, W lo, W hi) noexcept
+    {
+      if constexpr (std::is_integral<U>::value)
+      {
+        v = (v == v) ? v : W(0);
+        if constexpr (std::numeric_limits<U>::digits > std::numeric_limits<W>::digits)
+        {
+          v = std::max(v, lo);
+          return (v < hi) ? U(std::nearbyint(v)) : std::numeric_limits<U>::max();
+        }
+        else
+        {
+          v = std::min(std::max(v, lo), hi);
+          return U(std::nearbyint(v));
+        }
+      }
+      else
+        return U(v);
+    }
+
+    // y[i] = saturate_round<U>(x[i] * scale + offset) for the columns [c0, c1)
+    template <typename T, typename U, typename W>
+    SIMD_INLINE void convert_columns(const T *src, size_t lds, U *dst, size_t ldd, size_t c0, size_t c1, size_t nr,
+                                     W scale, W offset) noexcept
+    {
+      const W lo = convert_lowest<U, W>();
+      const W hi = convert_max<U, W>();
+      for (size_t c = c0; c < c1; ++c)
+      {
+        const T *x = src + c * lds;
+        U *y = dst + c * ldd;
+        ARRAY2D_VECTORIZE
+        for (size_t r = 0; r < nr; ++r)
+          y[r] = convert_value<U>(W(x[r]) * scale + offset, lo, hi);
+      }
+    }
+
+    // column kernels compiled for each instruction set
+    template <simd_isa ISA>
+    struct convert_kernel
+    {
+      template <typename T, typename U, typename W>
+      static void run(const T *src, size_t lds, U *dst, size_t ldd, size_t c0, size_t c1, size_t nr, W scale, W offset)
+      {
+        convert_columns(src, lds, dst, ldd, c0, c1, nr, scale, offset);
+      }
+    };
+
+    template <>
+    struct convert_kernel<simd_isa::AVX2>
+    {
+      template <typename T, typename U, typename W>
+      SIMD_TARGET_AVX2 static void run(const T *src, size_t lds, U *dst, size_t ldd, size_t c0, size_t c1, size_t nr, W scale, W offset)
+      {
+        convert_columns(src, lds, dst, ldd, c0, c1, nr, scale, offset);
+      }
+    };
+
+    template <>
+    struct convert_kernel<simd_isa::AVX512>
+    {
+      template <typename T, typename U, typename W>
+      SIMD_TARGET_AVX512 static void run(const T *src, size_t lds, U *dst, size_t ldd, size_t c0, size_t c1, size_t nr, W scale, W offset)
+      {
+        convert_columns(src, lds, dst, ldd, c0, c1, nr, scale, offset);
+      }
+    };
+
+    template <typename T, typename U, typename W>
+    void convert_dispatch(const T *src, size_t lds, U *dst, size_t ldd, size_t c0, size_t c1, size_t nr, W scale, W offset)
+    {
+      switch (simd_isa_detect())
+      {
+      case simd_isa::AVX512:
+        convert_kernel<simd_isa::AVX512>::run(src, lds, dst, ldd, c0, c1, nr, scale, offset);
+        break;
+      case simd_isa::AVX2:
+        convert_kernel<simd_isa::AVX2>::run(src, lds, dst, ldd, c0, c1, nr, scale, offset);
+        break;
+      default:
+        convert_kernel<simd_isa::SSE>::run(src, lds, dst, ldd, c0, c1, nr, scale, offset);
+      }
+    }
+
+    // number of elements converted per task by the parallel policies
+    constexpr size_t convert_grain = 1 << 16;
+
+    template <typename P, typename A, typename B>
+    void convert_impl(const A &src, B &dst, double scale, double offset)
+    {
+      typedef std::remove_const_t<view_value_t<A>> T;
+      typedef std::remove_const_t<view_value_t<B>> U;
+      typedef convert_work_t<T, U> W;
+
+      algorithm_prepare(dst, src.num_col(), src.num_row(), "convert");
+
+      const size_t nc = src.num_col();
+      const size_t nr = src.num_row();
+      if (nc == 0 || nr == 0)
+        return;
+
+      const T *in = src.data();
+      U *out = dst.data();
+      const size_t lds = leading_dim(src);
+      const size_t ldd = leading_dim(dst);
+
+      // plain copies
+      if constexpr (std::is_same<T, U>::value)
+      {
+        if (scale == 1.0 && offset == 0.0)
+        {
+          if (in != out || lds != ldd)
+            strided_copy(nc, nr, in, std::ptrdiff_t(lds), 1, out, std::ptrdiff_t(ldd), 1);
+          return;
+        }
+      }
+
+      if constexpr (std::is_same<std::decay_t<P>, execution2d::sequenced_policy>::value)
+        convert_dispatch(in, lds, out, ldd, 0, nc, nr, W(scale), W(offset));
+      else
+      {
+        const size_t grain = std::max<size_t>(1, convert_grain / nr);
+        parallel_for(0, nc, grain, [&](size_t begin, size_t end) {
+          convert_dispatch(in, lds, out, ldd, begin, end, nr, W(scale), W(offset));
+        });
+      }
+    }
+  }
+
+  /**
+   * @Brief
+   * Returns x converted to U : integers are rounded to the nearest value (ties to even) and clamped
+   * to the range of U, NaN giving 0.
+  **/
+  template <typename U, typename T>
+  inline U saturate_round(T x) noexcept
+  {
+    typedef detail::convert_work_t<T, U> W;
+    return detail::convert_value<U>(W(x), detail::convert_lowest<U, W>(), detail::convert_max<U, W>());
+  }
+
+  /**
+   * @Brief
+   * Computes dst(col, row) = saturate_round<U>(src(col, row) * scale + offset) following the policy
+   * (execution2d::seq, par or par_unseq). src and dst must not overlap, unless they are the same array
+   * of the same type.
+   * A vector2d destination is resized, otherwise if the dimensions of dst do not match,
+   * an exception of type std::length_error is thrown.
+  **/
+  template <typename P, typename A, typename B, typename = detail::enable_policy2d<P>>
+  void convert(P &&, const A &src, B &&dst, double scale = 1.0, double offset = 0.0)
+  {
+    detail::convert_impl<P>(src, dst, scale, offset);
+  }
+
+  /**
+   * @Brief
+   * Computes dst(col, row) = saturate_round<U>(src(col, row) * scale + offset) on the calling thread.
+  **/
+  template <typename A, typename B, typename = std::enable_if_t<!is_execution_policy2d<std::decay_t<A>>::value>>
+  void convert(const A &src, B &&dst, double scale = 1.0, double offset = 0.0)
+  {
+    detail::convert_impl<execution2d::sequenced_policy>(src, dst, scale, offset);
+  }
+
+  /**
+   * @Brief
+   * Returns a vector2d<U> holding saturate_round<U>(src(col, row) * scale + offset).
+  **/
+  template <typename U, typename A, typename = std::enable_if_t<!is_execution_policy2d<std::decay_t<A>>::value>>
+  vector2d<U> convert(const A &src, double scale = 1.0, double offset = 0.0)
+  {
+    vector2d<U> dst(src.num_col(), src.num_row());
+    detail::convert_impl<execution2d::parallel_policy>(src, dst, scale, offset);
+    return dst;
+  }
+}
+
+#endif
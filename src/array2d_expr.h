@@ -0,0 +1,436 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __ARRAY_2D_EXPR__
+#define __ARRAY_2D_EXPR__
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "array2d.h"
+#include "array2d_view.h"
+#include "vector2d.h"
+
+/**
+ * @Brief
+ * Lazy element-wise arithmetic on array2d and vector2d.
+ * 
+ * Operators build an expression tree instead of computing temporaries. The tree is evaluated
+ * in a single pass over the columns of the destination when it is assigned. Block views and
+ * pitched arrays can be used as operands.
+ * 
+ * example:
+ * -------
+ * std::vector2d<float> a(512, 512), b(512, 512), c(512, 512), d(512, 512);
+ * d = a + b * c;                      // one loop, no intermediate arrays
+ * d = std::cwise_max(a, 0.f) * 2.f;   // scalars are broadcast
+ * d = std::cwise_fma(a, b, c);        // a * b + c
+ */
+
+#if defined(__clang__)
+#define ARRAY2D_VECTORIZE _Pragma("clang loop vectorize(enable)")
+#elif defined(__GNUC__)
+#define ARRAY2D_VECTORIZE _Pragma("GCC ivdep")
+#else
+#define ARRAY2D_VECTORIZE
+#endif
+
+namespace std
+{
+  //============================================
+  //              Type Traits
+  //============================================
+  template <typename A>
+  struct is_array2d : std::false_type
+  {
+  };
+
+  template <typename T, size_t COL, size_t ROW>
+  struct is_array2d<array2d<T, COL, ROW>> : std::true_type
+  {
+  };
+
+  template <typename T>
+  struct is_array2d<vector2d<T>> : std::true_type
+  {
+  };
+
+  template <typename T>
+  struct is_array2d<block_view<T>> : std::true_type
+  {
+  };
+
+  template <typename A>
+  struct is_array2d_expr : std::is_base_of<array2d_expr<A>, A>
+  {
+  };
+
+  namespace detail
+  {
+    // true if A can appear as an operand of an array2d expression
+    template <typename A>
+    using is_expr_operand = std::integral_constant<bool, is_array2d<A>::value || is_array2d_expr<A>::value>;
+
+    // true if at least one of the operands is an array or an expression and the others are arithmetic scalars
+    template <typename... A>
+    using enable_expr = std::enable_if_t<(is_expr_operand<std::decay_t<A>>::value || ...) &&
+                                         ((is_expr_operand<std::decay_t<A>>::value || std::is_arithmetic<std::decay_t<A>>::value) && ...)>;
+  }
+
+  //============================================
+  //              Expression Base
+  //============================================
+  /**
+   * @Brief
+   * CRTP base of all the expression nodes.
+   * A node exposes its dimensions and the value of its element {col, row}.
+  **/
+  template <typename E>
+  class array2d_expr
+  {
+  public:
+    inline const E &derived() const noexcept { return static_cast<const E &>(*this); }
+
+    inline auto operator()(size_t col, size_t row) const { return derived()(col, row); }
+
+    inline size_t num_col() const noexcept { return derived().num_col(); }
+    inline size_t num_row() const noexcept { return derived().num_row(); }
+    inline size_t num() const noexcept { return num_col() * num_row(); }
+
+    /**
+   * @Brief
+   * Evaluates the expression into dst in a single pass, one column at a time.
+   * If the dimensions of dst do not match the expression, an exception of type std::length_error is thrown.
+  **/
+    template <typename A>
+    void assign_to(A &dst) const
+    {
+      if (dst.num_col() != num_col() || dst.num_row() != num_row())
+        throw std::length_error("array2d_expr::assign_to : dimension mismatch");
+
+      const E &e = derived();
+      const size_t ncol = dst.num_col();
+      const size_t nrow = dst.num_row();
+      const size_t ld = detail::leading_dim(dst);
+
+      for (size_t c = 0; c < ncol; ++c)
+      {
+        auto *out = dst.data() + c * ld;
+
+        ARRAY2D_VECTORIZE
+        for (size_t r = 0; r < nrow; ++r)
+          out[r] = e(c, r);
+      }
+    }
+  };
+
+  namespace detail
+  {
+    //============================================
+    //              Leaf Nodes
+    //============================================
+    // wraps the storage of an array2d, vector2d or block_view
+    template <typename T>
+    class array2d_leaf : public array2d_expr<array2d_leaf<T>>
+    {
+    public:
+      template <typename A>
+      explicit array2d_leaf(const A &a) noexcept
+          : mData(a.data()), mCol(a.num_col()), mRow(a.num_row()), mLd(leading_dim(a))
+      {
+      }
+
+      inline const T &operator()(size_t col, size_t row) const noexcept { return mData[col * mLd + row]; }
+
+      inline size_t num_col() const noexcept { return mCol; }
+      inline size_t num_row() const noexcept { return mRow; }
+
+    private:
+      const T *mData;
+      size_t mCol;
+      size_t mRow;
+      size_t mLd;
+    };
+
+    // broadcasts a scalar to every element, takes its dimensions from the other operands
+    template <typename T>
+    class scalar_leaf
+    {
+    public:
+      explicit scalar_leaf(const T &value) noexcept
+          : mValue(value)
+      {
+      }
+
+      inline const T &operator()(size_t, size_t) const noexcept { return mValue; }
+
+    private:
+      T mValue;
+    };
+
+    template <typename A>
+    struct expr_traits
+    {
+      typedef scalar_leaf<A> type;
+      static type make(const A &a) { return type(a); }
+    };
+
+    template <typename T, size_t COL, size_t ROW>
+    struct expr_traits<array2d<T, COL, ROW>>
+    {
+      typedef array2d_leaf<T> type;
+      static type make(const array2d<T, COL, ROW> &a) { return type(a); }
+    };
+
+    template <typename T>
+    struct expr_traits<vector2d<T>>
+    {
+      typedef array2d_leaf<T> type;
+      static type make(const vector2d<T> &a) { return type(a); }
+    };
+
+    template <typename T>
+    struct expr_traits<block_view<T>>
+    {
+      typedef array2d_leaf<std::remove_cv_t<T>> type;
+      static type make(const block_view<T> &a) { return type(a); }
+    };
+
+    template <typename A>
+    using expr_type = typename std::conditional_t<is_array2d_expr<A>::value, std::common_type<A>, expr_traits<A>>::type;
+
+    template <typename A>
+    inline expr_type<A> make_expr(const A &a)
+    {
+      if constexpr (is_array2d_expr<A>::value)
+        return a;
+      else
+        return expr_traits<A>::make(a);
+    }
+
+    // returns the dimensions of the first non-scalar operand
+    template <typename A, typename... B>
+    inline size_t expr_num_col(const A &a, const B &...b) noexcept
+    {
+      if constexpr (is_array2d_expr<A>::value)
+        return a.num_col();
+      else
+        return expr_num_col(b...);
+    }
+
+    template <typename A, typename... B>
+    inline size_t expr_num_row(const A &a, const B &...b) noexcept
+    {
+      if constexpr (is_array2d_expr<A>::value)
+        return a.num_row();
+      else
+        return expr_num_row(b...);
+    }
+
+    // true if a is a scalar or has nc columns and nr rows
+    template <typename A>
+    inline bool expr_has_dims(const A &a, size_t nc, size_t nr) noexcept
+    {
+      if constexpr (is_array2d_expr<A>::value)
+        return a.num_col() == nc && a.num_row() == nr;
+      else
+        return true;
+    }
+
+    //============================================
+    //              Inner Nodes
+    //============================================
+    template <typename Op, typename... E>
+    class node_expr : public array2d_expr<node_expr<Op, E...>>
+    {
+    public:
+      // throws std::length_error if the array operands do not have the same dimensions
+      explicit node_expr(const E &...e)
+          : mArgs(e...)
+      {
+        const size_t nc = expr_num_col(e...);
+        const size_t nr = expr_num_row(e...);
+        if (!(expr_has_dims(e, nc, nr) && ...))
+          throw std::length_error("array2d_expr : dimension mismatch");
+      }
+
+      inline auto operator()(size_t col, size_t row) const
+      {
+        return std::apply([col, row](const E &...e) { return Op()(e(col, row)...); }, mArgs);
+      }
+
+      inline size_t num_col() const noexcept
+      {
+        return std::apply([](const E &...e) { return expr_num_col(e...); }, mArgs);
+      }
+
+      inline size_t num_row() const noexcept
+      {
+        return std::apply([](const E &...e) { return expr_num_row(e...); }, mArgs);
+      }
+
+    private:
+      std::tuple<E...> mArgs;
+    };
+
+    template <typename Op, typename... A>
+    inline node_expr<Op, expr_type<A>...> make_node(const A &...a)
+    {
+      return node_expr<Op, expr_type<A>...>(make_expr(a)...);
+    }
+
+    //============================================
+    //              Operations
+    //============================================
+    struct op_add
+    {
+      template <typename L, typename R>
+      inline auto operator()(const L &l, const R &r) const { return l + r; }
+    };
+
+    struct op_sub
+    {
+      template <typename L, typename R>
+      inline auto operator()(const L &l, const R &r) const { return l - r; }
+    };
+
+    struct op_mul
+    {
+      template <typename L, typename R>
+      inline auto operator()(const L &l, const R &r) const { return l * r; }
+    };
+
+    struct op_div
+    {
+      template <typename L, typename R>
+      inline auto operator()(const L &l, const R &r) const { return l / r; }
+    };
+
+    struct op_neg
+    {
+      template <typename L>
+      inline auto operator()(const L &l) const { return -l; }
+    };
+
+    struct op_min
+    {
+      template <typename L, typename R>
+      inline auto operator()(const L &l, const R &r) const { return (r < l) ? r : l; }
+    };
+
+    struct op_max
+    {
+      template <typename L, typename R>
+      inline auto operator()(const L &l, const R &r) const { return (l < r) ? r : l; }
+    };
+
+    struct op_abs
+    {
+      template <typename L>
+      inline auto operator()(const L &l) const { return (l < L(0)) ? L(-l) : l; }
+    };
+
+    struct op_fma
+    {
+      template <typename A, typename B, typename C>
+      inline auto operator()(const A &a, const B &b, const C &c) const { return a * b + c; }
+    };
+  }
+
+  //============================================
+  //              Operators
+  //============================================
+  template <typename L, typename R, typename = detail::enable_expr<L, R>>
+  inline auto operator+(const L &l, const R &r)
+  {
+    return detail::make_node<detail::op_add>(l, r);
+  }
+
+  template <typename L, typename R, typename = detail::enable_expr<L, R>>
+  inline auto operator-(const L &l, const R &r)
+  {
+    return detail::make_node<detail::op_sub>(l, r);
+  }
+
+  template <typename L, typename R, typename = detail::enable_expr<L, R>>
+  inline auto operator*(const L &l, const R &r)
+  {
+    return detail::make_node<detail::op_mul>(l, r);
+  }
+
+  template <typename L, typename R, typename = detail::enable_expr<L, R>>
+  inline auto operator/(const L &l, const R &r)
+  {
+    return detail::make_node<detail::op_div>(l, r);
+  }
+
+  template <typename L, typename = detail::enable_expr<L>>
+  inline auto operator-(const L &l)
+  {
+    return detail::make_node<detail::op_neg>(l);
+  }
+
+  /**
+   * @Brief
+   * Element-wise minimum and maximum of two arrays, or of an array and a scalar.
+  **/
+  template <typename L, typename R, typename = detail::enable_expr<L, R>>
+  inline auto cwise_min(const L &l, const R &r)
+  {
+    return detail::make_node<detail::op_min>(l, r);
+  }
+
+  template <typename L, typename R, typename = detail::enable_expr<L, R>>
+  inline auto cwise_max(const L &l, const R &r)
+  {
+    return detail::make_node<detail::op_max>(l, r);
+  }
+
+  /**
+   * @Brief
+   * Element-wise absolute value.
+  **/
+  template <typename L, typename = detail::enable_expr<L>>
+  inline auto cwise_abs(const L &l)
+  {
+    return detail::make_node<detail::op_abs>(l);
+  }
+
+  /**
+   * @Brief
+   * Element-wise fused multiply-add a * b + c.
+  **/
+  template <typename A, typename B, typename C, typename = detail::enable_expr<A, B, C>>
+  inline auto cwise_fma(const A &a, const B &b, const C &c)
+  {
+    return detail::make_node<detail::op_fma>(a, b, c);
+  }
+}
+
+#endif
@@ -0,0 +1,557 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __ARRAY_2D_FILTER__
+#define __ARRAY_2D_FILTER__
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "array2d.h"
+#include "array2d_expr.h"
+#include "array2d_view.h"
+#include "parallel.h"
+#include "simd.h"
+#include "vector2d.h"
+
+/**
+ * @Brief
+ * Convolution of 2d arrays (array2d, vector2d and block views) with separable or generic kernels.
+ * 
+ * The destination is cut into tiles of columns x rows processed in parallel. Each output column
+ * of a tile is accumulated from whole input column segments, so that all the inner loops run
+ * along contiguous memory and vectorize, using the widest instruction set found at runtime.
+ * Temporary lines are kept per thread and reused from one call to the next.
+ * 
+ * Elements read outside of the source are defined by the border mode :
+ *   CLAMP    : the nearest element             (a a | a b c d | d d)
+ *   WRAP     : the array repeats periodically  (c d | a b c d | a b)
+ *   MIRROR   : reflection about the last element, which is not repeated (c b | a b c d | c b)
+ *   CONSTANT : a given value                   (v v | a b c d | v v)
+ * 
+ * Kernels are applied without being flipped, as in most image processing libraries :
+ * dst(c, r) = sum k(i, j) * src(c + i - nkc / 2, r + j - nkr / 2).
+ * Sums are accumulated in the type of src(c, r) * k(i, j), then cast to the type of dst.
+ * 
+ * example:
+ * -------
+ * std::vector2d<float> img(1920, 1080), out;
+ * std::vector<float> g = std::gaussian_kernel<float>(2.0);
+ * std::convolve_separable(img, out, g, g);                           // gaussian blur
+ * 
+ * std::array2d<float, 3, 3> lap = {0, 1, 0, 1, -4, 1, 0, 1, 0};
+ * std::convolve(img, out, lap, std::border_mode::CONSTANT, 0.f);     // laplacian
+ */
+
+namespace std
+{
+  enum class border_mode
+  {
+    CLAMP = 0,
+    WRAP = 1,
+    MIRROR = 2,
+    CONSTANT = 3
+  };
+
+  namespace detail
+  {
+    // size of the tiles the destination is cut into, in columns and rows
+    constexpr size_t filter_tile_col = 64;
+    constexpr size_t filter_tile_row = 512;
+
+    // number of kernel taps applied in one pass over an accumulation line
+    constexpr size_t filter_taps = 4;
+
+    template <typename T, typename K>
+    using filter_acc_t = decltype(std::declval<T>() * std::declval<K>());
+
+    template <typename A>
+    using filter_value_t = std::remove_const_t<view_value_t<A>>;
+
+    // index in [0, n) read at the position i according to the border mode, -1 for a constant border
+    inline std::ptrdiff_t border_index(std::ptrdiff_t i, std::ptrdiff_t n, border_mode border) noexcept
+    {
+      if (i >= 0 && i < n)
+        return i;
+
+      switch (border)
+      {
+      case border_mode::CLAMP:
+        return i < 0 ? 0 : n - 1;
+      case border_mode::WRAP:
+        i %= n;
+        return i < 0 ? i + n : i;
+      case border_mode::MIRROR:
+      {
+        if (n == 1)
+          return 0;
+        const std::ptrdiff_t period = 2 * (n - 1);
+        i %= period;
+        i = i < 0 ? i + period : i;
+        return i < n ? i : period - i;
+      }
+      default:
+        return -1;
+      }
+    }
+
+    // arguments of a filtering call, kc and kr are the separable weights along the columns and the rows,
+    // k is a nkc x nkr column major kernel whose columns are ldk apart
+    template <typename T, typename U, typename K>
+    struct filter_args
+    {
+      const T *src;
+      size_t lds;
+      size_t nc;
+      size_t nr;
+      U *dst;
+      size_t ldd;
+      const K *kc;
+      const K *kr;
+      const K *k;
+      size_t ldk;
+      size_t nkc;
+      size_t nkr;
+      border_mode border;
+      T value;
+    };
+
+    // pointer to the n elements of the column c starting at the row r0, as read through the border mode.
+    // Columns or rows falling outside of the source are gathered into buf
+    template <typename T, typename U, typename K>
+    inline const T *filter_line(const filter_args<T, U, K> &a, std::ptrdiff_t c, std::ptrdiff_t r0, size_t n, T *buf)
+    {
+      const std::ptrdiff_t nr = std::ptrdiff_t(a.nr);
+      const std::ptrdiff_t cc = border_index(c, std::ptrdiff_t(a.nc), a.border);
+      if (cc < 0)
+      {
+        std::fill_n(buf, n, a.value);
+        return buf;
+      }
+
+      const T *col = a.src + size_t(cc) * a.lds;
+      if (r0 >= 0 && r0 + std::ptrdiff_t(n) <= nr)
+        return col + r0;
+
+      // rows before the first one, inside the column, and after the last one
+      const std::ptrdiff_t b = std::clamp<std::ptrdiff_t>(-r0, 0, std::ptrdiff_t(n));
+      const std::ptrdiff_t e = std::clamp<std::ptrdiff_t>(nr - r0, b, std::ptrdiff_t(n));
+      for (std::ptrdiff_t i = 0; i < b; ++i)
+      {
+        const std::ptrdiff_t r = border_index(r0 + i, nr, a.border);
+        buf[i] = r < 0 ? a.value : col[r];
+      }
+      std::copy(col + r0 + b, col + r0 + e, buf + b);
+      for (std::ptrdiff_t i = e; i < std::ptrdiff_t(n); ++i)
+      {
+        const std::ptrdiff_t r = border_index(r0 + i, nr, a.border);
+        buf[i] = r < 0 ? a.value : col[r];
+      }
+      return buf;
+    }
+
+    // acc[i] += w[0] * x[0][i] + ... + w[m - 1] * x[m - 1][i] for i in [0, n) and m in [1, filter_taps].
+    // Taps are applied by groups to limit the loads and stores of acc
+    template <typename Acc, typename T>
+    SIMD_INLINE void filter_axpy(Acc *acc, const T *const *x, const Acc *w, size_t m, size_t n) noexcept
+    {
+      const T *x0 = x[0];
+      const T *x1 = x[m > 1 ? 1 : 0];
+      const T *x2 = x[m > 2 ? 2 : 0];
+      const T *x3 = x[m > 3 ? 3 : 0];
+      const Acc w0 = w[0], w1 = w[1], w2 = w[2], w3 = w[3];
+
+      switch (m)
+      {
+      case 4:
+        ARRAY2D_VECTORIZE
+        for (size_t i = 0; i < n; ++i)
+          acc[i] += w0 * Acc(x0[i]) + w1 * Acc(x1[i]) + w2 * Acc(x2[i]) + w3 * Acc(x3[i]);
+        break;
+      case 3:
+        ARRAY2D_VECTORIZE
+        for (size_t i = 0; i < n; ++i)
+          acc[i] += w0 * Acc(x0[i]) + w1 * Acc(x1[i]) + w2 * Acc(x2[i]);
+        break;
+      case 2:
+        ARRAY2D_VECTORIZE
+        for (size_t i = 0; i < n; ++i)
+          acc[i] += w0 * Acc(x0[i]) + w1 * Acc(x1[i]);
+        break;
+      default:
+        ARRAY2D_VECTORIZE
+        for (size_t i = 0; i < n; ++i)
+          acc[i] += w0 * Acc(x0[i]);
+      }
+    }
+
+    template <typename U, typename Acc>
+    SIMD_INLINE void filter_store(U *dst, const Acc *acc, size_t n) noexcept
+    {
+      ARRAY2D_VECTORIZE
+      for (size_t i = 0; i < n; ++i)
+        dst[i] = U(acc[i]);
+    }
+
+    // filters the columns [c0, c1) and rows [r0, r1) with a separable kernel. The source is first filtered
+    // along the columns into tmp, which holds the extra rows needed by the filtering along the rows.
+    // line holds filter_taps buffers of n + nkr - 1 elements
+    template <typename T, typename U, typename K, typename Acc>
+    SIMD_INLINE void filter_tile_separable(const filter_args<T, U, K> &a, size_t c0, size_t c1, size_t r0, size_t r1,
+                                           T *line, Acc *tmp, Acc *acc)
+    {
+      const size_t n = r1 - r0;
+      const size_t len = n + a.nkr - 1;
+      const std::ptrdiff_t hc = std::ptrdiff_t(a.nkc / 2);
+      const std::ptrdiff_t top = std::ptrdiff_t(r0) - std::ptrdiff_t(a.nkr / 2);
+
+      const T *x[filter_taps];
+      const Acc *y[filter_taps];
+      Acc w[filter_taps] = {};
+      size_t m;
+
+      for (size_t c = c0; c < c1; ++c)
+      {
+        std::fill_n(tmp, len, Acc(0));
+        m = 0;
+        for (size_t i = 0; i < a.nkc; ++i)
+        {
+          if (a.kc[i] == K(0))
+            continue;
+          x[m] = filter_line(a, std::ptrdiff_t(c + i) - hc, top, len, line + m * len);
+          w[m] = Acc(a.kc[i]);
+          if (++m == filter_taps)
+          {
+            filter_axpy(tmp, x, w, m, len);
+            m = 0;
+          }
+        }
+        if (m > 0)
+          filter_axpy(tmp, x, w, m, len);
+
+        std::fill_n(acc, n, Acc(0));
+        m = 0;
+        for (size_t j = 0; j < a.nkr; ++j)
+        {
+          if (a.kr[j] == K(0))
+            continue;
+          y[m] = tmp + j;
+          w[m] = Acc(a.kr[j]);
+          if (++m == filter_taps)
+          {
+            filter_axpy(acc, y, w, m, n);
+            m = 0;
+          }
+        }
+        if (m > 0)
+          filter_axpy(acc, y, w, m, n);
+
+        filter_store(a.dst + c * a.ldd + r0, acc, n);
+      }
+    }
+
+    // filters the columns [c0, c1) and rows [r0, r1) with a generic kernel, line holds n + nkr - 1 elements
+    template <typename T, typename U, typename K, typename Acc>
+    SIMD_INLINE void filter_tile(const filter_args<T, U, K> &a, size_t c0, size_t c1, size_t r0, size_t r1,
+                                 T *line, Acc *acc)
+    {
+      const size_t n = r1 - r0;
+      const size_t len = n + a.nkr - 1;
+      const std::ptrdiff_t hc = std::ptrdiff_t(a.nkc / 2);
+      const std::ptrdiff_t top = std::ptrdiff_t(r0) - std::ptrdiff_t(a.nkr / 2);
+
+      const T *x[filter_taps];
+      Acc w[filter_taps] = {};
+      size_t m;
+
+      for (size_t c = c0; c < c1; ++c)
+      {
+        std::fill_n(acc, n, Acc(0));
+        for (size_t i = 0; i < a.nkc; ++i)
+        {
+          const K *k = a.k + i * a.ldk;
+          if (std::all_of(k, k + a.nkr, [](const K &v) { return v == K(0); }))
+            continue;
+
+          const T *col = filter_line(a, std::ptrdiff_t(c + i) - hc, top, len, line);
+          m = 0;
+          for (size_t j = 0; j < a.nkr; ++j)
+          {
+            if (k[j] == K(0))
+              continue;
+            x[m] = col + j;
+            w[m] = Acc(k[j]);
+            if (++m == filter_taps)
+            {
+              filter_axpy(acc, x, w, m, n);
+              m = 0;
+            }
+          }
+          if (m > 0)
+            filter_axpy(acc, x, w, m, n);
+        }
+
+        filter_store(a.dst + c * a.ldd + r0, acc, n);
+      }
+    }
+
+    // tile kernels compiled for each instruction set
+    template <simd_isa ISA>
+    struct filter_kernel
+    {
+      template <typename T, typename U, typename K, typename Acc>
+      static void separable(const filter_args<T, U, K> &a, size_t c0, size_t c1, size_t r0, size_t r1, T *line, Acc *tmp, Acc *acc)
+      {
+        filter_tile_separable(a, c0, c1, r0, r1, line, tmp, acc);
+      }
+
+      template <typename T, typename U, typename K, typename Acc>
+      static void generic(const filter_args<T, U, K> &a, size_t c0, size_t c1, size_t r0, size_t r1, T *line, Acc *acc)
+      {
+        filter_tile(a, c0, c1, r0, r1, line, acc);
+      }
+    };
+
+    template <>
+    struct filter_kernel<simd_isa::AVX2>
+    {
+      template <typename T, typename U, typename K, typename Acc>
+      SIMD_TARGET_AVX2 static void separable(const filter_args<T, U, K> &a, size_t c0, size_t c1, size_t r0, size_t r1, T *line, Acc *tmp, Acc *acc)
+      {
+        filter_tile_separable(a, c0, c1, r0, r1, line, tmp, acc);
+      }
+
+      template <typename T, typename U, typename K, typename Acc>
+      SIMD_TARGET_AVX2 static void generic(const filter_args<T, U, K> &a, size_t c0, size_t c1, size_t r0, size_t r1, T *line, Acc *acc)
+      {
+        filter_tile(a, c0, c1, r0, r1, line, acc);
+      }
+    };
+
+    template <>
+    struct filter_kernel<simd_isa::AVX512>
+    {
+      template <typename T, typename U, typename K, typename Acc>
+      SIMD_TARGET_AVX512 static void separable(const filter_args<T, U, K> &a, size_t c0, size_t c1, size_t r0, size_t r1, T *line, Acc *tmp, Acc *acc)
+      {
+        filter_tile_separable(a, c0, c1, r0, r1, line, tmp, acc);
+      }
+
+      template <typename T, typename U, typename K, typename Acc>
+      SIMD_TARGET_AVX512 static void generic(const filter_args<T, U, K> &a, size_t c0, size_t c1, size_t r0, size_t r1, T *line, Acc *acc)
+      {
+        filter_tile(a, c0, c1, r0, r1, line, acc);
+      }
+    };
+
+    // distributes the tiles of the destination over the threads, the tiles of a same block of columns
+    // being consecutive
+    template <simd_isa ISA, bool SEPARABLE, typename T, typename U, typename K>
+    void filter_run(const filter_args<T, U, K> &a)
+    {
+      typedef filter_acc_t<T, K> Acc;
+
+      const size_t ntc = (a.nc + filter_tile_col - 1) / filter_tile_col;
+      const size_t ntr = (a.nr + filter_tile_row - 1) / filter_tile_row;
+      const size_t len = std::min(filter_tile_row, a.nr) + a.nkr - 1;
+
+      parallel_for(0, ntc * ntr, 1, [&](size_t begin, size_t end) {
+        // reused from one call to the next
+        thread_local std::vector<T> line;
+        thread_local std::vector<Acc> tmp;
+        thread_local std::vector<Acc> acc;
+        if (line.size() < filter_taps * len)
+          line.resize(filter_taps * len);
+        if (acc.size() < len)
+          acc.resize(len);
+        if (SEPARABLE && tmp.size() < len)
+          tmp.resize(len);
+
+        for (size_t t = begin; t < end; ++t)
+        {
+          const size_t c0 = (t / ntr) * filter_tile_col;
+          const size_t r0 = (t % ntr) * filter_tile_row;
+          const size_t c1 = std::min(c0 + filter_tile_col, a.nc);
+          const size_t r1 = std::min(r0 + filter_tile_row, a.nr);
+
+          if constexpr (SEPARABLE)
+            filter_kernel<ISA>::separable(a, c0, c1, r0, r1, line.data(), tmp.data(), acc.data());
+          else
+            filter_kernel<ISA>::generic(a, c0, c1, r0, r1, line.data(), acc.data());
+        }
+      });
+    }
+
+    template <bool SEPARABLE, typename T, typename U, typename K>
+    void filter_dispatch(const filter_args<T, U, K> &a)
+    {
+      switch (simd_isa_detect())
+      {
+      case simd_isa::AVX512:
+        filter_run<simd_isa::AVX512, SEPARABLE>(a);
+        break;
+      case simd_isa::AVX2:
+        filter_run<simd_isa::AVX2, SEPARABLE>(a);
+        break;
+      default:
+        filter_run<simd_isa::SSE, SEPARABLE>(a);
+      }
+    }
+
+    // resizes a vector2d destination to the dimensions of src, and checks that src and dst do not overlap
+    template <typename A, typename B>
+    void filter_prepare(const A &src, B &dst, const char *name)
+    {
+      if constexpr (std::is_same<B, vector2d<typename B::value_type>>::value)
+      {
+        if (dst.num_col() != src.num_col() || dst.num_row() != src.num_row())
+          dst.resize(src.num_col(), src.num_row());
+      }
+
+      if (dst.num_col() != src.num_col() || dst.num_row() != src.num_row())
+        throw std::length_error(std::string(name) + " : dimension mismatch");
+
+      if (src.num_col() == 0 || src.num_row() == 0)
+        return;
+
+      const std::uintptr_t sb = reinterpret_cast<std::uintptr_t>(src.data());
+      const std::uintptr_t se = reinterpret_cast<std::uintptr_t>(&src(src.num_col() - 1, src.num_row() - 1) + 1);
+      const std::uintptr_t db = reinterpret_cast<std::uintptr_t>(dst.data());
+      const std::uintptr_t de = reinterpret_cast<std::uintptr_t>(&dst(dst.num_col() - 1, dst.num_row() - 1) + 1);
+      if (sb < de && db < se)
+        throw std::invalid_argument(std::string(name) + " : src and dst overlap");
+    }
+  }
+
+  /**
+   * @Brief
+   * Filters src with the separable kernel kc x kr into dst, i.e. 
+   * dst(c, r) = sum kc[i] * kr[j] * src(c + i - nkc / 2, r + j - nkr / 2).
+   * kc holds the nkc weights along the columns and kr the nkr weights along the rows.
+   * value is the element read outside of src when border is CONSTANT.
+   * 
+   * A vector2d destination is resized, otherwise if the dimensions of dst do not match,
+   * an exception of type std::length_error is thrown.
+   * If a kernel is empty or if src and dst overlap, an exception of type std::invalid_argument is thrown.
+  **/
+  template <typename A, typename B, typename K>
+  void convolve_separable(const A &src, B &dst, const K *kc, size_t nkc, const K *kr, size_t nkr,
+                          border_mode border = border_mode::CLAMP, const detail::filter_value_t<A> &value = {})
+  {
+    if (nkc == 0 || nkr == 0)
+      throw std::invalid_argument("convolve_separable : empty kernel");
+
+    detail::filter_prepare(src, dst, "convolve_separable");
+    if (src.num_col() == 0 || src.num_row() == 0)
+      return;
+
+    detail::filter_args<detail::filter_value_t<A>, detail::filter_value_t<B>, K> a = {
+        src.data(), detail::leading_dim(src), src.num_col(), src.num_row(),
+        dst.data(), detail::leading_dim(dst),
+        kc, kr, nullptr, 0, nkc, nkr, border, value};
+    detail::filter_dispatch<true>(a);
+  }
+
+  /**
+   * @Brief
+   * Filters src with the separable kernel kc x kr into dst, kc and kr being containers
+   * of weights such as std::vector or std::array.
+  **/
+  template <typename A, typename B, typename KC, typename KR>
+  void convolve_separable(const A &src, B &dst, const KC &kc, const KR &kr,
+                          border_mode border = border_mode::CLAMP, const detail::filter_value_t<A> &value = {})
+  {
+    convolve_separable(src, dst, kc.data(), kc.size(), kr.data(), kr.size(), border, value);
+  }
+
+  /**
+   * @Brief
+   * Filters src with the 2d kernel k into dst, i.e.
+   * dst(c, r) = sum k(i, j) * src(c + i - k.num_col() / 2, r + j - k.num_row() / 2).
+   * value is the element read outside of src when border is CONSTANT.
+   * 
+   * A vector2d destination is resized, otherwise if the dimensions of dst do not match,
+   * an exception of type std::length_error is thrown.
+   * If the kernel is empty or if src and dst overlap, an exception of type std::invalid_argument is thrown.
+  **/
+  template <typename A, typename B, typename K>
+  void convolve(const A &src, B &dst, const K &k,
+                border_mode border = border_mode::CLAMP, const detail::filter_value_t<A> &value = {})
+  {
+    typedef detail::filter_value_t<K> KT;
+
+    if (k.num_col() == 0 || k.num_row() == 0)
+      throw std::invalid_argument("convolve : empty kernel");
+
+    detail::filter_prepare(src, dst, "convolve");
+    if (src.num_col() == 0 || src.num_row() == 0)
+      return;
+
+    detail::filter_args<detail::filter_value_t<A>, detail::filter_value_t<B>, KT> a = {
+        src.data(), detail::leading_dim(src), src.num_col(), src.num_row(),
+        dst.data(), detail::leading_dim(dst),
+        nullptr, nullptr, k.data(), detail::leading_dim(k), k.num_col(), k.num_row(), border, value};
+    detail::filter_dispatch<false>(a);
+  }
+
+  /**
+   * @Brief
+   * Returns the normalized 1d gaussian kernel of standard deviation sigma with 2 * radius + 1 weights.
+   * If radius is 0, it is set to ceil(3 * sigma).
+   * If sigma is not positive, an exception of type std::invalid_argument is thrown.
+  **/
+  template <typename T = float>
+  std::vector<T> gaussian_kernel(double sigma, size_t radius = 0)
+  {
+    if (!(sigma > 0.0))
+      throw std::invalid_argument("gaussian_kernel : sigma must be positive");
+
+    if (radius == 0)
+      radius = size_t(std::ceil(3.0 * sigma));
+
+    std::vector<double> w(2 * radius + 1);
+    double s = 0.0;
+    for (size_t i = 0; i < w.size(); ++i)
+    {
+      const double x = double(i) - double(radius);
+      w[i] = std::exp(-0.5 * x * x / (sigma * sigma));
+      s += w[i];
+    }
+
+    std::vector<T> k(w.size());
+    for (size_t i = 0; i < w.size(); ++i)
+      k[i] = T(w[i] / s);
+    return k;
+  }
+}
+
+#endif
@@ -0,0 +1,411 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __ARRAY_2D_GEMM__
+#define __ARRAY_2D_GEMM__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "array2d.h"
+#include "array2d_view.h"
+#include "parallel.h"
+#include "simd.h"
+#include "vector2d.h"
+
+/**
+ * @Brief
+ * Dense matrix products on 2d arrays seen as column major matrices.
+ * A matrix with m rows and k columns is an array with num_row() == m and num_col() == k,
+ * element (i, j) of the matrix being arr(j, i).
+ * 
+ * Products of float and double matrices are blocked for the caches, the operands being packed
+ * into panels consumed by register blocked micro-kernels. The kernel is selected at runtime
+ * among the SSE, AVX2 and AVX-512 versions. Large products are split across the threads of the
+ * global thread pool along the columns of the result, which keeps results reproducible.
+ * 
+ * Products of fixed size array2d with at most 4 rows and columns are fully unrolled at compile time.
+ * 
+ * example:
+ * -------
+ * std::vector2d<float> A(k, m), B(n, k), C;
+ * std::matmul(A, B, C);                 // C = A * B, C is resized to n x m
+ * std::gemm(2.f, A, B, 1.f, C);         // C = 2 * A * B + C
+ * 
+ * std::array2d<float, 4, 4> M, N, P;
+ * std::matmul(M, N, P);                 // unrolled
+ */
+
+namespace std
+{
+  namespace detail
+  {
+    // cache blocking parameters : a mc x kc panel of A stays in L2, a kc x nc panel of B in L3
+    constexpr size_t gemm_mc = 128;
+    constexpr size_t gemm_kc = 256;
+    constexpr size_t gemm_nc = 2048;
+
+    // products with less multiply-adds than this run on a single thread
+    constexpr size_t gemm_parallel_threshold = 128 * 128 * 128;
+
+    template <typename T>
+    using gemm_kernel_t = void (*)(size_t, const T *, const T *, T *, size_t, size_t, size_t, T, T);
+
+    // packs the mc x kc block of A into row panels of MR rows, padded with zeros
+    template <typename T, size_t MR>
+    void gemm_pack_a(const T *a, size_t lda, size_t mc, size_t kc, T *buf)
+    {
+      for (size_t i = 0; i < mc; i += MR)
+      {
+        const size_t m = std::min(MR, mc - i);
+        for (size_t p = 0; p < kc; ++p)
+        {
+          const T *src = a + p * lda + i;
+          for (size_t ii = 0; ii < m; ++ii)
+            *buf++ = src[ii];
+          for (size_t ii = m; ii < MR; ++ii)
+            *buf++ = T(0);
+        }
+      }
+    }
+
+    // packs the kc x nc block of B into column panels of NR columns, padded with zeros
+    template <typename T, size_t NR>
+    void gemm_pack_b(const T *b, size_t ldb, size_t kc, size_t nc, T *buf)
+    {
+      for (size_t j = 0; j < nc; j += NR)
+      {
+        const size_t n = std::min(NR, nc - j);
+        for (size_t p = 0; p < kc; ++p)
+        {
+          for (size_t jj = 0; jj < n; ++jj)
+            *buf++ = b[(j + jj) * ldb + p];
+          for (size_t jj = n; jj < NR; ++jj)
+            *buf++ = T(0);
+        }
+      }
+    }
+
+    // writes the MR x NR accumulator tile into the m x n block of C
+    template <typename T, size_t MR, size_t NR>
+    SIMD_INLINE void gemm_store(const T (&acc)[NR][MR], T *c, size_t ldc, size_t m, size_t n, T alpha, T beta)
+    {
+      for (size_t j = 0; j < n; ++j)
+      {
+        T *cj = c + j * ldc;
+        if (beta == T(0))
+          for (size_t i = 0; i < m; ++i)
+            cj[i] = alpha * acc[j][i];
+        else
+          for (size_t i = 0; i < m; ++i)
+            cj[i] = alpha * acc[j][i] + beta * cj[i];
+      }
+    }
+
+#ifdef SIMD_VECTOR_EXT
+    // C = alpha * A * B + beta * C on a MR x NR tile, MR being MV vectors of BYTES bytes
+    template <typename T, size_t BYTES, size_t MV, size_t NR>
+    SIMD_INLINE void gemm_micro_kernel(size_t kc, const T *a, const T *b, T *c, size_t ldc, size_t m, size_t n, T alpha, T beta)
+    {
+      typedef typename simd_vec<T, BYTES>::type V;
+      constexpr size_t W = simd_vec<T, BYTES>::width;
+      constexpr size_t MR = W * MV;
+
+      V acc[NR][MV];
+      for (size_t j = 0; j < NR; ++j)
+        for (size_t v = 0; v < MV; ++v)
+          acc[j][v] = V{};
+
+      for (size_t p = 0; p < kc; ++p)
+      {
+        V av[MV];
+        for (size_t v = 0; v < MV; ++v)
+          std::memcpy(&av[v], a + p * MR + v * W, sizeof(V));
+
+#pragma GCC unroll 8
+        for (size_t j = 0; j < NR; ++j)
+        {
+          const V bj = V{} + b[p * NR + j];
+          for (size_t v = 0; v < MV; ++v)
+            acc[j][v] += av[v] * bj;
+        }
+      }
+
+      T out[NR][MR];
+      std::memcpy(out, acc, sizeof(out));
+      gemm_store<T, MR, NR>(out, c, ldc, m, n, alpha, beta);
+    }
+#endif
+
+    // portable version of the micro-kernel
+    template <typename T, size_t MR, size_t NR>
+    inline void gemm_micro_kernel_scalar(size_t kc, const T *a, const T *b, T *c, size_t ldc, size_t m, size_t n, T alpha, T beta)
+    {
+      T acc[NR][MR] = {};
+      for (size_t p = 0; p < kc; ++p)
+        for (size_t j = 0; j < NR; ++j)
+          for (size_t i = 0; i < MR; ++i)
+            acc[j][i] += a[p * MR + i] * b[p * NR + j];
+
+      gemm_store<T, MR, NR>(acc, c, ldc, m, n, alpha, beta);
+    }
+
+    // register blocking of each instruction set
+    template <typename T, simd_isa ISA>
+    struct gemm_config;
+
+    template <typename T>
+    struct gemm_config<T, simd_isa::SCALAR>
+    {
+      static constexpr size_t MR = 4;
+      static constexpr size_t NR = 4;
+      static void kernel(size_t kc, const T *a, const T *b, T *c, size_t ldc, size_t m, size_t n, T alpha, T beta)
+      {
+        gemm_micro_kernel_scalar<T, MR, NR>(kc, a, b, c, ldc, m, n, alpha, beta);
+      }
+    };
+
+#ifdef SIMD_VECTOR_EXT
+    template <typename T>
+    struct gemm_config<T, simd_isa::SSE>
+    {
+      static constexpr size_t MR = 2 * 16 / sizeof(T);
+      static constexpr size_t NR = 4;
+      static void kernel(size_t kc, const T *a, const T *b, T *c, size_t ldc, size_t m, size_t n, T alpha, T beta)
+      {
+        gemm_micro_kernel<T, 16, 2, NR>(kc, a, b, c, ldc, m, n, alpha, beta);
+      }
+    };
+
+    template <typename T>
+    struct gemm_config<T, simd_isa::AVX2>
+    {
+      static constexpr size_t MR = 2 * 32 / sizeof(T);
+      static constexpr size_t NR = 6;
+      SIMD_TARGET_AVX2 static void kernel(size_t kc, const T *a, const T *b, T *c, size_t ldc, size_t m, size_t n, T alpha, T beta)
+      {
+        gemm_micro_kernel<T, 32, 2, NR>(kc, a, b, c, ldc, m, n, alpha, beta);
+      }
+    };
+
+    template <typename T>
+    struct gemm_config<T, simd_isa::AVX512>
+    {
+      static constexpr size_t MR = 2 * 64 / sizeof(T);
+      static constexpr size_t NR = 8;
+      SIMD_TARGET_AVX512 static void kernel(size_t kc, const T *a, const T *b, T *c, size_t ldc, size_t m, size_t n, T alpha, T beta)
+      {
+        gemm_micro_kernel<T, 64, 2, NR>(kc, a, b, c, ldc, m, n, alpha, beta);
+      }
+    };
+#endif
+
+    // single threaded blocked product, the packing buffers are reused across calls
+    template <typename T, simd_isa ISA>
+    void gemm_blocked(size_t m, size_t n, size_t k, T alpha, const T *a, size_t lda, const T *b, size_t ldb, T beta, T *c, size_t ldc)
+    {
+      typedef gemm_config<T, ISA> Config;
+      constexpr size_t MR = Config::MR;
+      constexpr size_t NR = Config::NR;
+
+      thread_local std::vector<T> abuf;
+      thread_local std::vector<T> bbuf;
+      const size_t asize = (std::min(gemm_mc, m) + MR) * std::min(gemm_kc, k);
+      const size_t bsize = (std::min(gemm_nc, n) + NR) * std::min(gemm_kc, k);
+      if (abuf.size() < asize)
+        abuf.resize(asize);
+      if (bbuf.size() < bsize)
+        bbuf.resize(bsize);
+
+      for (size_t jc = 0; jc < n; jc += gemm_nc)
+      {
+        const size_t nc = std::min(gemm_nc, n - jc);
+        for (size_t pc = 0; pc < k; pc += gemm_kc)
+        {
+          const size_t kc = std::min(gemm_kc, k - pc);
+          const T betac = (pc == 0) ? beta : T(1);
+
+          gemm_pack_b<T, NR>(b + jc * ldb + pc, ldb, kc, nc, bbuf.data());
+          for (size_t ic = 0; ic < m; ic += gemm_mc)
+          {
+            const size_t mc = std::min(gemm_mc, m - ic);
+            gemm_pack_a<T, MR>(a + pc * lda + ic, lda, mc, kc, abuf.data());
+
+            for (size_t jr = 0; jr < nc; jr += NR)
+              for (size_t ir = 0; ir < mc; ir += MR)
+                Config::kernel(kc, abuf.data() + ir * kc, bbuf.data() + jr * kc,
+                               c + (jc + jr) * ldc + ic + ir, ldc,
+                               std::min(MR, mc - ir), std::min(NR, nc - jr), alpha, betac);
+          }
+        }
+      }
+    }
+
+    // splits the columns of C across threads for large products
+    template <typename T, simd_isa ISA>
+    void gemm_run(size_t m, size_t n, size_t k, T alpha, const T *a, size_t lda, const T *b, size_t ldb, T beta, T *c, size_t ldc)
+    {
+      constexpr size_t NR = gemm_config<T, ISA>::NR;
+      if (m * n * k < gemm_parallel_threshold)
+      {
+        gemm_blocked<T, ISA>(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+        return;
+      }
+
+      parallel_for(0, n, 4 * NR, [&](size_t j0, size_t j1) {
+        gemm_blocked<T, ISA>(m, j1 - j0, k, alpha, a, lda, b + j0 * ldb, ldb, beta, c + j0 * ldc, ldc);
+      });
+    }
+
+    // reference product for the other element types
+    template <typename T>
+    void gemm_generic(size_t m, size_t n, size_t k, T alpha, const T *a, size_t lda, const T *b, size_t ldb, T beta, T *c, size_t ldc)
+    {
+      for (size_t j = 0; j < n; ++j)
+      {
+        T *cj = c + j * ldc;
+        for (size_t i = 0; i < m; ++i)
+          cj[i] = (beta == T(0)) ? T(0) : beta * cj[i];
+
+        for (size_t p = 0; p < k; ++p)
+        {
+          const T bpj = alpha * b[j * ldb + p];
+          const T *ap = a + p * lda;
+          for (size_t i = 0; i < m; ++i)
+            cj[i] += ap[i] * bpj;
+        }
+      }
+    }
+
+    // c[i] = sum_p a(i, p) * b(p), unrolled over p
+    template <typename T, size_t M, size_t... P>
+    constexpr T dot_fixed(const T *a, const T *b, size_t i, std::index_sequence<P...>)
+    {
+      return ((a[P * M + i] * b[P]) + ...);
+    }
+
+    // unrolled product of fixed size matrices, I enumerates the elements of C
+    template <typename T, size_t M, size_t N, size_t K, size_t... I>
+    constexpr void matmul_fixed(T alpha, const T *a, const T *b, T beta, T *c, std::index_sequence<I...>)
+    {
+      if (beta == T(0))
+        ((c[I] = alpha * dot_fixed<T, M>(a, b + (I / M) * K, I % M, std::make_index_sequence<K>{})), ...);
+      else
+        ((c[I] = alpha * dot_fixed<T, M>(a, b + (I / M) * K, I % M, std::make_index_sequence<K>{}) + beta * c[I]), ...);
+    }
+  }
+
+  /**
+   * @Brief
+   * Computes C = alpha * A * B + beta * C on raw column major matrices, A being m x k, B k x n and C m x n.
+   * lda, ldb and ldc are the distances between two consecutive columns. C must not overlap A or B.
+   * When beta is 0, C is not read.
+   * 
+   * isa selects the micro-kernels, it is clamped to the instruction sets supported by the CPU.
+  **/
+  template <typename T>
+  void gemm(size_t m, size_t n, size_t k, T alpha, const T *a, size_t lda, const T *b, size_t ldb,
+            T beta, T *c, size_t ldc, simd_isa isa = simd_isa_detect())
+  {
+    if (m == 0 || n == 0)
+      return;
+
+    if (k == 0)
+    {
+      detail::gemm_generic(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+      return;
+    }
+
+    if constexpr (std::is_same<T, float>::value || std::is_same<T, double>::value)
+    {
+      switch (std::min(isa, simd_isa_detect()))
+      {
+#ifdef SIMD_VECTOR_EXT
+      case simd_isa::AVX512:
+        detail::gemm_run<T, simd_isa::AVX512>(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+        return;
+      case simd_isa::AVX2:
+        detail::gemm_run<T, simd_isa::AVX2>(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+        return;
+      case simd_isa::SSE:
+        detail::gemm_run<T, simd_isa::SSE>(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+        return;
+#endif
+      default:
+        detail::gemm_run<T, simd_isa::SCALAR>(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+        return;
+      }
+    }
+    else
+      detail::gemm_generic(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+  }
+
+  /**
+   * @Brief
+   * Computes C = alpha * A * B + beta * C. C must not be A or B.
+   * If the dimensions do not match, an exception of type std::length_error is thrown.
+  **/
+  template <typename A, typename B, typename C>
+  void gemm(typename C::value_type alpha, const A &a, const B &b, typename C::value_type beta, C &c)
+  {
+    if (a.num_col() != b.num_row() || c.num_row() != a.num_row() || c.num_col() != b.num_col())
+      throw std::length_error("gemm : dimension mismatch");
+
+    gemm(a.num_row(), b.num_col(), a.num_col(), alpha, a.data(), detail::leading_dim(a),
+         b.data(), detail::leading_dim(b), beta, c.data(), detail::leading_dim(c));
+  }
+
+  template <typename T, size_t M, size_t N, size_t K, typename = std::enable_if_t<(M <= 4 && N <= 4 && K <= 4)>>
+  void gemm(typename array2d<T, N, M>::value_type alpha, const array2d<T, K, M> &a, const array2d<T, N, K> &b,
+            typename array2d<T, N, M>::value_type beta, array2d<T, N, M> &c)
+  {
+    detail::matmul_fixed<T, M, N, K>(alpha, a.data(), b.data(), beta, c.data(), std::make_index_sequence<M * N>{});
+  }
+
+  /**
+   * @Brief
+   * Computes C = A * B. C must not be A or B.
+   * A vector2d C is resized, otherwise if the dimensions do not match, an exception of type std::length_error is thrown.
+  **/
+  template <typename A, typename B, typename C>
+  void matmul(const A &a, const B &b, C &c)
+  {
+    typedef typename C::value_type T;
+    if constexpr (std::is_same<C, vector2d<T>>::value)
+    {
+      if (c.num_row() != a.num_row() || c.num_col() != b.num_col())
+        c.resize(b.num_col(), a.num_row());
+    }
+
+    gemm(T(1), a, b, T(0), c);
+  }
+}
+
+#endif
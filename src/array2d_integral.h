@@ -0,0 +1,196 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __ARRAY_2D_INTEGRAL__
+#define __ARRAY_2D_INTEGRAL__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+#include "array2d.h"
+#include "array2d_expr.h"
+#include "array2d_view.h"
+#include "parallel.h"
+#include "vector2d.h"
+
+/**
+ * @Brief
+ * Summed-area tables (integral images) of 2d arrays and O(1) sums over rectangles.
+ * 
+ * The table of a nc x nr array has (nc + 1) x (nr + 1) elements, sat(c, r) being the sum of the
+ * elements of the rectangle [0, c) x [0, r), so that the first row and column are zeros and a
+ * rectangle sum never needs a special case on the borders.
+ * The table is built with two parallel passes : a prefix sum down each column, then a prefix sum
+ * along the rows, processed by blocks of rows so that the inner loop runs over contiguous memory.
+ * 
+ * Sums are accumulated in a wider type : 64 bits integers for integer types, double for float.
+ * 
+ * example:
+ * -------
+ * std::vector2d<uint8_t> img(1920, 1080);
+ * std::vector2d<uint64_t> sat;
+ * std::integral_image(img, sat);                     // sat is 1921 x 1081
+ * uint64_t s = std::rect_sum(sat, 10, 20, 42, 52);   // sum of img over [10, 42) x [20, 52)
+ * 
+ * std::vector<std::rect2d> rects = ...;
+ * std::vector<uint64_t> sums(rects.size());
+ * std::rect_sum(sat, rects.data(), rects.size(), sums.data());
+ */
+
+namespace std
+{
+  /**
+   * @Brief
+   * The rectangle [c0, c1) x [r0, r1) of a 2d array.
+  **/
+  struct rect2d
+  {
+    size_t c0;
+    size_t r0;
+    size_t c1;
+    size_t r1;
+  };
+
+  namespace detail
+  {
+    template <typename T>
+    using integral_acc_t = std::conditional_t<std::is_integral<T>::value,
+                                              std::conditional_t<std::is_signed<T>::value, std::int64_t, std::uint64_t>,
+                                              std::conditional_t<std::is_same<T, float>::value, double, T>>;
+
+    // number of rows per block in the pass along the rows
+    constexpr size_t integral_block = 1024;
+
+    // number of queries per thread in a batch
+    constexpr size_t integral_grain = 4096;
+  }
+
+  /**
+   * @Brief
+   * Builds the summed-area table dst of src : dst(c, r) is the sum of src over [0, c) x [0, r).
+   * dst must be (src.num_col() + 1) x (src.num_row() + 1), a vector2d destination is resized,
+   * otherwise if the dimensions of dst do not match, an exception of type std::length_error is thrown.
+   * The element type of dst is used as accumulator, see detail::integral_acc_t for the recommended one.
+  **/
+  template <typename A, typename B>
+  void integral_image(const A &src, B &dst)
+  {
+    typedef typename B::value_type Acc;
+
+    const size_t nc = src.num_col();
+    const size_t nr = src.num_row();
+
+    if constexpr (std::is_same<B, vector2d<Acc>>::value)
+    {
+      if (dst.num_col() != nc + 1 || dst.num_row() != nr + 1)
+        dst.resize(nc + 1, nr + 1);
+    }
+
+    if (dst.num_col() != nc + 1 || dst.num_row() != nr + 1)
+      throw std::length_error("integral_image : dimension mismatch");
+
+    const size_t lds = detail::leading_dim(src);
+    const size_t ldd = detail::leading_dim(dst);
+    const auto *in = src.data();
+    Acc *out = dst.data();
+
+    std::fill_n(out, nr + 1, Acc(0));
+
+    // prefix sums down the columns, dst(c + 1, r + 1) = sum of src(c, 0..r)
+    parallel_for(0, nc, 64, [&](size_t begin, size_t end) {
+      for (size_t c = begin; c < end; ++c)
+      {
+        const auto *s = in + c * lds;
+        Acc *d = out + (c + 1) * ldd;
+        Acc sum = Acc(0);
+        d[0] = sum;
+        for (size_t r = 0; r < nr; ++r)
+        {
+          sum += Acc(s[r]);
+          d[r + 1] = sum;
+        }
+      }
+    });
+
+    // prefix sums along the rows, each block of rows being swept from the first column to the last
+    parallel_for(1, nr + 1, detail::integral_block, [&](size_t begin, size_t end) {
+      for (size_t r0 = begin; r0 < end; r0 += detail::integral_block)
+      {
+        const size_t r1 = std::min(r0 + detail::integral_block, end);
+        for (size_t c = 1; c < nc; ++c)
+        {
+          const Acc *p = out + c * ldd;
+          Acc *d = out + (c + 1) * ldd;
+          ARRAY2D_VECTORIZE
+          for (size_t r = r0; r < r1; ++r)
+            d[r] += p[r];
+        }
+      }
+    });
+  }
+
+  /**
+   * @Brief
+   * Returns the sum of the source elements over [c0, c1) x [r0, r1), sat being its summed-area table.
+   * No bounds checking is performed, c0 <= c1 <= sat.num_col() - 1 and r0 <= r1 <= sat.num_row() - 1.
+  **/
+  template <typename A>
+  inline typename A::value_type rect_sum(const A &sat, size_t c0, size_t r0, size_t c1, size_t r1) noexcept
+  {
+    const size_t ld = detail::leading_dim(sat);
+    const auto *s = sat.data();
+    return s[c1 * ld + r1] - s[c0 * ld + r1] - s[c1 * ld + r0] + s[c0 * ld + r0];
+  }
+
+  /**
+   * @Brief
+   * Computes the sums of the source elements over the n rectangles rects into out, sat being its summed-area table.
+   * All the rectangles are checked before any sum is computed, if one of them is not within the range of the
+   * source, an exception of type std::out_of_range is thrown. Large batches are processed in parallel.
+  **/
+  template <typename A>
+  void rect_sum(const A &sat, const rect2d *rects, size_t n, typename A::value_type *out)
+  {
+    const size_t nc = sat.num_col() - 1;
+    const size_t nr = sat.num_row() - 1;
+
+    // a single branch for the whole batch
+    bool valid = sat.num_col() > 0 && sat.num_row() > 0;
+    for (size_t i = 0; i < n; ++i)
+      valid &= (rects[i].c0 <= rects[i].c1) & (rects[i].c1 <= nc) & (rects[i].r0 <= rects[i].r1) & (rects[i].r1 <= nr);
+    if (!valid)
+      throw std::out_of_range("rect_sum");
+
+    parallel_for(0, n, detail::integral_grain, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i)
+        out[i] = rect_sum(sat, rects[i].c0, rects[i].r0, rects[i].c1, rects[i].r1);
+    });
+  }
+}
+
+#endif
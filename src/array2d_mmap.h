@@ -0,0 +1,479 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __ARRAY_2D_MMAP__
+#define __ARRAY_2D_MMAP__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#if defined(_WIN32)
+#error "array2d_mmap.h relies on POSIX mmap and is not available on Windows"
+#endif
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "array2d_view.h"
+#include "vector2d.h"
+
+/**
+ * @Brief
+ * 2d arrays stored in a binary file and memory mapped.
+ * 
+ * The file starts with a 64 bytes header (magic, version, element type, element size, layout,
+ * dimensions and data offset) followed by the raw elements. Opening a file only maps it: pages
+ * are loaded by the OS when they are first accessed, which makes opening O(1) whatever the size.
+ * 
+ * The mapped elements are exposed through a vector2d wrapping the mapping, so that everything
+ * that works on a vector2d works on a mapped file.
+ * 
+ * modes:
+ * -----
+ * READ_ONLY     : the mapping is read only, the only mode of a mapped_array2d<const T>.
+ * READ_WRITE    : writes go through to the file.
+ * COPY_ON_WRITE : writes are private to the process and never reach the file (default).
+ * 
+ * Read only access is part of the type : a mapped_array2d<const T> only hands out const
+ * references, so writing through it does not compile.
+ * 
+ * example:
+ * -------
+ * std::mapped_array2d<float> out = std::mapped_array2d<float>::create("dem.a2d", 40000, 40000);
+ * out(10, 20) = 1.f;
+ * 
+ * std::mapped_array2d<const float> in("dem.a2d");
+ * float s = std::sum(in.array());
+ * float v = in(10, 20);
+ */
+
+namespace std
+{
+  //============================================
+  //              File Format
+  //============================================
+  enum class array2d_type : std::uint32_t
+  {
+    CUSTOM = 0,
+    INT8 = 1,
+    UINT8 = 2,
+    INT16 = 3,
+    UINT16 = 4,
+    INT32 = 5,
+    UINT32 = 6,
+    INT64 = 7,
+    UINT64 = 8,
+    FLOAT32 = 9,
+    FLOAT64 = 10
+  };
+
+  enum class array2d_layout : std::uint32_t
+  {
+    COL_MAJOR = 0,
+    ROW_MAJOR = 1
+  };
+
+  /**
+   * @Brief
+   * Returns the type tag stored in the file header for elements of type T.
+   * Types that are not listed are stored as CUSTOM and only checked by size.
+  **/
+  template <typename T>
+  constexpr array2d_type array2d_type_of() noexcept
+  {
+    if constexpr (std::is_same<T, std::int8_t>::value)
+      return array2d_type::INT8;
+    else if constexpr (std::is_same<T, std::uint8_t>::value)
+      return array2d_type::UINT8;
+    else if constexpr (std::is_same<T, std::int16_t>::value)
+      return array2d_type::INT16;
+    else if constexpr (std::is_same<T, std::uint16_t>::value)
+      return array2d_type::UINT16;
+    else if constexpr (std::is_same<T, std::int32_t>::value)
+      return array2d_type::INT32;
+    else if constexpr (std::is_same<T, std::uint32_t>::value)
+      return array2d_type::UINT32;
+    else if constexpr (std::is_same<T, std::int64_t>::value)
+      return array2d_type::INT64;
+    else if constexpr (std::is_same<T, std::uint64_t>::value)
+      return array2d_type::UINT64;
+    else if constexpr (std::is_same<T, float>::value)
+      return array2d_type::FLOAT32;
+    else if constexpr (std::is_same<T, double>::value)
+      return array2d_type::FLOAT64;
+    else
+      return array2d_type::CUSTOM;
+  }
+
+  struct array2d_file_header
+  {
+    static constexpr char MAGIC[8] = {'A', 'R', 'R', 'A', 'Y', '2', 'D', '\0'};
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr std::uint32_t ENDIAN_MARK = 0x01020304; // reads differently on a machine of the other endianness
+    static constexpr std::uint64_t DATA_OFFSET = 64;
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    array2d_type type;
+    std::uint32_t elemSize;
+    array2d_layout layout;
+    std::uint32_t reserved;
+    std::uint64_t ncol;
+    std::uint64_t nrow;
+    std::uint64_t offset; // position of the first element from the start of the file
+    std::uint64_t padding;
+
+    template <typename T>
+    static array2d_file_header make(std::uint64_t ncol, std::uint64_t nrow, array2d_layout layout = array2d_layout::COL_MAJOR)
+    {
+      array2d_file_header h;
+      std::memset(&h, 0, sizeof(h));
+      std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+      h.version = VERSION;
+      h.byteOrder = ENDIAN_MARK;
+      h.type = array2d_type_of<T>();
+      h.elemSize = sizeof(T);
+      h.layout = layout;
+      h.ncol = ncol;
+      h.nrow = nrow;
+      h.offset = DATA_OFFSET;
+      return h;
+    }
+
+    // size in bytes of the file holding a col x row array of elements of elemSize bytes,
+    // 0 if it does not fit in 64 bits
+    static std::uint64_t file_size(std::uint64_t col, std::uint64_t row, std::uint64_t elemSize, std::uint64_t offset = DATA_OFFSET) noexcept
+    {
+      const std::uint64_t room = ~std::uint64_t(0) - offset;
+      if (col != 0 && row != 0 && (row > room / elemSize || col > room / elemSize / row))
+        return 0;
+      return offset + col * row * elemSize;
+    }
+
+    // true if a file of size bytes holds all the elements described by the header, computed without overflow
+    bool fits(std::uint64_t size) const noexcept
+    {
+      if (offset > size || elemSize == 0)
+        return false;
+      const std::uint64_t room = (size - offset) / elemSize;
+      return ncol == 0 || nrow == 0 || (nrow <= room && ncol <= room / nrow);
+    }
+
+    // throws std::runtime_error if the header cannot describe an array of T
+    template <typename T>
+    void check(const std::string &path) const
+    {
+      if (std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+        throw std::runtime_error("array2d file \"" + path + "\" : bad magic number");
+      if (version != VERSION)
+        throw std::runtime_error("array2d file \"" + path + "\" : unsupported version");
+      if (byteOrder != ENDIAN_MARK)
+        throw std::runtime_error("array2d file \"" + path + "\" : written on a machine of different endianness");
+      if (type != array2d_type_of<T>() || elemSize != sizeof(T))
+        throw std::runtime_error("array2d file \"" + path + "\" : element type mismatch");
+      if (offset < sizeof(array2d_file_header) || offset % alignof(T) != 0)
+        throw std::runtime_error("array2d file \"" + path + "\" : invalid data offset");
+    }
+  };
+
+  static_assert(sizeof(array2d_file_header) == 64, "array2d_file_header must be 64 bytes");
+
+  //============================================
+  //              Mapped Array
+  //============================================
+  template <typename T>
+  class mapped_array2d
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "mapped_array2d requires trivially copyable elements");
+
+  public:
+    enum MODE
+    {
+      READ_ONLY = 0,
+      READ_WRITE = 1,
+      COPY_ON_WRITE = 2
+    };
+
+    typedef std::remove_const_t<T> value_type;
+    typedef T &reference;
+    typedef const value_type &const_reference;
+    typedef T *pointer;
+    typedef const value_type *const_pointer;
+    typedef std::conditional_t<std::is_const<T>::value, const vector2d<value_type>, vector2d<value_type>> array_type;
+
+    static constexpr bool read_only = std::is_const<T>::value;
+
+  public:
+    mapped_array2d() noexcept
+        : mBase(nullptr), mBytes(0), mMode(READ_ONLY)
+    {
+    }
+
+    /**
+   * @Brief
+   * Maps an existing array2d file. Only the header is read, the elements are loaded on access.
+   * If the file cannot be opened or does not hold a column major array of T, an exception of type
+   * std::runtime_error is thrown.
+   * A mapped_array2d<const T> only accepts READ_ONLY and a mapped_array2d<T> only accepts the
+   * writable modes, otherwise an exception of type std::invalid_argument is thrown.
+  **/
+    explicit mapped_array2d(const std::string &path, MODE mode = read_only ? READ_ONLY : COPY_ON_WRITE)
+        : mBase(nullptr), mBytes(0), mMode(mode)
+    {
+      if ((mode == READ_ONLY) != read_only)
+        throw std::invalid_argument(read_only ? "mapped_array2d<const T> : the mapping must be READ_ONLY"
+                                              : "mapped_array2d<T> : use mapped_array2d<const T> for READ_ONLY mappings");
+
+      int fd = ::open(path.c_str(), (mode == READ_WRITE) ? O_RDWR : O_RDONLY);
+      if (fd < 0)
+        throw std::runtime_error("array2d file \"" + path + "\" : unable to open");
+
+      struct stat st;
+      array2d_file_header header;
+      if (::fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(header) ||
+          ::pread(fd, &header, sizeof(header), 0) != ssize_t(sizeof(header)))
+      {
+        ::close(fd);
+        throw std::runtime_error("array2d file \"" + path + "\" : unable to read the header");
+      }
+
+      try
+      {
+        header.check<value_type>(path);
+        if (header.layout != array2d_layout::COL_MAJOR)
+          throw std::runtime_error("array2d file \"" + path + "\" : row major files cannot be mapped, see from_row_major()");
+        if (!header.fits(std::uint64_t(st.st_size)))
+          throw std::runtime_error("array2d file \"" + path + "\" : truncated file");
+      }
+      catch (...)
+      {
+        ::close(fd);
+        throw;
+      }
+
+      map(fd, size_t(header.offset + header.ncol * header.nrow * sizeof(value_type)), mode, path);
+      ::close(fd);
+
+      mArray = vector2d<value_type>(reinterpret_cast<value_type *>(static_cast<char *>(mBase) + header.offset), header.ncol, header.nrow);
+    }
+
+    /**
+   * @Brief
+   * Creates (or truncates) the file at path to hold a col x row array and maps it in READ_WRITE mode.
+   * The elements are zero initialized without being written to disk.
+  **/
+    static mapped_array2d create(const std::string &path, size_t col, size_t row)
+    {
+      static_assert(!read_only, "mapped_array2d<const T> cannot create a file");
+
+      const array2d_file_header header = array2d_file_header::make<value_type>(col, row);
+      const std::uint64_t bytes = array2d_file_header::file_size(col, row, sizeof(value_type));
+      if (bytes == 0)
+        throw std::length_error("array2d file \"" + path + "\" : the array is too large");
+
+      int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+      if (fd < 0)
+        throw std::runtime_error("array2d file \"" + path + "\" : unable to create");
+
+      if (::ftruncate(fd, off_t(bytes)) != 0 || ::pwrite(fd, &header, sizeof(header), 0) != ssize_t(sizeof(header)))
+      {
+        ::close(fd);
+        throw std::runtime_error("array2d file \"" + path + "\" : unable to write the header");
+      }
+      ::close(fd);
+
+      return mapped_array2d(path, READ_WRITE);
+    }
+
+    mapped_array2d(const mapped_array2d &) = delete;
+    mapped_array2d &operator=(const mapped_array2d &) = delete;
+
+    mapped_array2d(mapped_array2d &&other) noexcept
+        : mBase(other.mBase), mBytes(other.mBytes), mMode(other.mMode), mArray(std::move(other.mArray))
+    {
+      other.mBase = nullptr;
+      other.mBytes = 0;
+    }
+
+    mapped_array2d &operator=(mapped_array2d &&other) noexcept
+    {
+      if (this != &other)
+      {
+        close();
+        mBase = other.mBase;
+        mBytes = other.mBytes;
+        mMode = other.mMode;
+        mArray = std::move(other.mArray);
+        other.mBase = nullptr;
+        other.mBytes = 0;
+      }
+      return *this;
+    }
+
+    virtual ~mapped_array2d()
+    {
+      close();
+    }
+
+    //============================================
+    //                Data Access
+    //============================================
+    /**
+   * @Brief
+   * Returns a vector2d wrapping the mapped elements. It does not own them and must not outlive
+   * the mapped_array2d. Resizing it detaches it from the file.
+   * For a mapped_array2d<const T> every accessor is const.
+  **/
+    array_type &array() noexcept { return mArray; }
+    const vector2d<value_type> &array() const noexcept { return mArray; }
+    const vector2d<value_type> &view() const noexcept { return mArray; }
+
+    reference operator()(size_t col, size_t row) noexcept { return mArray(col, row); }
+    const_reference operator()(size_t col, size_t row) const noexcept { return mArray(col, row); }
+
+    reference at(size_t col, size_t row) { return mArray.at(col, row); }
+    const_reference at(size_t col, size_t row) const { return mArray.at(col, row); }
+
+    pointer data() noexcept { return mArray.data(); }
+    const_pointer data() const noexcept { return mArray.data(); }
+
+    inline size_t num_col() const noexcept { return mArray.num_col(); }
+    inline size_t num_row() const noexcept { return mArray.num_row(); }
+    inline size_t num() const noexcept { return mArray.num(); }
+    inline bool empty() const noexcept { return mArray.empty(); }
+
+    inline MODE mode() const noexcept { return mMode; }
+    inline bool is_open() const noexcept { return mBase != nullptr; }
+
+    //============================================
+    //                operations
+    //============================================
+    /**
+   * @Brief
+   * Writes the modified pages back to the file and waits for the write to complete.
+   * Does nothing for READ_ONLY and COPY_ON_WRITE mappings.
+  **/
+    void flush()
+    {
+      if (mBase != nullptr && mMode == READ_WRITE && ::msync(mBase, mBytes, MS_SYNC) != 0)
+        throw std::runtime_error("mapped_array2d::flush : msync failed");
+    }
+
+    /**
+   * @Brief
+   * Hints the OS about the upcoming access pattern of the elements.
+  **/
+    void advise_sequential() const noexcept
+    {
+      if (mBase != nullptr)
+        ::madvise(mBase, mBytes, MADV_SEQUENTIAL);
+    }
+
+    void advise_random() const noexcept
+    {
+      if (mBase != nullptr)
+        ::madvise(mBase, mBytes, MADV_RANDOM);
+    }
+
+    /**
+   * @Brief
+   * Unmaps the file. Pending writes of a READ_WRITE mapping are written back by the OS.
+  **/
+    void close() noexcept
+    {
+      if (mBase != nullptr)
+        ::munmap(mBase, mBytes);
+      mBase = nullptr;
+      mBytes = 0;
+      mArray = vector2d<value_type>();
+    }
+
+  protected:
+    void map(int fd, size_t bytes, MODE mode, const std::string &path)
+    {
+      const int prot = (mode == READ_ONLY) ? PROT_READ : (PROT_READ | PROT_WRITE);
+      const int flags = (mode == READ_WRITE) ? MAP_SHARED : MAP_PRIVATE;
+
+      void *base = ::mmap(nullptr, bytes, prot, flags, fd, 0);
+      if (base == MAP_FAILED)
+      {
+        ::close(fd);
+        throw std::runtime_error("array2d file \"" + path + "\" : mmap failed");
+      }
+
+      mBase = base;
+      mBytes = bytes;
+    }
+
+  protected:
+    void *mBase;         // start of the mapping, i.e. of the header
+    size_t mBytes;       // size of the mapping
+    MODE mMode;          // access mode of the mapping
+    vector2d<value_type> mArray;  // non-owning wrapper over the mapped elements
+  };
+
+  //============================================
+  //              Writing
+  //============================================
+  /**
+   * @Brief
+   * Writes the 2d array a (array2d, vector2d or view) to an array2d file, one column at a time.
+   * If the file cannot be written, an exception of type std::runtime_error is thrown.
+  **/
+  template <typename A>
+  void save_array2d(const std::string &path, const A &a)
+  {
+    typedef std::remove_cv_t<std::remove_reference_t<decltype(*a.data())>> T;
+    static_assert(std::is_trivially_copyable<T>::value, "save_array2d requires trivially copyable elements");
+
+    FILE *f = std::fopen(path.c_str(), "wb");
+    if (f == nullptr)
+      throw std::runtime_error("array2d file \"" + path + "\" : unable to create");
+
+    const array2d_file_header header = array2d_file_header::make<T>(a.num_col(), a.num_row());
+    bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1;
+
+    const size_t ld = detail::leading_dim(a);
+    if (ok && ld == a.num_row())
+      ok = std::fwrite(a.data(), sizeof(T), a.num_col() * a.num_row(), f) == a.num_col() * a.num_row();
+    else
+      for (size_t c = 0; ok && c < a.num_col(); ++c)
+        ok = std::fwrite(a.data() + c * ld, sizeof(T), a.num_row(), f) == a.num_row();
+
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok)
+      throw std::runtime_error("array2d file \"" + path + "\" : write failed");
+  }
+}
+
+#endif
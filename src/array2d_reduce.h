@@ -0,0 +1,492 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __ARRAY_2D_REDUCE__
+#define __ARRAY_2D_REDUCE__
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "array2d.h"
+#include "array2d_view.h"
+#include "parallel.h"
+#include "vector2d.h"
+
+/**
+ * @Brief
+ * Reductions over the elements of 2d arrays (array2d, vector2d and block views).
+ * 
+ * Columns are reduced with several independent accumulators so that the compiler can vectorize
+ * the loops without reordering floating point operations. Large arrays are cut into blocks of
+ * columns whose size does not depend on the number of threads, the blocks are reduced in parallel
+ * and the partial results are combined in block order: results are identical from run to run.
+ * 
+ * Integer sums are accumulated on 64 bits.
+ * 
+ * example:
+ * -------
+ * std::vector2d<float> a(1920, 1080);
+ * float s = std::sum(a);
+ * std::array<size_t, 2> cr = std::argmax(a);   // {col, row}
+ * std::vector<float> rs = std::sum_rows(a);    // one value per row
+ */
+
+namespace std
+{
+  namespace detail
+  {
+    // number of independent accumulators used to reduce a column
+    constexpr size_t reduce_lanes = 16;
+
+    // number of elements per block when splitting the array across threads
+    constexpr size_t reduce_block = 1 << 16;
+
+    template <typename T>
+    using reduce_acc_t = std::conditional_t<std::is_integral<T>::value,
+                                            std::conditional_t<std::is_signed<T>::value, std::int64_t, std::uint64_t>,
+                                            T>;
+
+    // sum of f(x[i]) for i in [0, n)
+    template <typename Acc, typename T, typename F>
+    inline Acc lane_sum(const T *x, size_t n, F f)
+    {
+      Acc lanes[reduce_lanes] = {};
+      size_t i = 0;
+      for (; i + reduce_lanes <= n; i += reduce_lanes)
+        for (size_t l = 0; l < reduce_lanes; ++l)
+          lanes[l] += f(x[i + l]);
+
+      Acc s = Acc(0);
+      for (; i < n; ++i)
+        s += f(x[i]);
+      for (size_t l = 0; l < reduce_lanes; ++l)
+        s += lanes[l];
+      return s;
+    }
+
+    // sum of x[i] * y[i] for i in [0, n)
+    template <typename Acc, typename T>
+    inline Acc lane_dot(const T *x, const T *y, size_t n)
+    {
+      Acc lanes[reduce_lanes] = {};
+      size_t i = 0;
+      for (; i + reduce_lanes <= n; i += reduce_lanes)
+        for (size_t l = 0; l < reduce_lanes; ++l)
+          lanes[l] += Acc(x[i + l]) * Acc(y[i + l]);
+
+      Acc s = Acc(0);
+      for (; i < n; ++i)
+        s += Acc(x[i]) * Acc(y[i]);
+      for (size_t l = 0; l < reduce_lanes; ++l)
+        s += lanes[l];
+      return s;
+    }
+
+    // reduction of f(x[i]) for i in [0, n) with the selection cmp(a, b) ? a : b, n must be > 0
+    template <typename T, typename F, typename Cmp>
+    inline auto lane_select(const T *x, size_t n, F f, Cmp cmp)
+    {
+      typedef decltype(f(x[0])) R;
+      R lanes[reduce_lanes];
+      for (size_t l = 0; l < reduce_lanes; ++l)
+        lanes[l] = f(x[0]);
+
+      size_t i = 0;
+      for (; i + reduce_lanes <= n; i += reduce_lanes)
+        for (size_t l = 0; l < reduce_lanes; ++l)
+        {
+          const R v = f(x[i + l]);
+          lanes[l] = cmp(v, lanes[l]) ? v : lanes[l];
+        }
+
+      R s = lanes[0];
+      for (; i < n; ++i)
+      {
+        const R v = f(x[i]);
+        s = cmp(v, s) ? v : s;
+      }
+      for (size_t l = 0; l < reduce_lanes; ++l)
+        s = cmp(lanes[l], s) ? lanes[l] : s;
+      return s;
+    }
+
+    struct reduce_less
+    {
+      template <typename T>
+      inline bool operator()(const T &a, const T &b) const { return a < b; }
+    };
+
+    struct reduce_greater
+    {
+      template <typename T>
+      inline bool operator()(const T &a, const T &b) const { return b < a; }
+    };
+
+    struct reduce_identity
+    {
+      template <typename T>
+      inline T operator()(const T &x) const { return x; }
+    };
+
+    struct reduce_abs
+    {
+      template <typename T>
+      inline T operator()(const T &x) const { return (x < T(0)) ? T(-x) : x; }
+    };
+
+    /**
+     * Reduces the columns of a : col(r, ptr, c) accumulates column c into r, then the partial
+     * results of the blocks of columns are merged in order with combine(r, partial).
+    **/
+    template <typename R, typename A, typename Col, typename Combine>
+    R reduce_columns(const A &a, const R &init, Col col, Combine combine)
+    {
+      const size_t ncol = a.num_col();
+      const size_t nrow = a.num_row();
+      const size_t ld = leading_dim(a);
+      const auto *ptr = a.data();
+
+      const size_t colPerBlock = std::max<size_t>(1, reduce_block / std::max<size_t>(nrow, 1));
+      const size_t nblock = (ncol + colPerBlock - 1) / colPerBlock;
+      if (nblock <= 1)
+      {
+        R r = init;
+        for (size_t c = 0; c < ncol; ++c)
+          col(r, ptr + c * ld, c);
+        return r;
+      }
+
+      std::vector<R> partial(nblock, init);
+      parallel_for(0, nblock, 1, [&](size_t b0, size_t b1) {
+        for (size_t b = b0; b < b1; ++b)
+        {
+          const size_t cend = std::min(ncol, (b + 1) * colPerBlock);
+          for (size_t c = b * colPerBlock; c < cend; ++c)
+            col(partial[b], ptr + c * ld, c);
+        }
+      });
+
+      R r = partial[0];
+      for (size_t b = 1; b < nblock; ++b)
+        combine(r, partial[b]);
+      return r;
+    }
+
+    template <typename A>
+    using reduce_value_t = std::remove_cv_t<std::remove_reference_t<decltype(*std::declval<const A &>().data())>>;
+
+    // location and value of the first element selected by cmp
+    template <typename A, typename Cmp>
+    std::array<size_t, 2> arg_select(const A &a, Cmp cmp, const char *name)
+    {
+      typedef reduce_value_t<A> T;
+      struct Loc
+      {
+        T value;
+        size_t col;
+        size_t row;
+        bool valid;
+      };
+
+      if (a.num_col() * a.num_row() == 0)
+        throw std::length_error(name);
+
+      const size_t nrow = a.num_row();
+      Loc loc = reduce_columns(
+          a, Loc{T(), 0, 0, false},
+          [nrow, cmp](Loc &l, const T *x, size_t c) {
+            const T v = lane_select(x, nrow, reduce_identity(), cmp);
+            if (!l.valid || cmp(v, l.value))
+            {
+              // the first occurrence of v, v might be a NaN read from the first row
+              size_t r = 0;
+              while (r < nrow && !(x[r] == v))
+                ++r;
+              l = Loc{v, c, (r < nrow) ? r : 0, true};
+            }
+          },
+          [cmp](Loc &l, const Loc &p) {
+            if (p.valid && (!l.valid || cmp(p.value, l.value)))
+              l = p;
+          });
+
+      return {loc.col, loc.row};
+    }
+
+    // reduces each row of a with op, the columns being traversed in order
+    template <typename R, typename A, typename Op>
+    std::vector<R> reduce_each_row(const A &a, Op op)
+    {
+      const size_t nrow = a.num_row();
+      const size_t ld = leading_dim(a);
+      const auto *ptr = a.data();
+
+      std::vector<R> out(nrow);
+      if (a.num_col() == 0)
+        return out;
+
+      // each thread reduces a band of rows over all the columns
+      const size_t grain = std::max<size_t>(1024, reduce_block / std::max<size_t>(a.num_col(), 1));
+      parallel_for(0, nrow, grain, [&](size_t r0, size_t r1) {
+        for (size_t r = r0; r < r1; ++r)
+          out[r] = R(ptr[r]);
+
+        for (size_t c = 1; c < a.num_col(); ++c)
+        {
+          const auto *x = ptr + c * ld;
+          for (size_t r = r0; r < r1; ++r)
+            out[r] = op(out[r], R(x[r]));
+        }
+      });
+      return out;
+    }
+
+    // reduces each column of a with f(column, nrow)
+    template <typename R, typename A, typename F>
+    std::vector<R> reduce_each_col(const A &a, F f)
+    {
+      const size_t ncol = a.num_col();
+      const size_t nrow = a.num_row();
+      const size_t ld = leading_dim(a);
+      const auto *ptr = a.data();
+
+      std::vector<R> out(ncol);
+      const size_t grain = std::max<size_t>(1, reduce_block / std::max<size_t>(nrow, 1));
+      parallel_for(0, ncol, grain, [&](size_t c0, size_t c1) {
+        for (size_t c = c0; c < c1; ++c)
+          out[c] = f(ptr + c * ld, nrow);
+      });
+      return out;
+    }
+  }
+
+  //============================================
+  //              Whole Array
+  //============================================
+  /**
+   * @Brief
+   * Returns the sum of the elements of the array. Integer elements are summed on 64 bits.
+  **/
+  template <typename A, typename = detail::enable_2d_array<A>>
+  auto sum(const A &a)
+  {
+    typedef detail::reduce_value_t<A> T;
+    typedef detail::reduce_acc_t<T> Acc;
+
+    const size_t nrow = a.num_row();
+    return detail::reduce_columns(
+        a, Acc(0),
+        [nrow](Acc &s, const T *x, size_t) { s += detail::lane_sum<Acc>(x, nrow, detail::reduce_identity()); },
+        [](Acc &s, const Acc &p) { s += p; });
+  }
+
+  /**
+   * @Brief
+   * Returns the average of the elements of the array, as a double for integer elements.
+  **/
+  template <typename A, typename = detail::enable_2d_array<A>>
+  auto mean(const A &a)
+  {
+    typedef std::conditional_t<std::is_integral<detail::reduce_value_t<A>>::value, double, detail::reduce_value_t<A>> R;
+    return R(sum(a)) / R(a.num_col() * a.num_row());
+  }
+
+  /**
+   * @Brief
+   * Returns the smallest and largest elements of the array.
+   * If the array is empty, an exception of type std::length_error is thrown.
+  **/
+  template <typename A, typename = detail::enable_2d_array<A>>
+  auto minimum(const A &a)
+  {
+    const std::array<size_t, 2> loc = detail::arg_select(a, detail::reduce_less(), "minimum : empty array");
+    return a.data()[loc[0] * detail::leading_dim(a) + loc[1]];
+  }
+
+  template <typename A, typename = detail::enable_2d_array<A>>
+  auto maximum(const A &a)
+  {
+    const std::array<size_t, 2> loc = detail::arg_select(a, detail::reduce_greater(), "maximum : empty array");
+    return a.data()[loc[0] * detail::leading_dim(a) + loc[1]];
+  }
+
+  /**
+   * @Brief
+   * Returns the location {col, row} of the smallest and largest elements of the array.
+   * Ties are resolved by picking the first element in column major order.
+   * If the array is empty, an exception of type std::length_error is thrown.
+  **/
+  template <typename A, typename = detail::enable_2d_array<A>>
+  std::array<size_t, 2> argmin(const A &a)
+  {
+    return detail::arg_select(a, detail::reduce_less(), "argmin : empty array");
+  }
+
+  template <typename A, typename = detail::enable_2d_array<A>>
+  std::array<size_t, 2> argmax(const A &a)
+  {
+    return detail::arg_select(a, detail::reduce_greater(), "argmax : empty array");
+  }
+
+  /**
+   * @Brief
+   * Returns the L1 norm (sum of absolute values), the L2 norm (square root of the sum of squares)
+   * and the Linf norm (largest absolute value) of the array.
+  **/
+  template <typename A, typename = detail::enable_2d_array<A>>
+  auto norm_l1(const A &a)
+  {
+    typedef detail::reduce_value_t<A> T;
+    typedef detail::reduce_acc_t<T> Acc;
+
+    const size_t nrow = a.num_row();
+    return detail::reduce_columns(
+        a, Acc(0),
+        [nrow](Acc &s, const T *x, size_t) { s += detail::lane_sum<Acc>(x, nrow, [](const T &v) { return Acc(detail::reduce_abs()(v)); }); },
+        [](Acc &s, const Acc &p) { s += p; });
+  }
+
+  template <typename A, typename = detail::enable_2d_array<A>>
+  auto norm_l2(const A &a)
+  {
+    typedef detail::reduce_value_t<A> T;
+    typedef std::conditional_t<std::is_integral<T>::value, double, T> R;
+
+    const size_t nrow = a.num_row();
+    R s2 = detail::reduce_columns(
+        a, R(0),
+        [nrow](R &s, const T *x, size_t) { s += detail::lane_sum<R>(x, nrow, [](const T &v) { return R(v) * R(v); }); },
+        [](R &s, const R &p) { s += p; });
+    return std::sqrt(s2);
+  }
+
+  template <typename A, typename = detail::enable_2d_array<A>>
+  auto norm_linf(const A &a)
+  {
+    typedef detail::reduce_value_t<A> T;
+
+    const size_t nrow = a.num_row();
+    if (a.num_col() * nrow == 0)
+      return T(0);
+
+    return detail::reduce_columns(
+        a, T(0),
+        [nrow](T &m, const T *x, size_t) {
+          const T v = detail::lane_select(x, nrow, detail::reduce_abs(), detail::reduce_greater());
+          m = (m < v) ? v : m;
+        },
+        [](T &m, const T &p) { m = (m < p) ? p : m; });
+  }
+
+  /**
+   * @Brief
+   * Returns the sum of the element-wise products of a and b.
+   * If the dimensions do not match, an exception of type std::length_error is thrown.
+  **/
+  template <typename A, typename B, typename = detail::enable_2d_array<A>, typename = detail::enable_2d_array<B>>
+  auto dot(const A &a, const B &b)
+  {
+    typedef detail::reduce_value_t<A> T;
+    typedef detail::reduce_acc_t<T> Acc;
+
+    if (a.num_col() != b.num_col() || a.num_row() != b.num_row())
+      throw std::length_error("dot : dimension mismatch");
+
+    const size_t nrow = a.num_row();
+    const size_t ldb = detail::leading_dim(b);
+    const auto *pb = b.data();
+    return detail::reduce_columns(
+        a, Acc(0),
+        [nrow, ldb, pb](Acc &s, const T *x, size_t c) { s += detail::lane_dot<Acc>(x, pb + c * ldb, nrow); },
+        [](Acc &s, const Acc &p) { s += p; });
+  }
+
+  //============================================
+  //              Per Column / Row
+  //============================================
+  /**
+   * @Brief
+   * Returns the sum, the smallest or the largest element of each column (one value per column)
+   * or of each row (one value per row).
+  **/
+  template <typename A, typename = detail::enable_2d_array<A>>
+  auto sum_cols(const A &a)
+  {
+    typedef detail::reduce_value_t<A> T;
+    typedef detail::reduce_acc_t<T> Acc;
+    return detail::reduce_each_col<Acc>(a, [](const T *x, size_t n) { return detail::lane_sum<Acc>(x, n, detail::reduce_identity()); });
+  }
+
+  template <typename A, typename = detail::enable_2d_array<A>>
+  auto min_cols(const A &a)
+  {
+    typedef detail::reduce_value_t<A> T;
+    if (a.num_row() == 0)
+      throw std::length_error("min_cols : empty columns");
+    return detail::reduce_each_col<T>(a, [](const T *x, size_t n) { return detail::lane_select(x, n, detail::reduce_identity(), detail::reduce_less()); });
+  }
+
+  template <typename A, typename = detail::enable_2d_array<A>>
+  auto max_cols(const A &a)
+  {
+    typedef detail::reduce_value_t<A> T;
+    if (a.num_row() == 0)
+      throw std::length_error("max_cols : empty columns");
+    return detail::reduce_each_col<T>(a, [](const T *x, size_t n) { return detail::lane_select(x, n, detail::reduce_identity(), detail::reduce_greater()); });
+  }
+
+  template <typename A, typename = detail::enable_2d_array<A>>
+  auto sum_rows(const A &a)
+  {
+    typedef detail::reduce_acc_t<detail::reduce_value_t<A>> Acc;
+    return detail::reduce_each_row<Acc>(a, [](const Acc &s, const Acc &v) { return s + v; });
+  }
+
+  template <typename A, typename = detail::enable_2d_array<A>>
+  auto min_rows(const A &a)
+  {
+    typedef detail::reduce_value_t<A> T;
+    if (a.num_col() == 0)
+      throw std::length_error("min_rows : empty rows");
+    return detail::reduce_each_row<T>(a, [](const T &m, const T &v) { return (v < m) ? v : m; });
+  }
+
+  template <typename A, typename = detail::enable_2d_array<A>>
+  auto max_rows(const A &a)
+  {
+    typedef detail::reduce_value_t<A> T;
+    if (a.num_col() == 0)
+      throw std::length_error("max_rows : empty rows");
+    return detail::reduce_each_row<T>(a, [](const T &m, const T &v) { return (m < v) ? v : m; });
+  }
+}
+
+#endif
@@ -0,0 +1,466 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __ARRAY_2D_RESAMPLE__
+#define __ARRAY_2D_RESAMPLE__
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "array2d.h"
+#include "array2d_expr.h"
+#include "array2d_view.h"
+#include "parallel.h"
+#include "simd.h"
+#include "vector2d.h"
+
+/**
+ * @Brief
+ * Resampling of 2d arrays (nearest, bilinear, bicubic, area average) and multi-resolution pyramids.
+ * 
+ * The resampling is separable : each output column is first interpolated from a few source columns
+ * into a temporary column, contiguous in memory, which is then interpolated along the rows.
+ * The taps (source indices and weights) of every output column and row are computed once per call
+ * and stored tap by tap, so that the loops over the rows vectorize, using the widest instruction set
+ * found at runtime. Output columns are processed in parallel.
+ * 
+ * Pixel centers are aligned : the output element i covers [i, i + 1) * src_size / dst_size in the
+ * source, and samples outside of the source are clamped to its border.
+ * Integer outputs are rounded to the nearest value and saturated.
+ * 
+ * example:
+ * -------
+ * std::vector2d<float> img(1920, 1080), half(960, 540);
+ * std::resample(img, half, std::interpolation::AREA);
+ * 
+ * std::pyramid2d<float> pyr;
+ * std::build_pyramid(img, pyr, 5);           // pyr[0] is a copy of img, pyr[i] is half of pyr[i - 1]
+ */
+
+namespace std
+{
+  enum class interpolation
+  {
+    NEAREST = 0,
+    BILINEAR = 1,
+    BICUBIC = 2,
+    AREA = 3
+  };
+
+  namespace detail
+  {
+    // number of output columns per task
+    constexpr size_t resample_grain = 8;
+
+    // interpolation type, double as soon as float cannot hold every value of T or U exactly
+    template <typename T, typename U>
+    using resample_weight_t = std::conditional_t<
+        (std::is_same<T, long double>::value || std::is_same<U, long double>::value), long double,
+        std::conditional_t<(std::is_same<T, double>::value || std::is_same<U, double>::value ||
+                            (std::is_integral<T>::value && sizeof(T) > 2) ||
+                            (std::is_integral<U>::value && sizeof(U) > 2)),
+                           double, float>>;
+
+    // interpolation taps along one dimension, tap j of the output element i is at j * n + i
+    template <typename W>
+    struct resample_taps
+    {
+      size_t n = 0;               // number of output elements
+      size_t k = 0;               // number of taps per output element
+      std::vector<int32_t> index; // source elements
+      std::vector<W> weight;      // their weights
+    };
+
+    // cubic convolution kernel of Keys with a = -0.5
+    inline double cubic_weight(double x) noexcept
+    {
+      x = std::abs(x);
+      if (x < 1.0)
+        return (1.5 * x - 2.5) * x * x + 1.0;
+      if (x < 2.0)
+        return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+      return 0.0;
+    }
+
+    template <typename W>
+    void resample_make_taps(size_t ns, size_t nd, interpolation mode, resample_taps<W> &taps)
+    {
+      const double scale = double(ns) / double(nd);
+      const std::ptrdiff_t last = std::ptrdiff_t(ns) - 1;
+      auto clamp = [last](std::ptrdiff_t i) { return int32_t(std::clamp<std::ptrdiff_t>(i, 0, last)); };
+
+      // taps of each output element before transposition, at most k of them
+      size_t k = 1;
+      if (mode == interpolation::BILINEAR)
+        k = 2;
+      else if (mode == interpolation::BICUBIC)
+        k = 4;
+      else if (mode == interpolation::AREA)
+        k = size_t(std::ceil(scale)) + 1;
+
+      std::vector<int32_t> index(nd * k, 0);
+      std::vector<double> weight(nd * k, 0.0);
+      size_t kmax = 1;
+
+      for (size_t i = 0; i < nd; ++i)
+      {
+        int32_t *idx = index.data() + i * k;
+        double *w = weight.data() + i * k;
+        switch (mode)
+        {
+        case interpolation::NEAREST:
+          idx[0] = clamp(std::ptrdiff_t(std::floor((double(i) + 0.5) * scale)));
+          w[0] = 1.0;
+          break;
+        case interpolation::BILINEAR:
+        {
+          const double x = (double(i) + 0.5) * scale - 0.5;
+          const double x0 = std::floor(x);
+          idx[0] = clamp(std::ptrdiff_t(x0));
+          idx[1] = clamp(std::ptrdiff_t(x0) + 1);
+          w[0] = 1.0 - (x - x0);
+          w[1] = x - x0;
+          kmax = 2;
+          break;
+        }
+        case interpolation::BICUBIC:
+        {
+          const double x = (double(i) + 0.5) * scale - 0.5;
+          const double x0 = std::floor(x);
+          for (size_t j = 0; j < 4; ++j)
+          {
+            idx[j] = clamp(std::ptrdiff_t(x0) - 1 + std::ptrdiff_t(j));
+            w[j] = cubic_weight(x - (x0 - 1.0 + double(j)));
+          }
+          kmax = 4;
+          break;
+        }
+        case interpolation::AREA:
+        {
+          // overlap of [a, b) with the source elements, normalized by its length
+          const double a = double(i) * scale;
+          const double b = std::min(double(i + 1) * scale, double(ns));
+          const std::ptrdiff_t first = std::ptrdiff_t(std::floor(a));
+          size_t j = 0;
+          for (std::ptrdiff_t s = first; double(s) < b && j < k; ++s, ++j)
+          {
+            idx[j] = clamp(s);
+            w[j] = (std::min(double(s + 1), b) - std::max(double(s), a)) / (b - a);
+          }
+          kmax = std::max(kmax, j);
+          break;
+        }
+        }
+      }
+
+      // transposition to one row of taps per tap index, the unused taps have a zero weight
+      taps.n = nd;
+      taps.k = kmax;
+      taps.index.resize(kmax * nd);
+      taps.weight.resize(kmax * nd);
+      for (size_t i = 0; i < nd; ++i)
+        for (size_t j = 0; j < kmax; ++j)
+        {
+          taps.index[j * nd + i] = index[i * k + j];
+          taps.weight[j * nd + i] = W(weight[i * k + j]);
+        }
+    }
+
+    // converts an interpolated value to the output type, rounding and saturating integers
+    template <typename U, typename W>
+    SIMD_INLINE U resample_cast(W v) noexcept
+    {
+      if constexpr (std::is_integral<U>::value)
+      {
+        // the upper bound is compared with < as it may round up to a value outside of U
+        v = (v == v) ? std::max(v, W(std::numeric_limits<U>::lowest())) : W(0);
+        v = v < W(0) ? v - W(0.5) : v + W(0.5);
+        return (v < W(std::numeric_limits<U>::max())) ? U(v) : std::numeric_limits<U>::max();
+      }
+      else
+        return U(v);
+    }
+
+    // interpolates the output column c, K being the number of taps or 0 when only known at runtime
+    template <size_t K, typename T, typename U, typename W>
+    SIMD_INLINE void resample_column(const T *src, size_t lds, size_t nrs, const resample_taps<W> &tc,
+                                     const resample_taps<W> &tr, size_t c, W *tmp, U *out)
+    {
+      const size_t kc = tc.k;
+      const size_t kr = K > 0 ? K : tr.k;
+
+      // interpolation between the source columns
+      {
+        const T *s = src + size_t(tc.index[c]) * lds;
+        const W w = tc.weight[c];
+        ARRAY2D_VECTORIZE
+        for (size_t r = 0; r < nrs; ++r)
+          tmp[r] = w * W(s[r]);
+      }
+      for (size_t j = 1; j < kc; ++j)
+      {
+        const W w = tc.weight[j * tc.n + c];
+        if (w == W(0))
+          continue;
+        const T *s = src + size_t(tc.index[j * tc.n + c]) * lds;
+        ARRAY2D_VECTORIZE
+        for (size_t r = 0; r < nrs; ++r)
+          tmp[r] += w * W(s[r]);
+      }
+
+      // interpolation along the rows
+      const size_t n = tr.n;
+      const int32_t *idx = tr.index.data();
+      const W *wgt = tr.weight.data();
+      ARRAY2D_VECTORIZE
+      for (size_t r = 0; r < n; ++r)
+      {
+        W v = W(0);
+        for (size_t j = 0; j < kr; ++j)
+          v += wgt[j * n + r] * tmp[idx[j * n + r]];
+        out[r] = resample_cast<U>(v);
+      }
+    }
+
+    template <size_t K, typename T, typename U, typename W>
+    SIMD_INLINE void resample_columns(const T *src, size_t lds, size_t nrs, const resample_taps<W> &tc,
+                                      const resample_taps<W> &tr, size_t c0, size_t c1, W *tmp, U *dst, size_t ldd)
+    {
+      for (size_t c = c0; c < c1; ++c)
+        resample_column<K>(src, lds, nrs, tc, tr, c, tmp, dst + c * ldd);
+    }
+
+    // column kernels compiled for each instruction set
+    template <simd_isa ISA>
+    struct resample_kernel
+    {
+      template <size_t K, typename T, typename U, typename W>
+      static void run(const T *src, size_t lds, size_t nrs, const resample_taps<W> &tc, const resample_taps<W> &tr,
+                      size_t c0, size_t c1, W *tmp, U *dst, size_t ldd)
+      {
+        resample_columns<K>(src, lds, nrs, tc, tr, c0, c1, tmp, dst, ldd);
+      }
+    };
+
+    template <>
+    struct resample_kernel<simd_isa::AVX2>
+    {
+      template <size_t K, typename T, typename U, typename W>
+      SIMD_TARGET_AVX2 static void run(const T *src, size_t lds, size_t nrs, const resample_taps<W> &tc, const resample_taps<W> &tr,
+                                       size_t c0, size_t c1, W *tmp, U *dst, size_t ldd)
+      {
+        resample_columns<K>(src, lds, nrs, tc, tr, c0, c1, tmp, dst, ldd);
+      }
+    };
+
+    template <>
+    struct resample_kernel<simd_isa::AVX512>
+    {
+      template <size_t K, typename T, typename U, typename W>
+      SIMD_TARGET_AVX512 static void run(const T *src, size_t lds, size_t nrs, const resample_taps<W> &tc, const resample_taps<W> &tr,
+                                         size_t c0, size_t c1, W *tmp, U *dst, size_t ldd)
+      {
+        resample_columns<K>(src, lds, nrs, tc, tr, c0, c1, tmp, dst, ldd);
+      }
+    };
+
+    template <simd_isa ISA, typename T, typename U, typename W>
+    void resample_run(const T *src, size_t lds, size_t nrs, const resample_taps<W> &tc, const resample_taps<W> &tr,
+                      U *dst, size_t ldd)
+    {
+      parallel_for(0, tc.n, resample_grain, [&](size_t begin, size_t end) {
+        // reused from one call to the next
+        thread_local std::vector<W> tmp;
+        if (tmp.size() < nrs)
+          tmp.resize(nrs);
+
+        switch (tr.k)
+        {
+        case 1:
+          resample_kernel<ISA>::template run<1>(src, lds, nrs, tc, tr, begin, end, tmp.data(), dst, ldd);
+          break;
+        case 2:
+          resample_kernel<ISA>::template run<2>(src, lds, nrs, tc, tr, begin, end, tmp.data(), dst, ldd);
+          break;
+        case 3:
+          resample_kernel<ISA>::template run<3>(src, lds, nrs, tc, tr, begin, end, tmp.data(), dst, ldd);
+          break;
+        case 4:
+          resample_kernel<ISA>::template run<4>(src, lds, nrs, tc, tr, begin, end, tmp.data(), dst, ldd);
+          break;
+        default:
+          resample_kernel<ISA>::template run<0>(src, lds, nrs, tc, tr, begin, end, tmp.data(), dst, ldd);
+        }
+      });
+    }
+  }
+
+  /**
+   * @Brief
+   * Resamples src to the dimensions of dst with the given interpolation.
+   * If src is empty while dst is not, an exception of type std::length_error is thrown.
+  **/
+  template <typename A, typename B>
+  void resample(const A &src, B &dst, interpolation mode = interpolation::BILINEAR)
+  {
+    typedef std::remove_const_t<detail::view_value_t<A>> T;
+    typedef std::remove_const_t<detail::view_value_t<B>> U;
+    typedef detail::resample_weight_t<T, U> W;
+
+    if (dst.num_col() == 0 || dst.num_row() == 0)
+      return;
+    if (src.num_col() == 0 || src.num_row() == 0)
+      throw std::length_error("resample : empty source");
+
+    detail::resample_taps<W> tc, tr;
+    detail::resample_make_taps(src.num_col(), dst.num_col(), mode, tc);
+    detail::resample_make_taps(src.num_row(), dst.num_row(), mode, tr);
+
+    const size_t lds = detail::leading_dim(src);
+    const size_t ldd = detail::leading_dim(dst);
+    switch (simd_isa_detect())
+    {
+    case simd_isa::AVX512:
+      detail::resample_run<simd_isa::AVX512>(src.data(), lds, src.num_row(), tc, tr, dst.data(), ldd);
+      break;
+    case simd_isa::AVX2:
+      detail::resample_run<simd_isa::AVX2>(src.data(), lds, src.num_row(), tc, tr, dst.data(), ldd);
+      break;
+    default:
+      detail::resample_run<simd_isa::SSE>(src.data(), lds, src.num_row(), tc, tr, dst.data(), ldd);
+    }
+  }
+
+  //============================================
+  //                 Pyramid
+  //============================================
+  /**
+   * @Brief
+   * A chain of 2d arrays, each level being half the size of the previous one (rounded up).
+   * All the levels live in a single buffer which is only reallocated when it has to grow,
+   * so that a pyramid can be rebuilt every frame without allocating.
+  **/
+  template <typename T>
+  class pyramid2d
+  {
+  public:
+    pyramid2d() = default;
+
+    pyramid2d(size_t col, size_t row, size_t levels)
+    {
+      reset(col, row, levels);
+    }
+
+    // the levels wrap the buffer, a copy would reference the storage of the original
+    pyramid2d(const pyramid2d &) = delete;
+    pyramid2d &operator=(const pyramid2d &) = delete;
+    pyramid2d(pyramid2d &&) = default;
+    pyramid2d &operator=(pyramid2d &&) = default;
+
+    /**
+   * @Brief
+   * Sets the dimensions of the base level and the number of levels. The content of the levels is undefined.
+   * Levels stop at 1 x 1, there may be fewer levels than requested.
+  **/
+    void reset(size_t col, size_t row, size_t levels)
+    {
+      // levels start on 64 bytes boundaries
+      const size_t align = std::max<size_t>(1, 64 / sizeof(T));
+
+      mDims.clear();
+      size_t total = 0;
+      for (size_t l = 0; l < levels; ++l)
+      {
+        mDims.push_back({col, row, total});
+        total += (col * row + align - 1) / align * align;
+        if (col <= 1 && row <= 1)
+          break;
+        col = (col + 1) / 2;
+        row = (row + 1) / 2;
+      }
+
+      if (mStorage.num() < total)
+        mStorage = vector2d<T>(1, total);
+
+      mLevels.clear();
+      for (const auto &d : mDims)
+        mLevels.emplace_back(mStorage.data() + d[2], d[0], d[1]);
+    }
+
+    inline size_t num_levels() const noexcept { return mLevels.size(); }
+
+    /**
+   * @Brief
+   * Returns the ith level, the level 0 being the largest one. No bounds checking is performed.
+  **/
+    inline vector2d<T> &operator[](size_t i) noexcept { return mLevels[i]; }
+    inline const vector2d<T> &operator[](size_t i) const noexcept { return mLevels[i]; }
+
+    /**
+   * @Brief
+   * Returns the ith level, with bounds checking.
+   * If i is not within the range of the levels, an exception of type std::out_of_range is thrown.
+  **/
+    vector2d<T> &level(size_t i) { return mLevels.at(i); }
+    const vector2d<T> &level(size_t i) const { return mLevels.at(i); }
+
+  protected:
+    vector2d<T> mStorage;             // one column holding all the levels
+    std::vector<vector2d<T>> mLevels; // non owning wrappers over mStorage
+
+    std::vector<std::array<size_t, 3>> mDims; // col, row and offset of each level, kept to avoid reallocations
+  };
+
+  /**
+   * @Brief
+   * Builds a pyramid of the given number of levels from src : the level 0 is a copy of src and each
+   * level is the previous one resampled to half its size with the given interpolation.
+   * The storage of pyr is reused when it is large enough.
+  **/
+  template <typename A, typename T>
+  void build_pyramid(const A &src, pyramid2d<T> &pyr, size_t levels, interpolation mode = interpolation::AREA)
+  {
+    pyr.reset(src.num_col(), src.num_row(), levels);
+    if (pyr.num_levels() == 0)
+      return;
+
+    if constexpr (std::is_same<std::remove_const_t<detail::view_value_t<A>>, T>::value)
+      detail::strided_copy(src.num_col(), src.num_row(), src.data(), std::ptrdiff_t(detail::leading_dim(src)), 1,
+                           pyr[0].data(), std::ptrdiff_t(pyr[0].ld()), 1);
+    else
+      resample(src, pyr[0], interpolation::NEAREST);
+    for (size_t l = 1; l < pyr.num_levels(); ++l)
+      resample(pyr[l - 1], pyr[l], mode);
+  }
+}
+
+#endif
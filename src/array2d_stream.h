@@ -0,0 +1,452 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __ARRAY_2D_STREAM__
+#define __ARRAY_2D_STREAM__
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "array2d_mmap.h"
+#include "vector2d.h"
+
+/**
+ * @Brief
+ * Out-of-core processing of array2d files (see array2d_mmap.h) in bands of whole columns.
+ * 
+ * band_reader reads a file one band at a time into one of two buffers, the next band being read
+ * in the background while the current one is processed. band_writer does the same the other way
+ * around : a band is written in the background while the next one is filled. Memory use is
+ * therefore two bands per stream, whatever the size of the file, and unlike a memory mapping the
+ * resident set never grows past it.
+ * 
+ * A band is exposed as a vector2d wrapping the buffer, valid until the next call to next() or commit().
+ * 
+ * example:
+ * -------
+ * std::band_reader<float> in("dem.a2d", 256);
+ * while (in.next())
+ *   process(in.band(), in.band_begin());     // in.band() holds the columns [band_begin, band_begin + 256)
+ * 
+ * std::band_writer<float> out("slope.a2d", in.num_col(), in.num_row(), 256);
+ * std::transform_bands(in, out, [](const std::vector2d<float> &a, std::vector2d<float> &b, size_t c0) { ... });
+ */
+
+namespace std
+{
+  namespace detail
+  {
+    // reads or writes exactly bytes at offset, retrying on partial transfers and interruptions
+    inline bool stream_pread(int fd, void *buf, size_t bytes, std::uint64_t offset) noexcept
+    {
+      char *p = static_cast<char *>(buf);
+      while (bytes > 0)
+      {
+        const ssize_t n = ::pread(fd, p, bytes, off_t(offset));
+        if (n < 0 && errno == EINTR)
+          continue;
+        if (n <= 0)
+          return false;
+        p += n;
+        bytes -= size_t(n);
+        offset += std::uint64_t(n);
+      }
+      return true;
+    }
+
+    inline bool stream_pwrite(int fd, const void *buf, size_t bytes, std::uint64_t offset) noexcept
+    {
+      const char *p = static_cast<const char *>(buf);
+      while (bytes > 0)
+      {
+        const ssize_t n = ::pwrite(fd, p, bytes, off_t(offset));
+        if (n < 0 && errno == EINTR)
+          continue;
+        if (n <= 0)
+          return false;
+        p += n;
+        bytes -= size_t(n);
+        offset += std::uint64_t(n);
+      }
+      return true;
+    }
+  }
+
+  //============================================
+  //                 Reader
+  //============================================
+  template <typename T>
+  class band_reader
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "band_reader requires trivially copyable elements");
+
+  public:
+    /**
+   * @Brief
+   * Opens the array2d file at path to be read in bands of band_col columns, the last band being narrower.
+   * If the file cannot be opened or does not hold a column major array of T, or if band_col is 0,
+   * an exception of type std::runtime_error is thrown.
+  **/
+    band_reader(const std::string &path, size_t band_col)
+        : mPath(path), mFd(-1), mCol(0), mRow(0), mOffset(0), mBandCol(band_col), mBegin(0), mNext(0), mSlot(0)
+    {
+      if (band_col == 0)
+        throw std::runtime_error("band_reader : the band width must be positive");
+
+      mFd = ::open(path.c_str(), O_RDONLY);
+      if (mFd < 0)
+        throw std::runtime_error("array2d file \"" + path + "\" : unable to open");
+
+      struct stat st;
+      array2d_file_header header;
+      try
+      {
+        if (::fstat(mFd, &st) != 0 || size_t(st.st_size) < sizeof(header) ||
+            !detail::stream_pread(mFd, &header, sizeof(header), 0))
+          throw std::runtime_error("array2d file \"" + path + "\" : unable to read the header");
+        header.check<T>(path);
+        if (header.layout != array2d_layout::COL_MAJOR)
+          throw std::runtime_error("array2d file \"" + path + "\" : row major files cannot be read in column bands");
+        if (!header.fits(std::uint64_t(st.st_size)))
+          throw std::runtime_error("array2d file \"" + path + "\" : truncated file");
+      }
+      catch (...)
+      {
+        ::close(mFd);
+        throw;
+      }
+
+      mCol = size_t(header.ncol);
+      mRow = size_t(header.nrow);
+      mOffset = header.offset;
+      mBandCol = std::min(mBandCol, std::max<size_t>(mCol, 1));
+      mBuffer[0] = vector2d<T>(mBandCol, mRow);
+      mBuffer[1] = vector2d<T>(mBandCol, mRow);
+    }
+
+    // the background reads hold a pointer to the reader
+    band_reader(const band_reader &) = delete;
+    band_reader &operator=(const band_reader &) = delete;
+
+    virtual ~band_reader()
+    {
+      wait();
+      ::close(mFd);
+    }
+
+    /**
+   * @Brief
+   * Moves to the next band, waiting for it to be read, and starts reading the following one.
+   * Returns false once all the bands have been visited. The previous band is no longer valid.
+   * If a read fails, an exception of type std::runtime_error is thrown.
+  **/
+    bool next()
+    {
+      if (mNext >= mCol)
+      {
+        mBand = vector2d<T>();
+        return false;
+      }
+
+      if (!mPending.valid())
+        prefetch(mNext, mSlot);
+      mPending.get();
+
+      const size_t width = std::min(mBandCol, mCol - mNext);
+      mBand = vector2d<T>(mBuffer[mSlot].data(), width, mRow);
+      mBegin = mNext;
+      mNext += width;
+      mSlot ^= 1;
+
+      if (mNext < mCol)
+        prefetch(mNext, mSlot);
+      return true;
+    }
+
+    /**
+   * @Brief
+   * Goes back to the first band, next() must be called before accessing it.
+  **/
+    void rewind()
+    {
+      wait();
+      mBand = vector2d<T>();
+      mBegin = 0;
+      mNext = 0;
+    }
+
+    /**
+   * @Brief
+   * Returns the current band, i.e. the columns [band_begin(), band_begin() + band().num_col()) of the file.
+  **/
+    const vector2d<T> &band() const noexcept { return mBand; }
+    inline size_t band_begin() const noexcept { return mBegin; }
+
+    inline size_t band_col() const noexcept { return mBandCol; }
+    inline size_t num_bands() const noexcept { return (mCol + mBandCol - 1) / mBandCol; }
+    inline size_t num_col() const noexcept { return mCol; }
+    inline size_t num_row() const noexcept { return mRow; }
+
+  protected:
+    // starts reading the band of columns [c0, c0 + band_col) into the buffer slot
+    void prefetch(size_t c0, int slot)
+    {
+      const size_t width = std::min(mBandCol, mCol - c0);
+      T *dst = mBuffer[slot].data();
+      mPending = std::async(std::launch::async, [this, c0, width, dst]() {
+        const std::uint64_t offset = mOffset + std::uint64_t(c0) * mRow * sizeof(T);
+        if (!detail::stream_pread(mFd, dst, width * mRow * sizeof(T), offset))
+          throw std::runtime_error("array2d file \"" + mPath + "\" : read failed");
+      });
+    }
+
+    // waits for the pending read, discarding its errors
+    void wait() noexcept
+    {
+      if (mPending.valid())
+      {
+        try
+        {
+          mPending.get();
+        }
+        catch (...)
+        {
+        }
+      }
+    }
+
+  protected:
+    std::string mPath;           // path of the file, for error messages
+    int mFd;                     // file descriptor
+    size_t mCol;                 // number of columns of the file
+    size_t mRow;                 // number of rows of the file
+    std::uint64_t mOffset;       // position of the first element in the file
+    size_t mBandCol;             // number of columns per band
+    size_t mBegin;               // first column of the current band
+    size_t mNext;                // first column of the next band
+    int mSlot;                   // buffer of the next band
+    vector2d<T> mBuffer[2];      // double buffer
+    vector2d<T> mBand;           // non owning wrapper over the current band
+    std::future<void> mPending;  // read of the next band
+  };
+
+  //============================================
+  //                 Writer
+  //============================================
+  template <typename T>
+  class band_writer
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "band_writer requires trivially copyable elements");
+
+  public:
+    /**
+   * @Brief
+   * Creates (or truncates) the array2d file at path to hold a col x row array written in bands of band_col columns.
+   * If the file cannot be created or if band_col is 0, an exception of type std::runtime_error is thrown.
+  **/
+    band_writer(const std::string &path, size_t col, size_t row, size_t band_col)
+        : mPath(path), mFd(-1), mCol(col), mRow(row), mOffset(array2d_file_header::DATA_OFFSET),
+          mBandCol(std::min(band_col, std::max<size_t>(col, 1))), mBegin(0), mSlot(0)
+    {
+      if (band_col == 0)
+        throw std::runtime_error("band_writer : the band width must be positive");
+
+      const array2d_file_header header = array2d_file_header::make<T>(col, row);
+      const std::uint64_t bytes = array2d_file_header::file_size(col, row, sizeof(T));
+      if (bytes == 0)
+        throw std::length_error("array2d file \"" + path + "\" : the array is too large");
+
+      mFd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+      if (mFd < 0)
+        throw std::runtime_error("array2d file \"" + path + "\" : unable to create");
+
+      if (::ftruncate(mFd, off_t(bytes)) != 0 ||
+          !detail::stream_pwrite(mFd, &header, sizeof(header), 0))
+      {
+        ::close(mFd);
+        throw std::runtime_error("array2d file \"" + path + "\" : unable to write the header");
+      }
+
+      mBuffer[0] = vector2d<T>(mBandCol, mRow);
+      mBuffer[1] = vector2d<T>(mBandCol, mRow);
+      expose();
+    }
+
+    // the background writes hold a pointer to the writer
+    band_writer(const band_writer &) = delete;
+    band_writer &operator=(const band_writer &) = delete;
+
+    /**
+   * @Brief
+   * Waits for the pending write and closes the file, errors are discarded. Call close() to get them.
+  **/
+    virtual ~band_writer()
+    {
+      if (mFd >= 0)
+      {
+        if (mPending.valid())
+        {
+          try
+          {
+            mPending.get();
+          }
+          catch (...)
+          {
+          }
+        }
+        ::close(mFd);
+      }
+    }
+
+    /**
+   * @Brief
+   * Returns the band to fill, i.e. the columns [band_begin(), band_begin() + band().num_col()) of the file.
+   * Its content is undefined until it is filled.
+  **/
+    vector2d<T> &band() noexcept { return mBand; }
+    inline size_t band_begin() const noexcept { return mBegin; }
+
+    /**
+   * @Brief
+   * Starts writing the current band and moves to the next one.
+   * If all the bands have already been committed or a previous write failed, an exception of
+   * type std::runtime_error is thrown.
+  **/
+    void commit()
+    {
+      if (mBegin >= mCol)
+        throw std::runtime_error("band_writer::commit : all the bands have been written");
+
+      // the buffer of the next band is the one being written
+      if (mPending.valid())
+        mPending.get();
+
+      const size_t c0 = mBegin;
+      const size_t width = mBand.num_col();
+      const T *src = mBand.data();
+      mPending = std::async(std::launch::async, [this, c0, width, src]() {
+        const std::uint64_t offset = mOffset + std::uint64_t(c0) * mRow * sizeof(T);
+        if (!detail::stream_pwrite(mFd, src, width * mRow * sizeof(T), offset))
+          throw std::runtime_error("array2d file \"" + mPath + "\" : write failed");
+      });
+
+      mBegin += width;
+      mSlot ^= 1;
+      expose();
+    }
+
+    /**
+   * @Brief
+   * Waits for the pending write and closes the file.
+   * If a write failed, an exception of type std::runtime_error is thrown.
+  **/
+    void close()
+    {
+      if (mFd < 0)
+        return;
+
+      std::exception_ptr error;
+      try
+      {
+        if (mPending.valid())
+          mPending.get();
+      }
+      catch (...)
+      {
+        error = std::current_exception();
+      }
+
+      const bool closed = ::close(mFd) == 0;
+      mFd = -1;
+      if (error)
+        std::rethrow_exception(error);
+      if (!closed)
+        throw std::runtime_error("array2d file \"" + mPath + "\" : write failed");
+    }
+
+    inline size_t band_col() const noexcept { return mBandCol; }
+    inline size_t num_bands() const noexcept { return (mCol + mBandCol - 1) / mBandCol; }
+    inline size_t num_col() const noexcept { return mCol; }
+    inline size_t num_row() const noexcept { return mRow; }
+
+  protected:
+    // wraps the free buffer with the dimensions of the band starting at mBegin
+    void expose()
+    {
+      const size_t width = mBegin < mCol ? std::min(mBandCol, mCol - mBegin) : 0;
+      mBand = vector2d<T>(mBuffer[mSlot].data(), width, mRow);
+    }
+
+  protected:
+    std::string mPath;           // path of the file, for error messages
+    int mFd;                     // file descriptor, -1 once closed
+    size_t mCol;                 // number of columns of the file
+    size_t mRow;                 // number of rows of the file
+    std::uint64_t mOffset;       // position of the first element in the file
+    size_t mBandCol;             // number of columns per band
+    size_t mBegin;               // first column of the current band
+    int mSlot;                   // buffer of the current band
+    vector2d<T> mBuffer[2];      // double buffer
+    vector2d<T> mBand;           // non owning wrapper over the current band
+    std::future<void> mPending;  // write of the previous band
+  };
+
+  //============================================
+  //                 Streaming
+  //============================================
+  /**
+   * @Brief
+   * Runs kernel(in_band, out_band, c0) over all the bands of in, writing the results to out, and closes out.
+   * The next band is read and the previous one written while the kernel runs.
+   * If the dimensions or band widths of in and out differ, an exception of type std::length_error is thrown.
+  **/
+  template <typename T, typename U, typename F>
+  void transform_bands(band_reader<T> &in, band_writer<U> &out, F &&kernel)
+  {
+    if (in.num_col() != out.num_col() || in.num_row() != out.num_row() || in.band_col() != out.band_col())
+      throw std::length_error("transform_bands : dimension mismatch");
+
+    in.rewind();
+    while (in.next())
+    {
+      kernel(in.band(), out.band(), in.band_begin());
+      out.commit();
+    }
+    out.close();
+  }
+}
+
+#endif
@@ -0,0 +1,173 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __ARRAY_2D_TRANSPOSE__
+#define __ARRAY_2D_TRANSPOSE__
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "array2d.h"
+#include "array2d_transpose_kernel.h"
+#include "array2d_view.h"
+#include "vector2d.h"
+
+/**
+ * @Brief
+ * Cache blocked transposition and row-major / column-major conversion of 2d arrays.
+ * 
+ * The arrays are processed in tiles that fit in the L1 cache, each tile being transposed
+ * with 4x4 SSE register blocks for floats and a scalar loop otherwise (see array2d_transpose_kernel.h).
+ * 
+ * example:
+ * -------
+ * std::vector2d<float> a(640, 480), b;
+ * std::transpose(a, b);            // b is 480 x 640
+ * std::transpose_inplace(square);  // only for square arrays
+ * 
+ * std::vector<float> rm(640 * 480);
+ * std::to_row_major(a, rm.data());  // rm[r * 640 + c] = a(c, r)
+ * std::from_row_major(rm.data(), a);
+ */
+
+namespace std
+{
+  namespace detail
+  {
+    // swaps the nc x nr tile X at {c0, r0} with the transpose of its mirror tile Y at {r0, c0}, going through a buffer
+    template <typename T>
+    inline void swap_tiles(T *a, size_t ld, size_t c0, size_t r0, size_t nc, size_t nr)
+    {
+      T tmp[transpose_tile * transpose_tile];
+      T *x = a + c0 * ld + r0;
+      T *y = a + r0 * ld + c0;
+
+      transpose_tile_kernel(x, ld, tmp, nc, nc, nr);
+      transpose_tile_kernel(y, ld, x, ld, nr, nc);
+      for (size_t c = 0; c < nr; ++c)
+        std::copy(tmp + c * nc, tmp + (c + 1) * nc, y + c * ld);
+    }
+  }
+
+  /**
+   * @Brief
+   * Transposes the nc x nr column major matrix src into the nr x nc column major matrix dst.
+   * lds and ldd are the distances between two consecutive columns of src and dst.
+   * src and dst must not overlap.
+  **/
+  template <typename T>
+  void transpose(const T *src, size_t nc, size_t nr, size_t lds, T *dst, size_t ldd)
+  {
+    detail::transpose_blocked(src, nc, nr, lds, dst, ldd);
+  }
+
+  /**
+   * @Brief
+   * Transposes the n x n column major matrix a in place.
+  **/
+  template <typename T>
+  void transpose_inplace(T *a, size_t n, size_t ld)
+  {
+    const size_t B = detail::transpose_tile;
+    for (size_t c = 0; c < n; c += B)
+    {
+      const size_t nc = std::min(B, n - c);
+
+      // diagonal tile : swap the strictly lower part with the upper part
+      for (size_t i = c; i < c + nc; ++i)
+        for (size_t j = i + 1; j < c + nc; ++j)
+          std::swap(a[i * ld + j], a[j * ld + i]);
+
+      // off diagonal tiles : swap tile {c, r} with tile {r, c}
+      for (size_t r = c + B; r < n; r += B)
+        detail::swap_tiles(a, ld, c, r, nc, std::min(B, n - r));
+    }
+  }
+
+  /**
+   * @Brief
+   * Transposes the 2d array src into dst, i.e. dst(r, c) = src(c, r).
+   * A vector2d destination is resized, otherwise if the dimensions of dst do not match,
+   * an exception of type std::length_error is thrown.
+  **/
+  template <typename A, typename B>
+  void transpose(const A &src, B &dst)
+  {
+    if constexpr (std::is_same<B, vector2d<typename B::value_type>>::value)
+    {
+      if (dst.num_col() != src.num_row() || dst.num_row() != src.num_col())
+        dst.resize(src.num_row(), src.num_col());
+    }
+
+    if (dst.num_col() != src.num_row() || dst.num_row() != src.num_col())
+      throw std::length_error("transpose : dimension mismatch");
+
+    transpose(src.data(), src.num_col(), src.num_row(), detail::leading_dim(src),
+              dst.data(), detail::leading_dim(dst));
+  }
+
+  /**
+   * @Brief
+   * Transposes the square 2d array a in place.
+   * If a is not square, an exception of type std::length_error is thrown.
+  **/
+  template <typename A>
+  void transpose_inplace(A &a)
+  {
+    if (a.num_col() != a.num_row())
+      throw std::length_error("transpose_inplace : the array is not square");
+
+    transpose_inplace(a.data(), a.num_col(), detail::leading_dim(a));
+  }
+
+  /**
+   * @Brief
+   * Writes the elements of the 2d array src in row-major order into dst,
+   * i.e. dst[r * src.num_col() + c] = src(c, r).
+   * dst must hold at least src.num() elements.
+  **/
+  template <typename A>
+  void to_row_major(const A &src, typename A::value_type *dst)
+  {
+    transpose(src.data(), src.num_col(), src.num_row(), detail::leading_dim(src), dst, src.num_col());
+  }
+
+  /**
+   * @Brief
+   * Reads the elements of the 2d array dst from the row-major buffer src,
+   * i.e. dst(c, r) = src[r * dst.num_col() + c].
+   * src must hold at least dst.num() elements.
+  **/
+  template <typename A>
+  void from_row_major(const typename A::value_type *src, A &dst)
+  {
+    transpose(src, dst.num_row(), dst.num_col(), dst.num_col(), dst.data(), detail::leading_dim(dst));
+  }
+}
+
+#endif
@@ -0,0 +1,112 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __ARRAY_2D_TRANSPOSE_KERNEL__
+#define __ARRAY_2D_TRANSPOSE_KERNEL__
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define ARRAY2D_TRANSPOSE_SSE
+#endif
+
+/**
+ * @Brief
+ * Tile kernels of the cache blocked transposition, shared by the strided copies of array2d_view.h
+ * and by array2d_transpose.h. Floats are transposed with 4x4 SSE register blocks, the other types
+ * with a scalar loop.
+ */
+
+namespace std
+{
+  namespace detail
+  {
+    // number of elements along each side of a cache tile
+    constexpr size_t transpose_tile = 16;
+
+    // dst(r, c) = src(c, r) for c in [0, nc) and r in [0, nr), columns are ld apart
+    template <typename T>
+    inline void transpose_tile_scalar(const T *src, size_t lds, T *dst, size_t ldd, size_t nc, size_t nr)
+    {
+      for (size_t c = 0; c < nc; ++c)
+        for (size_t r = 0; r < nr; ++r)
+          dst[r * ldd + c] = src[c * lds + r];
+    }
+
+    template <typename T>
+    inline void transpose_tile_kernel(const T *src, size_t lds, T *dst, size_t ldd, size_t nc, size_t nr)
+    {
+#ifdef ARRAY2D_TRANSPOSE_SSE
+      if constexpr (std::is_same<T, float>::value)
+      {
+        const size_t nc4 = nc & ~size_t(3);
+        const size_t nr4 = nr & ~size_t(3);
+
+        for (size_t c = 0; c < nc4; c += 4)
+        {
+          for (size_t r = 0; r < nr4; r += 4)
+          {
+            const float *s = src + c * lds + r;
+            __m128 c0 = _mm_loadu_ps(s);
+            __m128 c1 = _mm_loadu_ps(s + lds);
+            __m128 c2 = _mm_loadu_ps(s + 2 * lds);
+            __m128 c3 = _mm_loadu_ps(s + 3 * lds);
+            _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+            float *d = dst + r * ldd + c;
+            _mm_storeu_ps(d, c0);
+            _mm_storeu_ps(d + ldd, c1);
+            _mm_storeu_ps(d + 2 * ldd, c2);
+            _mm_storeu_ps(d + 3 * ldd, c3);
+          }
+        }
+
+        // remaining rows and columns
+        transpose_tile_scalar(src + nr4, lds, dst + nr4 * ldd, ldd, nc4, nr - nr4);
+        transpose_tile_scalar(src + nc4 * lds, lds, dst + nc4, ldd, nc - nc4, nr);
+        return;
+      }
+#endif
+      transpose_tile_scalar(src, lds, dst, ldd, nc, nr);
+    }
+
+    // transposes the nc x nr column major matrix src into dst, tile by tile
+    template <typename T>
+    void transpose_blocked(const T *src, size_t nc, size_t nr, size_t lds, T *dst, size_t ldd)
+    {
+      // tiles are visited along the columns of dst so that the writes are sequential
+      const size_t B = transpose_tile;
+      for (size_t r = 0; r < nr; r += B)
+        for (size_t c = 0; c < nc; c += B)
+          transpose_tile_kernel(src + c * lds + r, lds, dst + r * ldd + c, ldd,
+                                std::min(B, nc - c), std::min(B, nr - r));
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,622 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __ARRAY_2D_VIEW__
+#define __ARRAY_2D_VIEW__
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "array2d_transpose_kernel.h"
+
+/**
+ * @Brief
+ * Non-owning views over the elements of a column major 2d array (array2d, vector2d or another view).
+ * 
+ * col_view   : the elements of a column, contiguous in memory.
+ * row_view   : the elements of a row, separated by the leading dimension of the array.
+ * block_view : a rectangular sub-region of nc columns and nr rows.
+ * 
+ * The views do not copy any element, writing through a view writes into the viewed array.
+ * Their iterators are random access and can be used with <algorithm>.
+ * 
+ * example:
+ * -------
+ * std::vector2d<float> arr(16, 8);
+ * std::row_view r(arr, 2);                    // or arr.row(2)
+ * std::sort(r.begin(), r.end());
+ * std::block_view b(arr, 4, 2, 8, 4);         // or arr.block(4, 2, 8, 4)
+ * std::fill(b.begin(), b.end(), 0.f);
+ */
+
+namespace std
+{
+  namespace detail
+  {
+    // element type of the array A, const qualified if A is const
+    template <typename A>
+    using view_value_t = std::remove_reference_t<decltype(*std::declval<A &>().data())>;
+
+    template <typename A, typename = void>
+    struct has_ld : std::false_type
+    {
+    };
+
+    template <typename A>
+    struct has_ld<A, std::void_t<decltype(std::declval<const A &>().ld())>> : std::true_type
+    {
+    };
+
+    // true if A is a 2d array with contiguous columns : array2d, vector2d, block views, ...
+    template <typename A, typename = void>
+    struct is_2d_array : std::false_type
+    {
+    };
+
+    template <typename A>
+    struct is_2d_array<A, std::void_t<decltype(std::declval<const A &>().num_col()),
+                                      decltype(std::declval<const A &>().num_row()),
+                                      decltype(std::declval<const A &>().data())>> : std::true_type
+    {
+    };
+
+    template <typename A>
+    using enable_2d_array = std::enable_if_t<is_2d_array<std::decay_t<A>>::value>;
+
+    // leading dimension of A, i.e. the distance between two consecutive columns
+    template <typename A>
+    inline size_t leading_dim(const A &a) noexcept
+    {
+      if constexpr (has_ld<A>::value)
+        return a.ld();
+      else
+        return a.num_row();
+    }
+
+    // copies n contiguous elements, with memcpy for trivially copyable types
+    template <typename T>
+    inline void bulk_copy(const T *src, size_t n, T *dst)
+    {
+      if constexpr (std::is_trivially_copyable<T>::value)
+      {
+        if (n > 0)
+          std::memcpy(dst, src, n * sizeof(T));
+      }
+      else
+        std::copy_n(src, n, dst);
+    }
+
+    // dst[c * dcs + r * drs] = src[c * scs + r * srs] for c in [0, nc) and r in [0, nr).
+    // Columns with unit row strides are copied as blocks, conversions between row major and column major
+    // layouts are transpositions, other layouts are copied by square tiles
+    template <typename T>
+    void strided_copy(size_t nc, size_t nr, const T *src, std::ptrdiff_t scs, std::ptrdiff_t srs,
+                      T *dst, std::ptrdiff_t dcs, std::ptrdiff_t drs)
+    {
+      if (srs == 1 && drs == 1)
+      {
+        if (scs == std::ptrdiff_t(nr) && dcs == std::ptrdiff_t(nr))
+          bulk_copy(src, nc * nr, dst);
+        else
+          for (size_t c = 0; c < nc; ++c)
+            bulk_copy(src + std::ptrdiff_t(c) * scs, nr, dst + std::ptrdiff_t(c) * dcs);
+        return;
+      }
+
+      if (srs == 1 && dcs == 1 && scs > 0 && drs > 0)
+      {
+        transpose_blocked(src, nc, nr, size_t(scs), dst, size_t(drs));
+        return;
+      }
+
+      if (scs == 1 && drs == 1 && srs > 0 && dcs > 0)
+      {
+        transpose_blocked(src, nr, nc, size_t(srs), dst, size_t(dcs));
+        return;
+      }
+
+      const size_t B = transpose_tile;
+      for (size_t c0 = 0; c0 < nc; c0 += B)
+      {
+        const size_t c1 = std::min(c0 + B, nc);
+        for (size_t r0 = 0; r0 < nr; r0 += B)
+        {
+          const size_t r1 = std::min(r0 + B, nr);
+          for (size_t c = c0; c < c1; ++c)
+          {
+            const T *s = src + std::ptrdiff_t(c) * scs;
+            T *d = dst + std::ptrdiff_t(c) * dcs;
+            for (size_t r = r0; r < r1; ++r)
+              d[std::ptrdiff_t(r) * drs] = s[std::ptrdiff_t(r) * srs];
+          }
+        }
+      }
+    }
+  }
+
+  //============================================
+  //              Strided Iterator
+  //============================================
+  /**
+   * @Brief
+   * A random access iterator over elements separated by a constant stride.
+  **/
+  template <typename T>
+  class strided_iterator
+  {
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef std::remove_cv_t<T> value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T *pointer;
+    typedef T &reference;
+
+  public:
+    strided_iterator() noexcept
+        : mPtr(nullptr), mStride(1)
+    {
+    }
+
+    strided_iterator(T *ptr, difference_type stride) noexcept
+        : mPtr(ptr), mStride(stride)
+    {
+    }
+
+    // allows conversion from iterator to const_iterator
+    template <typename U, typename = std::enable_if_t<std::is_convertible<U *, T *>::value>>
+    strided_iterator(const strided_iterator<U> &other) noexcept
+        : mPtr(other.base()), mStride(other.stride())
+    {
+    }
+
+    inline T *base() const noexcept { return mPtr; }
+    inline difference_type stride() const noexcept { return mStride; }
+
+    inline reference operator*() const noexcept { return *mPtr; }
+    inline pointer operator->() const noexcept { return mPtr; }
+    inline reference operator[](difference_type n) const noexcept { return mPtr[n * mStride]; }
+
+    inline strided_iterator &operator++() noexcept
+    {
+      mPtr += mStride;
+      return *this;
+    }
+
+    inline strided_iterator operator++(int) noexcept
+    {
+      strided_iterator tmp(*this);
+      mPtr += mStride;
+      return tmp;
+    }
+
+    inline strided_iterator &operator--() noexcept
+    {
+      mPtr -= mStride;
+      return *this;
+    }
+
+    inline strided_iterator operator--(int) noexcept
+    {
+      strided_iterator tmp(*this);
+      mPtr -= mStride;
+      return tmp;
+    }
+
+    inline strided_iterator &operator+=(difference_type n) noexcept
+    {
+      mPtr += n * mStride;
+      return *this;
+    }
+
+    inline strided_iterator &operator-=(difference_type n) noexcept
+    {
+      mPtr -= n * mStride;
+      return *this;
+    }
+
+    inline strided_iterator operator+(difference_type n) const noexcept { return strided_iterator(mPtr + n * mStride, mStride); }
+    inline strided_iterator operator-(difference_type n) const noexcept { return strided_iterator(mPtr - n * mStride, mStride); }
+    friend inline strided_iterator operator+(difference_type n, const strided_iterator &it) noexcept { return it + n; }
+
+    inline difference_type operator-(const strided_iterator &other) const noexcept { return (mPtr - other.mPtr) / mStride; }
+
+    inline bool operator==(const strided_iterator &other) const noexcept { return mPtr == other.mPtr; }
+    inline bool operator!=(const strided_iterator &other) const noexcept { return mPtr != other.mPtr; }
+    inline bool operator<(const strided_iterator &other) const noexcept { return (mStride > 0) ? mPtr < other.mPtr : mPtr > other.mPtr; }
+    inline bool operator>(const strided_iterator &other) const noexcept { return other < *this; }
+    inline bool operator<=(const strided_iterator &other) const noexcept { return !(other < *this); }
+    inline bool operator>=(const strided_iterator &other) const noexcept { return !(*this < other); }
+
+  private:
+    T *mPtr;
+    difference_type mStride;
+  };
+
+  //============================================
+  //              Block Iterator
+  //============================================
+  /**
+   * @Brief
+   * A random access iterator over the elements of a block in column major order.
+   * Incrementing only moves to the next column when the end of a column is reached.
+  **/
+  template <typename T>
+  class block_iterator
+  {
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef std::remove_cv_t<T> value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T *pointer;
+    typedef T &reference;
+
+  public:
+    block_iterator() noexcept
+        : mOrigin(nullptr), mPtr(nullptr), mIndex(0), mRow(0), mNumRow(1), mLd(1)
+    {
+    }
+
+    block_iterator(T *origin, size_t numRow, size_t ld, difference_type index = 0) noexcept
+        : mOrigin(origin), mNumRow(numRow), mLd(ld)
+    {
+      seek(index);
+    }
+
+    template <typename U, typename = std::enable_if_t<std::is_convertible<U *, T *>::value>>
+    block_iterator(const block_iterator<U> &other) noexcept
+        : mOrigin(other.origin()), mNumRow(other.num_row()), mLd(other.ld())
+    {
+      seek(other.index());
+    }
+
+    inline T *origin() const noexcept { return mOrigin; }
+    inline size_t num_row() const noexcept { return mNumRow; }
+    inline size_t ld() const noexcept { return mLd; }
+    inline difference_type index() const noexcept { return mIndex; }
+
+    inline reference operator*() const noexcept { return *mPtr; }
+    inline pointer operator->() const noexcept { return mPtr; }
+    inline reference operator[](difference_type n) const noexcept { return *(*this + n); }
+
+    inline block_iterator &operator++() noexcept
+    {
+      ++mIndex;
+      if (++mRow == mNumRow)
+      {
+        mRow = 0;
+        mPtr += mLd - mNumRow + 1;
+      }
+      else
+        ++mPtr;
+      return *this;
+    }
+
+    inline block_iterator operator++(int) noexcept
+    {
+      block_iterator tmp(*this);
+      ++(*this);
+      return tmp;
+    }
+
+    inline block_iterator &operator--() noexcept
+    {
+      --mIndex;
+      if (mRow == 0)
+      {
+        mRow = mNumRow - 1;
+        mPtr -= mLd - mNumRow + 1;
+      }
+      else
+      {
+        --mRow;
+        --mPtr;
+      }
+      return *this;
+    }
+
+    inline block_iterator operator--(int) noexcept
+    {
+      block_iterator tmp(*this);
+      --(*this);
+      return tmp;
+    }
+
+    inline block_iterator &operator+=(difference_type n) noexcept
+    {
+      seek(mIndex + n);
+      return *this;
+    }
+
+    inline block_iterator &operator-=(difference_type n) noexcept
+    {
+      seek(mIndex - n);
+      return *this;
+    }
+
+    inline block_iterator operator+(difference_type n) const noexcept { return block_iterator(mOrigin, mNumRow, mLd, mIndex + n); }
+    inline block_iterator operator-(difference_type n) const noexcept { return block_iterator(mOrigin, mNumRow, mLd, mIndex - n); }
+    friend inline block_iterator operator+(difference_type n, const block_iterator &it) noexcept { return it + n; }
+
+    inline difference_type operator-(const block_iterator &other) const noexcept { return mIndex - other.mIndex; }
+
+    inline bool operator==(const block_iterator &other) const noexcept { return mIndex == other.mIndex; }
+    inline bool operator!=(const block_iterator &other) const noexcept { return mIndex != other.mIndex; }
+    inline bool operator<(const block_iterator &other) const noexcept { return mIndex < other.mIndex; }
+    inline bool operator>(const block_iterator &other) const noexcept { return mIndex > other.mIndex; }
+    inline bool operator<=(const block_iterator &other) const noexcept { return mIndex <= other.mIndex; }
+    inline bool operator>=(const block_iterator &other) const noexcept { return mIndex >= other.mIndex; }
+
+  private:
+    inline void seek(difference_type index) noexcept
+    {
+      if (mNumRow == 0)
+      {
+        mIndex = index;
+        mRow = 0;
+        mPtr = mOrigin;
+        return;
+      }
+
+      size_t col = size_t(index) / mNumRow;
+      mIndex = index;
+      mRow = size_t(index) - col * mNumRow;
+      mPtr = mOrigin + col * mLd + mRow;
+    }
+
+  private:
+    T *mOrigin;             // first element of the block
+    T *mPtr;                // current element
+    difference_type mIndex; // column major index of the current element within the block
+    size_t mRow;            // row of the current element within the block
+    size_t mNumRow;         // number of rows of the block
+    size_t mLd;             // distance between two consecutive columns
+  };
+
+  //============================================
+  //              Line Views
+  //============================================
+  /**
+   * @Brief
+   * A view over n elements separated by a constant stride.
+   * Base class of col_view and row_view.
+  **/
+  template <typename T>
+  class line_view
+  {
+  public:
+    typedef std::remove_cv_t<T> value_type;
+    typedef T &reference;
+    typedef const T &const_reference;
+    typedef T *pointer;
+
+    typedef strided_iterator<T> iterator;
+    typedef strided_iterator<const T> const_iterator;
+
+  public:
+    line_view(T *ptr, size_t n, std::ptrdiff_t stride) noexcept
+        : mPtr(ptr), mSize(n), mStride(stride)
+    {
+    }
+
+    /**
+   * @Brief
+   * Returns a reference to the ith element of the view, with bounds checking.
+   * If i is not within the range of the view, an exception of type std::out_of_range is thrown.
+  **/
+    reference at(size_t i) const
+    {
+      if (i >= mSize)
+        throw std::out_of_range("line_view::at");
+      return mPtr[i * mStride];
+    }
+
+    /**
+   * @Brief
+   * Returns a reference to the ith element of the view. No bounds checking is performed.
+  **/
+    inline reference operator[](size_t i) const noexcept { return mPtr[i * mStride]; }
+    inline reference operator()(size_t i) const noexcept { return mPtr[i * mStride]; }
+
+    inline reference front() const { return at(0); }
+    inline reference back() const { return at(mSize - 1); }
+
+    inline iterator begin() const noexcept { return iterator(mPtr, mStride); }
+    inline iterator end() const noexcept { return iterator(mPtr + mSize * mStride, mStride); }
+
+    inline const_iterator cbegin() const noexcept { return begin(); }
+    inline const_iterator cend() const noexcept { return end(); }
+
+    // first element of the view
+    inline pointer data() const noexcept { return mPtr; }
+
+    // number of elements of the view
+    inline size_t size() const noexcept { return mSize; }
+
+    // distance between two consecutive elements of the view
+    inline std::ptrdiff_t stride() const noexcept { return mStride; }
+
+    inline bool empty() const noexcept { return mSize == 0; }
+
+  protected:
+    T *mPtr;
+    size_t mSize;
+    std::ptrdiff_t mStride;
+  };
+
+  /**
+   * @Brief
+   * A view over the elements of the ith column. The elements are contiguous.
+   * If i is not within the range of the columns, an exception of type std::out_of_range is thrown.
+  **/
+  template <typename T>
+  class col_view : public line_view<T>
+  {
+  public:
+    col_view(T *ptr, size_t n) noexcept
+        : line_view<T>(ptr, n, 1)
+    {
+    }
+
+    template <typename A>
+    col_view(A &a, size_t i)
+        : line_view<T>(nullptr, a.num_row(), 1)
+    {
+      if (i >= a.num_col())
+        throw std::out_of_range("col_view");
+      this->mPtr = a.data() + i * detail::leading_dim(a);
+    }
+  };
+
+  /**
+   * @Brief
+   * A view over the elements of the ith row. Consecutive elements are one leading dimension apart.
+   * If i is not within the range of the rows, an exception of type std::out_of_range is thrown.
+  **/
+  template <typename T>
+  class row_view : public line_view<T>
+  {
+  public:
+    row_view(T *ptr, size_t n, std::ptrdiff_t stride) noexcept
+        : line_view<T>(ptr, n, stride)
+    {
+    }
+
+    template <typename A>
+    row_view(A &a, size_t i)
+        : line_view<T>(nullptr, a.num_col(), std::ptrdiff_t(detail::leading_dim(a)))
+    {
+      if (i >= a.num_row())
+        throw std::out_of_range("row_view");
+      this->mPtr = a.data() + i;
+    }
+  };
+
+  template <typename A>
+  col_view(A &, size_t) -> col_view<detail::view_value_t<A>>;
+
+  template <typename A>
+  row_view(A &, size_t) -> row_view<detail::view_value_t<A>>;
+
+  //============================================
+  //              Block View
+  //============================================
+  /**
+   * @Brief
+   * A view over the rectangular region [c0, c0 + nc) x [r0, r0 + nr) of a 2d array.
+   * If the region is not within the range of the array, an exception of type std::out_of_range is thrown.
+  **/
+  template <typename T>
+  class block_view
+  {
+  public:
+    typedef std::remove_cv_t<T> value_type;
+    typedef std::array<std::size_t, 2> size_type;
+
+    typedef T &reference;
+    typedef const T &const_reference;
+    typedef T *pointer;
+
+    typedef block_iterator<T> iterator;
+    typedef block_iterator<const T> const_iterator;
+
+  public:
+    block_view(T *ptr, size_t nc, size_t nr, size_t ld) noexcept
+        : mPtr(ptr), mCol(nc), mRow(nr), mLd(ld)
+    {
+    }
+
+    template <typename A>
+    block_view(A &a, size_t c0, size_t r0, size_t nc, size_t nr)
+        : mPtr(nullptr), mCol(nc), mRow(nr), mLd(detail::leading_dim(a))
+    {
+      if (c0 + nc > a.num_col() || r0 + nr > a.num_row())
+        throw std::out_of_range("block_view");
+      mPtr = a.data() + c0 * mLd + r0;
+    }
+
+    /**
+   * @Brief
+   * Returns a reference to the element at location {col, row} of the block, with bounds checking.
+   * If {col, row} is not within the range of the block, an exception of type std::out_of_range is thrown.
+  **/
+    reference at(size_t col, size_t row) const
+    {
+      if (col >= mCol || row >= mRow)
+        throw std::out_of_range("block_view::at");
+      return mPtr[col * mLd + row];
+    }
+
+    /**
+   * @Brief
+   * Returns a reference to the element at location {col, row} of the block. No bounds checking is performed.
+  **/
+    inline reference operator()(size_t col, size_t row) const noexcept { return mPtr[col * mLd + row]; }
+
+    /**
+   * @Brief
+   * Returns views over a column, a row or a sub-block of the block.
+  **/
+    col_view<T> col(size_t i) const { return col_view<T>(*this, i); }
+    row_view<T> row(size_t i) const { return row_view<T>(*this, i); }
+    block_view block(size_t c0, size_t r0, size_t nc, size_t nr) const { return block_view(*this, c0, r0, nc, nr); }
+
+    inline iterator begin() const noexcept { return iterator(mPtr, mRow, mLd, 0); }
+    inline iterator end() const noexcept { return iterator(mPtr, mRow, mLd, std::ptrdiff_t(num())); }
+
+    inline const_iterator cbegin() const noexcept { return begin(); }
+    inline const_iterator cend() const noexcept { return end(); }
+
+    /**
+   * @Brief
+   * Returns a pointer to the first element of the block.
+   * Column i of the block starts at data() + i * ld().
+  **/
+    inline pointer data() const noexcept { return mPtr; }
+
+    inline size_type size() const noexcept { return {mCol, mRow}; }
+    inline size_t num() const noexcept { return mCol * mRow; }
+    inline size_t num_col() const noexcept { return mCol; }
+    inline size_t num_row() const noexcept { return mRow; }
+    inline size_t ld() const noexcept { return mLd; }
+    inline bool empty() const noexcept { return num() == 0; }
+
+  protected:
+    T *mPtr;     // first element of the block
+    size_t mCol; // number of columns
+    size_t mRow; // number of rows
+    size_t mLd;  // distance between two consecutive columns
+  };
+
+  template <typename A>
+  block_view(A &, size_t, size_t, size_t, size_t) -> block_view<detail::view_value_t<A>>;
+}
+
+#endif
@@ -26,20 +26,45 @@
 #ifndef __ATTRIBUTE_H__
 #define __ATTRIBUTE_H__
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <typeinfo>
-#include <unordered_map>
 #include <vector>
 
+#include "parallel.h"
+
+// AttributeTypeId ============================================================================
+
+// a unique address per type, used to check the type of an attribute without RTTI
+template <class T>
+struct AttributeTypeId
+{
+  static constexpr char tag = 0;
+
+  static const void *get()
+  {
+    return &tag;
+  }
+};
+
 // BaseAttributeArray class ===================================================================
 
 class BaseAttributeArray
 {
 public:
   // Constructor
-  BaseAttributeArray() : mName("") {}
-  BaseAttributeArray(const char *name) : mName(name) {}
+  BaseAttributeArray(const void *type_id) : mName(""), mTypeId(type_id) {}
+  BaseAttributeArray(const void *type_id, const char *name) : mName(name), mTypeId(type_id) {}
+
+  // index of the removed elements in the remap of compact()
+  static constexpr size_t npos = std::numeric_limits<size_t>::max();
 
   //destructor
   virtual ~BaseAttributeArray() {}
@@ -50,6 +75,12 @@ public:
     return mName;
   }
 
+  // Return the identifier of the value type, see AttributeTypeId
+  const void *type_id() const
+  {
+    return mTypeId;
+  }
+
   // Return the size of the array
   virtual size_t size() const = 0;
 
@@ -62,6 +93,10 @@ public:
   // Extend the number of elements by n elements.
   virtual void increase_size(size_t n = 1) = 0;
 
+  // Append n elements copied from src, or default elements if src is null.
+  // src must point to n values of the type of the attribute.
+  virtual void append(const void *src, size_t n) = 0;
+
   // Empty the container storage
   virtual void clear() = 0;
 
@@ -71,14 +106,32 @@ public:
   // Swap the storate space of two elements
   virtual void swap(size_t i, size_t j) = 0;
 
+  // Move the last element to i and shrink the array by one.
+  virtual void swap_and_pop(size_t i) = 0;
+
+  // Move each element i to remap[i], dropping those mapped to npos, and shrink the array to n elements.
+  // remap must be increasing over the kept elements, i.e. remap[i] <= i.
+  virtual void compact(const size_t *remap, size_t n) = 0;
+
+  // Reorder the elements so that the new element i is the old element perm[i].
+  // perm must be a permutation of [0, size()).
+  virtual void permute(const size_t *perm) = 0;
+
   // Return a deep copy of self.
   virtual BaseAttributeArray *clone() const = 0;
 
   // Return the type_info of the attribute
   virtual const std::type_info &type() const = 0;
 
+  // Return the address of the contiguous values, nullptr if they are not stored contiguously
+  virtual const void *raw_data() const = 0;
+
+  // Return the size in bytes of one value
+  virtual size_t element_size() const = 0;
+
 protected:
   std::string mName;
+  const void *mTypeId;
 };
 
 // AttributeArray class ========================================================================
@@ -94,12 +147,12 @@ public:
   typedef typename ContainerType::const_reference ConstRef;
 
   AttributeArray(T t = T())
-      : BaseAttributeArray(), mDefault(t)
+      : BaseAttributeArray(AttributeTypeId<T>::get()), mDefault(t)
   {
   }
 
   AttributeArray(const char *name, T t = T())
-      : BaseAttributeArray(name), mDefault(t)
+      : BaseAttributeArray(AttributeTypeId<T>::get(), name), mDefault(t)
   {
   }
 
@@ -122,11 +175,25 @@ public:
 
   virtual void increase_size(size_t n = 1)
   {
-    for (size_t i = 0; i < n; ++i)
-      mData.push_back(mDefault);
+    append(nullptr, n);
+  }
+
+  virtual void append(const void *src, size_t n)
+  {
+    const size_t size = mData.size();
+    if (size + n > mData.capacity())
+      mData.reserve(std::max(size + n, 2 * mData.capacity()));
+
+    if (src != nullptr)
+    {
+      const T *first = static_cast<const T *>(src);
+      mData.insert(mData.end(), first, first + n);
+    }
+    else
+      mData.resize(size + n, mDefault);
   }
 
-  virtual void clear() = 0
+  virtual void clear()
   {
     mData.clear();
   }
@@ -143,6 +210,30 @@ public:
     mData[j] = temp;
   }
 
+  virtual void swap_and_pop(size_t i)
+  {
+    if (i + 1 != mData.size())
+      mData[i] = std::move(mData.back());
+    mData.pop_back();
+  }
+
+  virtual void compact(const size_t *remap, size_t n)
+  {
+    for (size_t i = 0; i < mData.size(); ++i)
+      if (remap[i] != npos && remap[i] != i)
+        mData[remap[i]] = std::move(mData[i]);
+    mData.erase(mData.begin() + n, mData.end());
+  }
+
+  virtual void permute(const size_t *perm)
+  {
+    ContainerType tmp;
+    tmp.reserve(mData.size());
+    for (size_t i = 0; i < mData.size(); ++i)
+      tmp.push_back(std::move(mData[perm[i]]));
+    mData.swap(tmp);
+  }
+
   virtual BaseAttributeArray *clone() const
   {
     AttributeArray<ValueType> *ptr = new AttributeArray<ValueType>(mName.c_str(), mDefault);
@@ -155,6 +246,19 @@ public:
     return typeid(ValueType);
   }
 
+  virtual const void *raw_data() const
+  {
+    if constexpr (std::is_same<ValueType, bool>::value)
+      return nullptr; // std::vector<bool> packs its bits
+    else
+      return mData.data();
+  }
+
+  virtual size_t element_size() const
+  {
+    return sizeof(ValueType);
+  }
+
   ValueType *data()
   {
     return mData.data();
@@ -267,27 +371,115 @@ private:
   AttributeArray<T> *mArray;
 };
 
+// AttributeHandle class =====================================================================
+
+// A typed index into the attribute table of an ElementAttributeList.
+// The handle stays valid until the attribute is removed or the list is assigned, and lookups
+// through it cost an index, a generation and a type check : no string hashing and no dynamic_cast.
+// A handle used with another list than the one it comes from resolves to null or to an attribute of type T.
+template <class T>
+class AttributeHandle
+{
+public:
+  AttributeHandle()
+      : mIndex(std::numeric_limits<uint32_t>::max()), mGeneration(0)
+  {
+  }
+
+  bool is_valid() const
+  {
+    return mIndex != std::numeric_limits<uint32_t>::max();
+  }
+
+  operator bool() const
+  {
+    return is_valid();
+  }
+
+  uint32_t index() const
+  {
+    return mIndex;
+  }
+
+  uint32_t generation() const
+  {
+    return mGeneration;
+  }
+
+  bool operator==(const AttributeHandle &other) const
+  {
+    return mIndex == other.mIndex && mGeneration == other.mGeneration;
+  }
+
+  bool operator!=(const AttributeHandle &other) const
+  {
+    return !operator==(other);
+  }
+
+private:
+  friend class ElementAttributeList;
+
+  AttributeHandle(uint32_t index, uint32_t generation)
+      : mIndex(index), mGeneration(generation)
+  {
+  }
+
+  uint32_t mIndex;      // slot in the attribute table
+  uint32_t mGeneration; // generation of the slot when the handle was made
+};
+
+// AttributeSpan class =======================================================================
+
+// The values of one attribute for a batch of elements, see ElementAttributeList::append().
+class AttributeSpan
+{
+public:
+  template <class T>
+  AttributeSpan(AttributeHandle<T> h, const T *data)
+      : mData(data), mTypeId(AttributeTypeId<T>::get()), mIndex(h.index()), mGeneration(h.generation())
+  {
+  }
+
+private:
+  friend class ElementAttributeList;
+
+  const void *mData;    // values of the new elements
+  const void *mTypeId;  // type of the values
+  uint32_t mIndex;      // handle of the attribute
+  uint32_t mGeneration;
+};
+
 // ElementAttributeList class =================================================================
 
 class ElementAttributeList
 {
 private:
-  typedef std::unordered_map<std::string, BaseAttributeArray *> DictionnaryType;
+  // an entry of the attribute table, the array of a free slot is null.
+  // the generation is incremented each time the slot is freed to invalidate its handles.
+  struct Slot
+  {
+    std::string name;
+    BaseAttributeArray *array;
+    uint32_t generation;
+  };
+
+  typedef std::vector<Slot> TableType;
 
 public:
   // default constructor
   ElementAttributeList()
-      : mSize(0)
+      : mNumAttributes(0), mSize(0), mNumDeleted(0)
   {
   }
 
   ElementAttributeList(size_t size)
-      : mSize(size)
+      : mNumAttributes(0), mSize(size), mNumDeleted(0)
   {
   }
 
   // copy constructor : performs a deep copy of all the element attributes
   ElementAttributeList(const ElementAttributeList &other)
+      : mNumAttributes(0), mSize(0), mNumDeleted(0)
   {
     operator=(other);
   }
@@ -298,16 +490,26 @@ public:
     clear();
   }
 
-  // assign operator : performs a deep copy of all element attributes
+  // assign operator : performs a deep copy of all element attributes.
+  // the generations of the slots are advanced past those of both lists : the handles of this list
+  // and of other are not valid for the copy.
   ElementAttributeList &operator=(const ElementAttributeList &other)
   {
     if (this != &other)
     {
       clear();
-      mDict.reserve(other.num_attributes());
+      mTable.resize(std::max(mTable.size(), other.mTable.size()), Slot{std::string(), nullptr, 0});
+      for (size_t i = 0; i < other.mTable.size(); ++i)
+      {
+        const Slot &slot = other.mTable[i];
+        mTable[i].name = slot.name;
+        mTable[i].array = (slot.array != nullptr) ? slot.array->clone() : nullptr;
+        mTable[i].generation = std::max(mTable[i].generation, slot.generation) + 1;
+      }
+      mNumAttributes = other.mNumAttributes;
       mSize = other.size();
-      for (const auto &it : other.mDict)
-        mDict[it.first] = it.second->clone();
+      mDeleted = other.mDeleted;
+      mNumDeleted = other.mNumDeleted;
     }
 
     return *this;
@@ -315,86 +517,161 @@ public:
 
   size_t num_attributes() const
   {
-    return mDict.size();
+    return mNumAttributes;
   }
 
   std::vector<std::string> attributes() const
   {
     std::vector<std::string> names;
     names.reserve(num_attributes());
-    for (const auto &it : mDict)
-      names.emplace_back(it.first);
+    for (const Slot &slot : mTable)
+      if (slot.array != nullptr)
+        names.emplace_back(slot.name);
     return names;
   }
 
+  bool contains(const std::string &name) const
+  {
+    return find(name) != npos;
+  }
+
+  // return the untyped array of the attribute, nullptr if it does not exist
+  const BaseAttributeArray *attribute(const std::string &name) const
+  {
+    const size_t i = find(name);
+    return (i == npos) ? nullptr : mTable[i].array;
+  }
+
   const std::type_info &type(const std::string &name) const
   {
-    return mDict.at(name)->type();
+    const size_t i = find(name);
+    if (i == npos)
+      throw std::out_of_range("ElementAttributeList::type() : attribute \"" + name + "\" does not exist");
+    return mTable[i].array->type();
+  }
+
+  // return a handle to the attribute, invalid if it does not exist or if its type is not T
+  template <class T>
+  AttributeHandle<T> handle(const std::string &name) const
+  {
+    const size_t i = find(name);
+    if (i == npos)
+    {
+      std::cerr << "[ElementAttributeList::handle()] : attribute with name \"" << name << "\" does not exist.\n";
+      return AttributeHandle<T>();
+    }
+
+    if (mTable[i].array->type_id() != AttributeTypeId<T>::get())
+      return AttributeHandle<T>();
+
+    return AttributeHandle<T>(uint32_t(i), mTable[i].generation);
+  }
+
+  // return true if the attribute referred to by the handle is still in the list
+  template <class T>
+  bool contains(AttributeHandle<T> h) const
+  {
+    return array(h) != nullptr;
+  }
+
+  // return the array referred to by the handle, nullptr if the attribute was removed
+  // or if the slot holds an attribute of another type
+  template <class T>
+  AttributeArray<T> *array(AttributeHandle<T> h) const
+  {
+    if (h.mIndex >= mTable.size() || mTable[h.mIndex].generation != h.mGeneration ||
+        mTable[h.mIndex].array == nullptr || mTable[h.mIndex].array->type_id() != AttributeTypeId<T>::get())
+      return nullptr;
+    return static_cast<AttributeArray<T> *>(mTable[h.mIndex].array);
+  }
+
+  template <class T>
+  ElementAttribute<T> get(AttributeHandle<T> h) const
+  {
+    return ElementAttribute<T>(array(h));
   }
 
   template <class T>
   ElementAttribute<T> get(const std::string &name) const
   {
-    DictionnaryType::const_iterator it = mDict.find(name);
-    if (it == mDict.end())
+    const size_t i = find(name);
+    if (i == npos)
     {
       std::cerr << "[ElementAttributeList::get()] : attribute with name \"" << name << "\" does not exist.\n";
       return ElementAttribute<T>(); // points to null attribute
     }
 
-    return ElementAttribute<T>(dynamic_cast<AttributeArray<T> *>((*it).second));
+    if (mTable[i].array->type_id() != AttributeTypeId<T>::get())
+      return ElementAttribute<T>(); // points to null attribute
+
+    return ElementAttribute<T>(static_cast<AttributeArray<T> *>(mTable[i].array));
   }
 
+  // add an attribute and return its handle, invalid if the name is already used
   template <class T>
-  ElementAttribute<T> add(const std::string &name, const T &t = T())
+  AttributeHandle<T> add_handle(const std::string &name, const T &t = T())
   {
-
-    if (mDict.find(name) != mDict.end())
+    if (find(name) != npos)
     {
       std::cerr << "[ElementAttributeList::add()] : attribute with name \"" << name << "\" already exists.\n";
-      return ElementAttribute<T>(); // points to null attribute;
+      return AttributeHandle<T>(); // points to null attribute;
     }
 
     AttributeArray<T> *ptr = new AttributeArray<T>(name.c_str(), t);
     ptr->resize(mSize);
-    bool ok = mDict.insert({name, ptr}).second;
-    if (!ok)
-    {
-      std::cerr << "[ElementAttributeList::add()] : unable to add attribute with name \"" << name << "\".\n";
-      return ElementAttribute<T>(); // points to null attribute;
-    }
 
-    return ElementAttribute<T>(dynamic_cast<AttributeArray<T> *>(mDict.at(name)));
+    // reuse the first free slot
+    size_t i = 0;
+    while (i < mTable.size() && mTable[i].array != nullptr)
+      ++i;
+    if (i == mTable.size())
+      mTable.push_back(Slot{std::string(), nullptr, 0});
+
+    mTable[i].name = name;
+    mTable[i].array = ptr;
+    ++mNumAttributes;
+
+    return AttributeHandle<T>(uint32_t(i), mTable[i].generation);
+  }
+
+  template <class T>
+  ElementAttribute<T> add(const std::string &name, const T &t = T())
+  {
+    return get(add_handle(name, t));
   }
 
   bool remove(const std::string &name)
   {
-    DictionnaryType::iterator it = mDict.find(name);
-    if (it == mDict.end())
+    const size_t i = find(name);
+    if (i == npos)
     {
       std::cerr << "[ElementAttributeList::remove()] : attribute with name \"" << name << "\" does not exist.\n";
       return false;
     }
 
-    delete (*it).second;
-    (*it).second = nullptr;
-    size_t n = mDict.erase(name);
-
-    if (n == 0)
-      std::cerr << "[ElementAttributeList::remove()] : unable to remove attribute with name \"" << name << "\".\n";
-
-    return n > 0;
+    release(mTable[i]);
+    return true;
   }
 
-  void clear()
+  template <class T>
+  bool remove(AttributeHandle<T> h)
   {
-    for (auto &it : mDict)
+    if (array(h) == nullptr)
     {
-      delete it.second;
-      it.second = nullptr;
+      std::cerr << "[ElementAttributeList::remove()] : invalid attribute handle.\n";
+      return false;
     }
 
-    mDict.clear();
+    release(mTable[h.mIndex]);
+    return true;
+  }
+
+  // delete all attributes, their handles become invalid
+  void clear()
+  {
+    for (Slot &slot : mTable)
+      if (slot.array != nullptr)
+        release(slot);
   }
 
   // return attribute size
@@ -406,43 +683,344 @@ public:
   // Reserve memory for n elements.
   void reserve(size_t n)
   {
-    mSize = n;
-    for (auto &it : mDict)
-      it.second->reserve(n);
+    for (Slot &slot : mTable)
+      if (slot.array != nullptr)
+        slot.array->reserve(n);
   }
 
   // Resize storage to hold n elements.
   void resize(size_t n)
   {
+    for (size_t i = n; i < mSize && mNumDeleted > 0; ++i)
+      set_deleted(i, false);
+
     mSize = n;
-    for (auto &it : mDict)
-      it.second->resize(n);
+    for (Slot &slot : mTable)
+      if (slot.array != nullptr)
+        slot.array->resize(n);
   }
 
   // Extend the number of elements by n.
   void increase_size(size_t n = 1)
   {
-    for (auto &it : mDict)
-      it.second->increase_size(n);
+    append(n);
+  }
+
+  // Append n elements with default values to every attribute, with a single
+  // reallocation per attribute, and return the index of the first new element.
+  size_t append(size_t n = 1)
+  {
+    for (Slot &slot : mTable)
+      if (slot.array != nullptr)
+        slot.array->append(nullptr, n);
+
+    mSize += n;
+    return mSize - n;
+  }
+
+  // Append n elements, copying the values of the attributes listed in spans and
+  // giving default values to the others. Return the index of the first new element.
+  // If a span refers to a removed attribute or does not match its type,
+  // an exception of type std::invalid_argument is thrown and the list is left unchanged.
+  size_t append(size_t n, const std::vector<AttributeSpan> &spans)
+  {
+    std::vector<const void *> sources(mTable.size(), nullptr);
+    for (const AttributeSpan &span : spans)
+    {
+      if (span.mIndex >= mTable.size() || mTable[span.mIndex].generation != span.mGeneration ||
+          mTable[span.mIndex].array == nullptr)
+        throw std::invalid_argument("ElementAttributeList::append() : invalid attribute handle");
+      if (mTable[span.mIndex].array->type_id() != span.mTypeId)
+        throw std::invalid_argument("ElementAttributeList::append() : type mismatch for attribute \"" + mTable[span.mIndex].name + "\"");
+      sources[span.mIndex] = span.mData;
+    }
+
+    for (size_t i = 0; i < mTable.size(); ++i)
+      if (mTable[i].array != nullptr)
+        mTable[i].array->append(sources[i], n);
+
+    mSize += n;
+    return mSize - n;
   }
 
   // Free unused memory.
   void shrink_to_fit()
   {
-    for (auto &it : mDict)
-      it.second->shrink_to_fit();
+    for (Slot &slot : mTable)
+      if (slot.array != nullptr)
+        slot.array->shrink_to_fit();
   }
 
   // swap two elements
   void swap(size_t i, size_t j)
   {
-    for (auto &it : mDict)
-      it.second->swap(i, j);
+    for (Slot &slot : mTable)
+      if (slot.array != nullptr)
+        slot.array->swap(i, j);
+
+    if (mNumDeleted > 0)
+    {
+      const bool di = is_deleted(i), dj = is_deleted(j);
+      set_deleted(i, dj);
+      set_deleted(j, di);
+    }
+  }
+
+  // Remove element i in O(1) by moving the last element in its place.
+  // The order of the elements is not preserved.
+  void swap_and_pop(size_t i)
+  {
+    for (Slot &slot : mTable)
+      if (slot.array != nullptr)
+        slot.array->swap_and_pop(i);
+
+    if (mNumDeleted > 0)
+    {
+      const bool last = is_deleted(mSize - 1);
+      set_deleted(mSize - 1, false);
+      if (i != mSize - 1)
+        set_deleted(i, last);
+    }
+    --mSize;
+  }
+
+  // Mark element i as deleted, it stays in the attributes until compact() is called.
+  // If i is not the index of an element, an exception of type std::out_of_range is thrown.
+  void mark_deleted(size_t i)
+  {
+    if (i >= mSize)
+      throw std::out_of_range("ElementAttributeList::mark_deleted() : invalid element index");
+    set_deleted(i, true);
+  }
+
+  bool is_deleted(size_t i) const
+  {
+    return (i / 64 < mDeleted.size()) && ((mDeleted[i / 64] >> (i % 64)) & 1);
+  }
+
+  // number of elements marked as deleted
+  size_t num_deleted() const
+  {
+    return mNumDeleted;
+  }
+
+  // Remove the elements marked as deleted, keeping the order of the others, and return
+  // the index of each old element in the compacted list (npos for the removed ones).
+  // The attributes are compacted in parallel.
+  std::vector<size_t> compact()
+  {
+    std::vector<size_t> remap(mSize);
+    size_t n = 0;
+    for (size_t i = 0; i < mSize; ++i)
+      remap[i] = is_deleted(i) ? npos : n++;
+
+    if (n != mSize)
+    {
+      std::vector<BaseAttributeArray *> arrays;
+      for (Slot &slot : mTable)
+        if (slot.array != nullptr)
+          arrays.push_back(slot.array);
+
+      parallel_for_dynamic(0, arrays.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t a = begin; a < end; ++a)
+          arrays[a]->compact(remap.data(), n);
+      });
+    }
+
+    mSize = n;
+    mDeleted.clear();
+    mNumDeleted = 0;
+    return remap;
+  }
+
+  // Reorder the elements so that the new element i is the old element perm[i], with one
+  // out-of-place gather per attribute, the attributes being processed in parallel.
+  // perm must be a permutation of [0, size()), if its size does not match,
+  // an exception of type std::invalid_argument is thrown.
+  void apply_permutation(const std::vector<size_t> &perm)
+  {
+    if (perm.size() != mSize)
+      throw std::invalid_argument("ElementAttributeList::apply_permutation() : the permutation does not match the number of elements");
+
+    std::vector<BaseAttributeArray *> arrays;
+    for (Slot &slot : mTable)
+      if (slot.array != nullptr)
+        arrays.push_back(slot.array);
+
+    parallel_for_dynamic(0, arrays.size(), 1, [&](size_t begin, size_t end) {
+      for (size_t a = begin; a < end; ++a)
+        arrays[a]->permute(perm.data());
+    });
+
+    if (mNumDeleted > 0)
+    {
+      std::vector<uint64_t> deleted((mSize + 63) / 64, 0);
+      for (size_t i = 0; i < mSize; ++i)
+        if (is_deleted(perm[i]))
+          deleted[i / 64] |= uint64_t(1) << (i % 64);
+      mDeleted.swap(deleted);
+    }
+  }
+
+  // Stable sort of the elements by increasing value of an integer or floating point attribute,
+  // with a parallel radix sort. Return the permutation applied, see apply_permutation().
+  // If the attribute does not exist, an exception of type std::invalid_argument is thrown.
+  template <class T>
+  std::vector<size_t> sort_by(AttributeHandle<T> h)
+  {
+    static_assert(std::is_arithmetic<T>::value, "ElementAttributeList::sort_by() : the key must be an integer or a floating point");
+
+    const AttributeArray<T> *keys = array(h);
+    if (keys == nullptr)
+      throw std::invalid_argument("ElementAttributeList::sort_by() : invalid attribute handle");
+
+    typedef std::conditional_t<sizeof(T) <= 1, uint8_t,
+                               std::conditional_t<sizeof(T) <= 2, uint16_t,
+                                                  std::conditional_t<sizeof(T) <= 4, uint32_t, uint64_t>>>
+        KeyType;
+
+    std::vector<KeyType> radix(mSize);
+    for (size_t i = 0; i < mSize; ++i)
+      radix[i] = radix_key<KeyType>((*keys)[i]);
+
+    std::vector<size_t> perm(mSize);
+    std::iota(perm.begin(), perm.end(), size_t(0));
+    radix_sort(radix, perm);
+
+    apply_permutation(perm);
+    return perm;
+  }
+
+  template <class T>
+  std::vector<size_t> sort_by(const std::string &name)
+  {
+    return sort_by(handle<T>(name));
   }
 
+  static constexpr size_t npos = BaseAttributeArray::npos;
+
 private:
-  DictionnaryType mDict;
-  size_t mSize;
+  // unsigned key with the same order as x : the sign bit of integers is flipped,
+  // all the bits of negative floating points and the sign bit of the positive ones.
+  template <class K, class T>
+  static K radix_key(T x)
+  {
+    const K sign = K(K(1) << (sizeof(K) * 8 - 1));
+    if constexpr (std::is_floating_point<T>::value)
+    {
+      K u;
+      std::memcpy(&u, &x, sizeof(K));
+      return (u & sign) ? K(~u) : K(u | sign);
+    }
+    else if constexpr (std::is_signed<T>::value)
+      return K(K(x) ^ sign);
+    else
+      return K(x);
+  }
+
+  // stable LSD radix sort of keys, 8 bits per pass, carrying perm along.
+  // each thread counts and scatters a contiguous chunk, the passes where all the keys
+  // share the same digit are skipped.
+  template <class K>
+  static void radix_sort(std::vector<K> &keys, std::vector<size_t> &perm)
+  {
+    const size_t n = keys.size();
+    const size_t nchunk = std::max<size_t>(1, std::min(ThreadPool::global().num_threads(), n / 16384));
+    std::vector<K> keys_tmp(n);
+    std::vector<size_t> perm_tmp(n);
+    std::vector<size_t> count(nchunk * 256);
+
+    for (size_t shift = 0; shift < sizeof(K) * 8; shift += 8)
+    {
+      parallel_for(0, nchunk, 1, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c)
+        {
+          size_t *h = count.data() + c * 256;
+          std::fill(h, h + 256, size_t(0));
+          for (size_t i = c * n / nchunk; i < (c + 1) * n / nchunk; ++i)
+            ++h[(keys[i] >> shift) & 255];
+        }
+      });
+
+      // exclusive prefix sum in digit major, chunk minor order
+      bool skip = false;
+      size_t offset = 0;
+      for (size_t d = 0; d < 256; ++d)
+      {
+        size_t total = 0;
+        for (size_t c = 0; c < nchunk; ++c)
+        {
+          const size_t k = count[c * 256 + d];
+          count[c * 256 + d] = offset;
+          offset += k;
+          total += k;
+        }
+        skip = skip || (total == n);
+      }
+      if (skip)
+        continue;
+
+      parallel_for(0, nchunk, 1, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c)
+        {
+          size_t *h = count.data() + c * 256;
+          for (size_t i = c * n / nchunk; i < (c + 1) * n / nchunk; ++i)
+          {
+            const size_t j = h[(keys[i] >> shift) & 255]++;
+            keys_tmp[j] = keys[i];
+            perm_tmp[j] = perm[i];
+          }
+        }
+      });
+
+      keys.swap(keys_tmp);
+      perm.swap(perm_tmp);
+    }
+  }
+
+  void set_deleted(size_t i, bool deleted)
+  {
+    if (i / 64 >= mDeleted.size())
+    {
+      if (!deleted)
+        return;
+      mDeleted.resize(i / 64 + 1, 0);
+    }
+
+    const uint64_t bit = uint64_t(1) << (i % 64);
+    if (((mDeleted[i / 64] & bit) != 0) != deleted)
+    {
+      mDeleted[i / 64] ^= bit;
+      mNumDeleted += deleted ? 1 : size_t(-1);
+    }
+  }
+
+  // index of the attribute in the table, npos if it does not exist.
+  // a linear scan over a contiguous table beats hashing for the few attributes of a list.
+  size_t find(const std::string &name) const
+  {
+    for (size_t i = 0; i < mTable.size(); ++i)
+      if (mTable[i].array != nullptr && mTable[i].name == name)
+        return i;
+    return npos;
+  }
+
+  // delete the attribute of a slot and invalidate its handles
+  void release(Slot &slot)
+  {
+    delete slot.array;
+    slot.array = nullptr;
+    slot.name.clear();
+    ++slot.generation;
+    --mNumAttributes;
+  }
+
+  TableType mTable;      // attribute table, indexed by the handles
+  size_t mNumAttributes; // number of used slots
+  size_t mSize;          // number of elements
+
+  std::vector<uint64_t> mDeleted; // bitmap of the elements marked as deleted
+  size_t mNumDeleted;             // number of bits set in mDeleted
 };
 
 #endif
\ No newline at end of file
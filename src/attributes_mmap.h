@@ -0,0 +1,558 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __ATTRIBUTE_MMAP_H__
+#define __ATTRIBUTE_MMAP_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#error "attributes_mmap.h relies on POSIX mmap and is not available on Windows"
+#endif
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "array2d_mmap.h"
+#include "attributes.h"
+
+/**
+ * @Brief
+ * Columnar binary files of ElementAttributeList, memory mapped for loading.
+ * 
+ * The file starts with a 64 bytes header (magic, version, byte order, number of elements and
+ * of columns), followed by a table of 64 bytes column entries (type tag, element size, element
+ * count, name and data offsets), the names, and the raw columns aligned on 64 bytes.
+ * The type tags are those of array2d files, only the arithmetic types can be stored.
+ * 
+ * Loading maps the file read only : each column is exposed as an AttributeView without any copy,
+ * and pages are loaded by the OS when they are first accessed. Writing streams each column from
+ * the data() of its attribute.
+ * 
+ * example:
+ * -------
+ * write_attributes(particles, "particles.attr");
+ * 
+ * MappedAttributeList file("particles.attr");
+ * AttributeView<float> mass = file.get<float>("mass");
+ * ElementAttributeList copy = file.to_list();
+ */
+
+// File Format ================================================================================
+
+struct AttributeFileHeader
+{
+  static constexpr char MAGIC[8] = {'A', 'T', 'T', 'R', 'L', 'I', 'S', 'T'};
+  static constexpr uint32_t VERSION = 1;
+  static constexpr uint32_t ENDIAN_MARK = 0x01020304; // reads differently on a machine of the other endianness
+  static constexpr uint64_t ALIGNMENT = 64;           // alignment of the columns in the file
+
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint64_t numElements;
+  uint64_t numColumns;
+  uint64_t tableOffset; // position of the first column entry
+  uint64_t padding[3];
+};
+
+struct AttributeColumnEntry
+{
+  std::array2d_type type;
+  uint32_t elemSize;
+  uint64_t count;      // number of elements
+  uint64_t nameOffset; // position of the name, not null terminated
+  uint64_t nameSize;
+  uint64_t offset; // position of the first element
+  uint64_t padding[3];
+};
+
+static_assert(sizeof(AttributeFileHeader) == 64, "AttributeFileHeader must be 64 bytes");
+static_assert(sizeof(AttributeColumnEntry) == 64, "AttributeColumnEntry must be 64 bytes");
+
+namespace attribute_detail
+{
+  // type tag of the attribute type identified by type_id, CUSTOM for the types that cannot be stored
+  inline std::array2d_type type_tag(const void *type_id)
+  {
+    if (type_id == AttributeTypeId<int8_t>::get())
+      return std::array2d_type::INT8;
+    if (type_id == AttributeTypeId<uint8_t>::get())
+      return std::array2d_type::UINT8;
+    if (type_id == AttributeTypeId<int16_t>::get())
+      return std::array2d_type::INT16;
+    if (type_id == AttributeTypeId<uint16_t>::get())
+      return std::array2d_type::UINT16;
+    if (type_id == AttributeTypeId<int32_t>::get())
+      return std::array2d_type::INT32;
+    if (type_id == AttributeTypeId<uint32_t>::get())
+      return std::array2d_type::UINT32;
+    if (type_id == AttributeTypeId<int64_t>::get())
+      return std::array2d_type::INT64;
+    if (type_id == AttributeTypeId<uint64_t>::get())
+      return std::array2d_type::UINT64;
+    if (type_id == AttributeTypeId<float>::get())
+      return std::array2d_type::FLOAT32;
+    if (type_id == AttributeTypeId<double>::get())
+      return std::array2d_type::FLOAT64;
+    return std::array2d_type::CUSTOM;
+  }
+
+  // calls f(T()) with the type T of the tag, returns false for CUSTOM
+  template <class F>
+  bool visit_type(std::array2d_type tag, F &&f)
+  {
+    switch (tag)
+    {
+    case std::array2d_type::INT8:
+      f(int8_t());
+      return true;
+    case std::array2d_type::UINT8:
+      f(uint8_t());
+      return true;
+    case std::array2d_type::INT16:
+      f(int16_t());
+      return true;
+    case std::array2d_type::UINT16:
+      f(uint16_t());
+      return true;
+    case std::array2d_type::INT32:
+      f(int32_t());
+      return true;
+    case std::array2d_type::UINT32:
+      f(uint32_t());
+      return true;
+    case std::array2d_type::INT64:
+      f(int64_t());
+      return true;
+    case std::array2d_type::UINT64:
+      f(uint64_t());
+      return true;
+    case std::array2d_type::FLOAT32:
+      f(float());
+      return true;
+    case std::array2d_type::FLOAT64:
+      f(double());
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  inline uint64_t align(uint64_t x)
+  {
+    return (x + AttributeFileHeader::ALIGNMENT - 1) / AttributeFileHeader::ALIGNMENT * AttributeFileHeader::ALIGNMENT;
+  }
+
+  // writes the n bytes of src at offset, handling partial writes
+  inline bool write_at(int fd, const void *src, uint64_t n, uint64_t offset)
+  {
+    const char *p = static_cast<const char *>(src);
+    while (n > 0)
+    {
+      const ssize_t k = ::pwrite(fd, p, size_t(n), off_t(offset));
+      if (k < 0 && errno == EINTR)
+        continue;
+      if (k <= 0)
+        return false;
+      p += k;
+      n -= uint64_t(k);
+      offset += uint64_t(k);
+    }
+    return true;
+  }
+}
+
+// write_attributes ===========================================================================
+
+// Write all the attributes of list to the file at path, the columns being written straight from
+// the attribute arrays. The elements marked as deleted are written, see ElementAttributeList::compact().
+// If an attribute is not of an arithmetic type or does not hold list.size() elements, an exception
+// of type std::invalid_argument is thrown before anything is written, if the file cannot be written,
+// an exception of type std::runtime_error is thrown.
+inline void write_attributes(const ElementAttributeList &list, const std::string &path)
+{
+  const std::vector<std::string> names = list.attributes();
+
+  // layout : header, column table, names, aligned columns
+  std::vector<AttributeColumnEntry> table(names.size());
+  uint64_t offset = sizeof(AttributeFileHeader) + names.size() * sizeof(AttributeColumnEntry);
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    const BaseAttributeArray *a = list.attribute(names[i]);
+    std::memset(&table[i], 0, sizeof(AttributeColumnEntry));
+    table[i].type = attribute_detail::type_tag(a->type_id());
+    // bool has no tag : std::vector<bool> does not store bools contiguously
+    if (table[i].type == std::array2d_type::CUSTOM)
+      throw std::invalid_argument("write_attributes() : the type of attribute \"" + names[i] + "\" cannot be stored");
+    // an array resized behind the list would be read past its end
+    if (a->size() != list.size())
+      throw std::invalid_argument("write_attributes() : attribute \"" + names[i] + "\" does not hold one element per element of the list");
+    table[i].elemSize = uint32_t(a->element_size());
+    table[i].count = a->size();
+    table[i].nameOffset = offset;
+    table[i].nameSize = names[i].size();
+    offset += names[i].size();
+  }
+  for (AttributeColumnEntry &e : table)
+  {
+    offset = attribute_detail::align(offset);
+    e.offset = offset;
+    offset += e.count * e.elemSize;
+  }
+
+  AttributeFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, AttributeFileHeader::MAGIC, sizeof(header.magic));
+  header.version = AttributeFileHeader::VERSION;
+  header.byteOrder = AttributeFileHeader::ENDIAN_MARK;
+  header.numElements = list.size();
+  header.numColumns = names.size();
+  header.tableOffset = sizeof(AttributeFileHeader);
+
+  int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    throw std::runtime_error("attribute file \"" + path + "\" : unable to create");
+
+  // the gaps between the columns are left as holes of zeros
+  bool ok = ::ftruncate(fd, off_t(offset)) == 0 &&
+            attribute_detail::write_at(fd, &header, sizeof(header), 0) &&
+            attribute_detail::write_at(fd, table.data(), table.size() * sizeof(AttributeColumnEntry), header.tableOffset);
+  for (size_t i = 0; ok && i < names.size(); ++i)
+  {
+    const BaseAttributeArray *a = list.attribute(names[i]);
+    ok = attribute_detail::write_at(fd, names[i].data(), table[i].nameSize, table[i].nameOffset) &&
+         (table[i].count == 0 || attribute_detail::write_at(fd, a->raw_data(), table[i].count * table[i].elemSize, table[i].offset));
+  }
+
+  if (::close(fd) != 0 || !ok)
+    throw std::runtime_error("attribute file \"" + path + "\" : unable to write");
+}
+
+// AttributeView class ========================================================================
+
+// A read only view over the values of an attribute, it does not own them.
+template <class T>
+class AttributeView
+{
+public:
+  typedef T ValueType;
+  typedef const T &ConstRef;
+
+  AttributeView(const T *data = nullptr, size_t size = 0)
+      : mData(data), mSize(size)
+  {
+  }
+
+  operator bool() const
+  {
+    return mData != nullptr;
+  }
+
+  size_t size() const
+  {
+    return mSize;
+  }
+
+  bool empty() const
+  {
+    return mSize == 0;
+  }
+
+  const T *data() const
+  {
+    return mData;
+  }
+
+  const T *begin() const
+  {
+    return mData;
+  }
+
+  const T *end() const
+  {
+    return mData + mSize;
+  }
+
+  ConstRef operator()(int i) const
+  {
+    return mData[i];
+  }
+
+  ConstRef operator[](int i) const
+  {
+    return mData[i];
+  }
+
+private:
+  const T *mData;
+  size_t mSize;
+};
+
+// MappedAttributeList class ==================================================================
+
+class MappedAttributeList
+{
+public:
+  MappedAttributeList()
+      : mBase(nullptr), mBytes(0), mSize(0)
+  {
+  }
+
+  // Map the attribute file at path read only. Only the header and the column table are read,
+  // the columns are loaded on access. If the file cannot be opened or is not a valid attribute file,
+  // an exception of type std::runtime_error is thrown.
+  MappedAttributeList(const std::string &path)
+      : mBase(nullptr), mBytes(0), mSize(0)
+  {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("attribute file \"" + path + "\" : unable to open");
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(AttributeFileHeader))
+    {
+      ::close(fd);
+      throw std::runtime_error("attribute file \"" + path + "\" : unable to read the header");
+    }
+
+    // an empty mapping is invalid, the header makes the file at least 64 bytes
+    mBytes = size_t(st.st_size);
+    mBase = ::mmap(nullptr, mBytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mBase == MAP_FAILED)
+    {
+      mBase = nullptr;
+      mBytes = 0;
+      throw std::runtime_error("attribute file \"" + path + "\" : mmap failed");
+    }
+
+    try
+    {
+      parse(path);
+    }
+    catch (...)
+    {
+      close();
+      throw;
+    }
+  }
+
+  MappedAttributeList(const MappedAttributeList &) = delete;
+  MappedAttributeList &operator=(const MappedAttributeList &) = delete;
+
+  MappedAttributeList(MappedAttributeList &&other) noexcept
+      : mBase(other.mBase), mBytes(other.mBytes), mSize(other.mSize), mColumns(std::move(other.mColumns))
+  {
+    other.mBase = nullptr;
+    other.mBytes = 0;
+    other.mSize = 0;
+  }
+
+  MappedAttributeList &operator=(MappedAttributeList &&other) noexcept
+  {
+    if (this != &other)
+    {
+      close();
+      mBase = other.mBase;
+      mBytes = other.mBytes;
+      mSize = other.mSize;
+      mColumns = std::move(other.mColumns);
+      other.mBase = nullptr;
+      other.mBytes = 0;
+      other.mSize = 0;
+    }
+    return *this;
+  }
+
+  virtual ~MappedAttributeList()
+  {
+    close();
+  }
+
+  bool is_open() const
+  {
+    return mBase != nullptr;
+  }
+
+  // number of elements
+  size_t size() const
+  {
+    return mSize;
+  }
+
+  size_t num_attributes() const
+  {
+    return mColumns.size();
+  }
+
+  std::vector<std::string> attributes() const
+  {
+    std::vector<std::string> names;
+    names.reserve(num_attributes());
+    for (const Column &c : mColumns)
+      names.push_back(c.name);
+    return names;
+  }
+
+  bool contains(const std::string &name) const
+  {
+    return find(name) != nullptr;
+  }
+
+  // type tag of the attribute, if it does not exist an exception of type std::out_of_range is thrown
+  std::array2d_type type(const std::string &name) const
+  {
+    const Column *c = find(name);
+    if (c == nullptr)
+      throw std::out_of_range("MappedAttributeList::type() : attribute \"" + name + "\" does not exist");
+    return c->type;
+  }
+
+  // return a view over the mapped values of the attribute, null if it does not exist or if its type is not T.
+  // the view must not outlive the MappedAttributeList.
+  template <class T>
+  AttributeView<T> get(const std::string &name) const
+  {
+    const Column *c = find(name);
+    if (c == nullptr)
+    {
+      std::cerr << "[MappedAttributeList::get()] : attribute with name \"" << name << "\" does not exist.\n";
+      return AttributeView<T>(); // points to null attribute
+    }
+
+    if (c->type != std::array2d_type_of<T>())
+      return AttributeView<T>(); // points to null attribute
+
+    return AttributeView<T>(static_cast<const T *>(c->data), c->count);
+  }
+
+  // Copy all the attributes into an ElementAttributeList.
+  ElementAttributeList to_list() const
+  {
+    ElementAttributeList list;
+    std::vector<AttributeSpan> spans;
+    for (const Column &c : mColumns)
+      attribute_detail::visit_type(c.type, [&](auto t) {
+        typedef decltype(t) T;
+        spans.emplace_back(list.add_handle<T>(c.name), static_cast<const T *>(c.data));
+      });
+    list.append(mSize, spans);
+    return list;
+  }
+
+  // Hints the OS that the columns will be read sequentially.
+  void advise_sequential() const
+  {
+    if (mBase != nullptr)
+      ::madvise(mBase, mBytes, MADV_SEQUENTIAL);
+  }
+
+  // Unmap the file, the views become invalid.
+  void close()
+  {
+    if (mBase != nullptr)
+      ::munmap(mBase, mBytes);
+    mBase = nullptr;
+    mBytes = 0;
+    mSize = 0;
+    mColumns.clear();
+  }
+
+private:
+  struct Column
+  {
+    std::string name;
+    std::array2d_type type;
+    size_t count;
+    const void *data;
+  };
+
+  const Column *find(const std::string &name) const
+  {
+    for (const Column &c : mColumns)
+      if (c.name == name)
+        return &c;
+    return nullptr;
+  }
+
+  // checks the header and the column table against the size of the mapping
+  void parse(const std::string &path)
+  {
+    const char *base = static_cast<const char *>(mBase);
+    AttributeFileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+
+    if (std::memcmp(header.magic, AttributeFileHeader::MAGIC, sizeof(header.magic)) != 0)
+      throw std::runtime_error("attribute file \"" + path + "\" : bad magic number");
+    if (header.version != AttributeFileHeader::VERSION)
+      throw std::runtime_error("attribute file \"" + path + "\" : unsupported version");
+    if (header.byteOrder != AttributeFileHeader::ENDIAN_MARK)
+      throw std::runtime_error("attribute file \"" + path + "\" : written on a machine of different endianness");
+    if (header.tableOffset < sizeof(header) || header.tableOffset > mBytes ||
+        header.numColumns > (mBytes - header.tableOffset) / sizeof(AttributeColumnEntry))
+      throw std::runtime_error("attribute file \"" + path + "\" : invalid column table");
+
+    mSize = size_t(header.numElements);
+    mColumns.resize(size_t(header.numColumns));
+    for (size_t i = 0; i < mColumns.size(); ++i)
+    {
+      AttributeColumnEntry e;
+      std::memcpy(&e, base + header.tableOffset + i * sizeof(e), sizeof(e));
+
+      size_t elemSize = 0;
+      attribute_detail::visit_type(e.type, [&](auto t) { elemSize = sizeof(t); });
+      if (elemSize == 0 || e.elemSize != elemSize)
+        throw std::runtime_error("attribute file \"" + path + "\" : unsupported column type");
+      if (e.count != header.numElements)
+        throw std::runtime_error("attribute file \"" + path + "\" : column size mismatch");
+      if (e.nameOffset > mBytes || e.nameSize > mBytes - e.nameOffset ||
+          e.offset % elemSize != 0 || e.offset > mBytes || e.count > (mBytes - e.offset) / elemSize)
+        throw std::runtime_error("attribute file \"" + path + "\" : truncated file");
+
+      mColumns[i].name.assign(base + e.nameOffset, size_t(e.nameSize));
+      mColumns[i].type = e.type;
+      mColumns[i].count = size_t(e.count);
+      mColumns[i].data = base + e.offset;
+    }
+  }
+
+  void *mBase;   // start of the mapping
+  size_t mBytes; // size of the mapping
+  size_t mSize;  // number of elements
+
+  std::vector<Column> mColumns;
+};
+
+#endif
@@ -0,0 +1,587 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __COMPRESSED_ARRAY_2D__
+#define __COMPRESSED_ARRAY_2D__
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "array2d_view.h"
+#include "parallel.h"
+#include "vector2d.h"
+
+/**
+ * @Brief
+ * A 2d array of integers or floating point values stored compressed, without loss, in tiles of TILE x TILE elements.
+ * 
+ * Each element of a tile is predicted from its neighbors above, on the left and on the upper left
+ * (x(c - 1, r) + x(c, r - 1) - x(c - 1, r - 1)), and only the difference with the prediction is kept.
+ * Floating point values are first mapped to integers of the same size whose order is the order of
+ * the values, so that close values give small differences. The differences are zigzag encoded and
+ * bit packed, each column of a tile with the number of bits of its largest difference : a smooth
+ * grid takes a few bits per element, a constant tile a few bytes.
+ * 
+ * Elements are accessed through a small cache of decompressed tiles. A tile is decompressed on its
+ * first access and recompressed when it is evicted, if it was modified, or on flush().
+ * Since reading may evict a tile, the array is not thread safe, even for reading.
+ * 
+ * example:
+ * -------
+ * std::vector2d<float> dem = load();
+ * std::compressed_array2d<float> c(dem);      // compresses the tiles in parallel
+ * float h = c(1200, 3400);                     // decompresses one tile
+ * c.set(1200, 3400, h + 1.f);
+ * std::cout << c.compression_ratio() << std::endl;
+ */
+
+namespace std
+{
+  namespace detail
+  {
+    // unsigned integer holding the bits of a T
+    template <typename T>
+    using packed_uint_t = std::conditional_t<sizeof(T) == 1, std::uint8_t,
+                                             std::conditional_t<sizeof(T) == 2, std::uint16_t,
+                                                                std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>>>;
+
+    // maps a value to an unsigned integer, preserving the order of floating point values
+    template <typename T>
+    inline packed_uint_t<T> to_ordered(const T &x) noexcept
+    {
+      typedef packed_uint_t<T> U;
+      U u;
+      std::memcpy(&u, &x, sizeof(T));
+      if constexpr (std::is_floating_point<T>::value)
+      {
+        constexpr U sign = U(U(1) << (8 * sizeof(U) - 1));
+        u = (u & sign) ? U(~u) : U(u | sign);
+      }
+      return u;
+    }
+
+    template <typename T>
+    inline T from_ordered(packed_uint_t<T> u) noexcept
+    {
+      typedef packed_uint_t<T> U;
+      if constexpr (std::is_floating_point<T>::value)
+      {
+        constexpr U sign = U(U(1) << (8 * sizeof(U) - 1));
+        u = (u & sign) ? U(u & ~sign) : U(~u);
+      }
+      T x;
+      std::memcpy(&x, &u, sizeof(T));
+      return x;
+    }
+
+    // zigzag encoding of a difference : 0, -1, 1, -2... become 0, 1, 2, 3...
+    template <typename U>
+    inline U zigzag(U d) noexcept
+    {
+      return U(U(d << 1) ^ U(U(0) - U(d >> (8 * sizeof(U) - 1))));
+    }
+
+    template <typename U>
+    inline U unzigzag(U z) noexcept
+    {
+      return U(U(z >> 1) ^ U(U(0) - U(z & 1)));
+    }
+
+    template <typename U>
+    inline unsigned bit_width(U x) noexcept
+    {
+      unsigned n = 0;
+      for (std::uint64_t v = x; v != 0; v >>= 1)
+        ++n;
+      return n;
+    }
+
+    inline std::uint64_t load_u64(const std::uint8_t *p) noexcept
+    {
+      std::uint64_t v;
+      std::memcpy(&v, p, sizeof(v));
+      return v;
+    }
+
+    inline void store_u64(std::uint8_t *p, std::uint64_t v) noexcept
+    {
+      std::memcpy(p, &v, sizeof(v));
+    }
+
+    // writes w bits of v at the bit position pos of a zeroed buffer, least significant bits first.
+    // The buffer must extend at least 8 bytes past the last bit written
+    inline void put_bits(std::uint8_t *out, std::uint64_t &pos, std::uint64_t v, unsigned w) noexcept
+    {
+      while (w > 0)
+      {
+        const unsigned n = std::min(w, 56u);
+        const std::uint64_t bits = v & (std::uint64_t(-1) >> (64 - n));
+        std::uint8_t *p = out + (pos >> 3);
+        store_u64(p, load_u64(p) | (bits << (pos & 7)));
+        pos += n;
+        v = (n < 64) ? v >> n : 0;
+        w -= n;
+      }
+    }
+
+    // reads w bits at the bit position pos, the buffer must extend at least 8 bytes past the last bit read
+    inline std::uint64_t get_bits(const std::uint8_t *in, std::uint64_t &pos, unsigned w) noexcept
+    {
+      std::uint64_t v = 0;
+      for (unsigned shift = 0; shift < w;)
+      {
+        const unsigned n = std::min(w - shift, 56u);
+        v |= ((load_u64(in + (pos >> 3)) >> (pos & 7)) & (std::uint64_t(-1) >> (64 - n))) << shift;
+        pos += n;
+        shift += n;
+      }
+      return v;
+    }
+
+    // upper bound of the size of a compressed B x B tile, padding included
+    template <typename T, size_t B>
+    constexpr size_t compressed_tile_bound = sizeof(T) + B * (1 + B * sizeof(T)) + 8;
+
+    // compresses the B x B tile t (column major) into out : the first element, then for each column
+    // the bit width of its residuals followed by the residuals packed on that many bits
+    template <typename T, size_t B>
+    void compress_tile(const T *t, std::vector<std::uint8_t> &out)
+    {
+      typedef packed_uint_t<T> U;
+
+      // reused from one call to the next
+      thread_local std::vector<std::uint8_t> buf;
+      buf.resize(compressed_tile_bound<T, B>);
+
+      std::array<U, B> prev, cur, res;
+      const U base = to_ordered(t[0]);
+      std::memcpy(buf.data(), &base, sizeof(U));
+
+      std::uint64_t pos = 8 * sizeof(U);
+      for (size_t c = 0; c < B; ++c)
+      {
+        for (size_t r = 0; r < B; ++r)
+          cur[r] = to_ordered(t[c * B + r]);
+
+        // lorenzo predictor, the first column is predicted from above, the first row from the left
+        if (c == 0)
+        {
+          res[0] = zigzag(U(cur[0] - base));
+          for (size_t r = 1; r < B; ++r)
+            res[r] = zigzag(U(cur[r] - cur[r - 1]));
+        }
+        else
+        {
+          res[0] = zigzag(U(cur[0] - prev[0]));
+          for (size_t r = 1; r < B; ++r)
+            res[r] = zigzag(U(cur[r] - prev[r] - cur[r - 1] + prev[r - 1]));
+        }
+
+        U m = 0;
+        for (size_t r = 0; r < B; ++r)
+          m |= res[r];
+        const unsigned width = bit_width(m);
+
+        // columns start on a byte, the residuals are accumulated in a register and stored 8 bytes at a time
+        std::uint8_t *p = buf.data() + (pos >> 3);
+        *p++ = std::uint8_t(width);
+        if (width == 0)
+          pos += 8;
+        else if (width <= 56)
+        {
+          std::uint64_t acc = 0;
+          unsigned nb = 0;
+          for (size_t r = 0; r < B; ++r)
+          {
+            acc |= std::uint64_t(res[r]) << nb;
+            nb += width;
+            if (nb >= 64)
+            {
+              store_u64(p, acc);
+              p += 8;
+              nb -= 64;
+              acc = (nb > 0) ? std::uint64_t(res[r]) >> (width - nb) : 0;
+            }
+          }
+          store_u64(p, acc);
+          pos = 8 * std::uint64_t(p - buf.data()) + nb;
+        }
+        else
+        {
+          std::memset(p, 0, B * sizeof(U) + 8);
+          pos += 8;
+          for (size_t r = 0; r < B; ++r)
+            put_bits(buf.data(), pos, res[r], width);
+        }
+        pos = (pos + 7) & ~std::uint64_t(7);
+        prev = cur;
+      }
+
+      // a new vector so that the capacity matches the size
+      std::vector<std::uint8_t>(buf.begin(), buf.begin() + std::ptrdiff_t(pos >> 3) + 8).swap(out);
+    }
+
+    template <typename T, size_t B>
+    void decompress_tile(const std::uint8_t *in, T *t) noexcept
+    {
+      typedef packed_uint_t<T> U;
+
+      U base;
+      std::memcpy(&base, in, sizeof(U));
+
+      std::array<U, B> prev, cur;
+      std::uint64_t pos = 8 * sizeof(U);
+      for (size_t c = 0; c < B; ++c)
+      {
+        const unsigned width = unsigned(get_bits(in, pos, 8));
+        if (width == 0)
+          cur.fill(U(0));
+        else if (width <= 56)
+        {
+          const std::uint64_t mask = std::uint64_t(-1) >> (64 - width);
+          for (size_t r = 0; r < B; ++r, pos += width)
+            cur[r] = U((load_u64(in + (pos >> 3)) >> (pos & 7)) & mask);
+        }
+        else
+        {
+          for (size_t r = 0; r < B; ++r)
+            cur[r] = U(get_bits(in, pos, width));
+        }
+        pos = (pos + 7) & ~std::uint64_t(7);
+
+        // the differences with the previous column are the prefix sums of the residuals
+        U d = (c == 0) ? base : U(0);
+        for (size_t r = 0; r < B; ++r)
+        {
+          d = U(d + unzigzag(cur[r]));
+          cur[r] = (c == 0) ? d : U(prev[r] + d);
+        }
+
+        for (size_t r = 0; r < B; ++r)
+          t[c * B + r] = from_ordered<T>(cur[r]);
+        prev = cur;
+      }
+    }
+  }
+
+  template <typename T, size_t TILE = 64>
+  class compressed_array2d
+  {
+    static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value && sizeof(T) <= 8,
+                  "compressed_array2d requires integer or floating point elements");
+    static_assert(TILE > 0 && TILE <= 256, "TILE must be in [1, 256]");
+
+  public:
+    //============================================
+    //              Member Types
+    //============================================
+    typedef T value_type;
+    typedef std::array<std::size_t, 2> size_type;
+
+    static constexpr size_t tile_size = TILE;
+    static constexpr size_t tile_elements = TILE * TILE;
+
+  public:
+    //============================================
+    //              Initialisation
+    //============================================
+    compressed_array2d() noexcept
+        : mCol(0), mRow(0), mTileRow(0), mClock(0), mLast(0)
+    {
+    }
+
+    /**
+   * @Brief
+   * Creates a col x row array filled with value, decompressed tiles being cached cache_tiles at a time.
+  **/
+    compressed_array2d(size_t col, size_t row, const T &value = T(), size_t cache_tiles = 16)
+        : mCol(col), mRow(row), mTileRow((row + TILE - 1) / TILE), mClock(0), mLast(0)
+    {
+      std::vector<T> tile(tile_elements, value);
+      mTiles.resize(num_tile_col() * mTileRow);
+      if (!mTiles.empty())
+        detail::compress_tile<T, TILE>(tile.data(), mTiles[0]);
+      for (size_t t = 1; t < mTiles.size(); ++t)
+        mTiles[t] = mTiles[0];
+      set_cache_size(cache_tiles);
+    }
+
+    /**
+   * @Brief
+   * Compresses the 2d array src (array2d, vector2d or view), the tiles being compressed in parallel.
+  **/
+    template <typename A, typename = detail::enable_2d_array<A>>
+    explicit compressed_array2d(const A &src, size_t cache_tiles = 16)
+        : mCol(src.num_col()), mRow(src.num_row()), mTileRow((src.num_row() + TILE - 1) / TILE), mClock(0), mLast(0)
+    {
+      mTiles.resize(num_tile_col() * mTileRow);
+
+      const auto *data = src.data();
+      const size_t ld = detail::leading_dim(src);
+      parallel_for(0, mTiles.size(), 1, [&](size_t begin, size_t end) {
+        std::vector<T> tile(tile_elements);
+        for (size_t t = begin; t < end; ++t)
+        {
+          // the elements past the border replicate the last column and row
+          const size_t c0 = (t / mTileRow) * TILE;
+          const size_t r0 = (t % mTileRow) * TILE;
+          for (size_t c = 0; c < TILE; ++c)
+          {
+            const auto *in = data + std::min(c0 + c, mCol - 1) * ld;
+            for (size_t r = 0; r < TILE; ++r)
+              tile[c * TILE + r] = in[std::min(r0 + r, mRow - 1)];
+          }
+          detail::compress_tile<T, TILE>(tile.data(), mTiles[t]);
+        }
+      });
+      set_cache_size(cache_tiles);
+    }
+
+    //============================================
+    //                Data Access
+    //============================================
+    /**
+   * @Brief
+   * Returns the element at specified location {col, row}, with bounds checking.
+   * If {col, row} is not within the range of the container, an exception of type std::out_of_range is thrown.
+  **/
+    T at(size_t col, size_t row) const
+    {
+      check_range(col, row);
+      return (*this)(col, row);
+    }
+
+    /**
+   * @Brief
+   * Returns the element at specified location {col, row}. No bounds checking is performed.
+  **/
+    T operator()(size_t col, size_t row) const
+    {
+      const T *t = fetch(tile_index(col, row), false);
+      return t[(col % TILE) * TILE + row % TILE];
+    }
+
+    /**
+   * @Brief
+   * Sets the element at specified location {col, row}. No bounds checking is performed.
+   * The tile is recompressed when it leaves the cache or on flush().
+  **/
+    void set(size_t col, size_t row, const T &value)
+    {
+      T *t = fetch(tile_index(col, row), true);
+      t[(col % TILE) * TILE + row % TILE] = value;
+    }
+
+    /**
+   * @Brief
+   * Decompresses all the elements into dst, the tiles being decompressed in parallel.
+   * A vector2d destination is resized, otherwise if the dimensions of dst do not match,
+   * an exception of type std::length_error is thrown.
+  **/
+    template <typename A>
+    void to_dense(A &dst) const
+    {
+      if constexpr (std::is_same<A, vector2d<typename A::value_type>>::value)
+      {
+        if (dst.num_col() != mCol || dst.num_row() != mRow)
+          dst.resize(mCol, mRow);
+      }
+
+      if (dst.num_col() != mCol || dst.num_row() != mRow)
+        throw std::length_error("compressed_array2d::to_dense : dimension mismatch");
+
+      flush();
+      auto *data = dst.data();
+      const size_t ld = detail::leading_dim(dst);
+      parallel_for(0, mTiles.size(), 1, [&](size_t begin, size_t end) {
+        std::vector<T> tile(tile_elements);
+        for (size_t t = begin; t < end; ++t)
+        {
+          detail::decompress_tile<T, TILE>(mTiles[t].data(), tile.data());
+          const size_t c0 = (t / mTileRow) * TILE;
+          const size_t r0 = (t % mTileRow) * TILE;
+          const size_t nr = std::min(TILE, mRow - r0);
+          for (size_t c = c0; c < std::min(c0 + TILE, mCol); ++c)
+            std::copy_n(tile.data() + (c - c0) * TILE, nr, data + c * ld + r0);
+        }
+      });
+    }
+
+    vector2d<T> to_dense() const
+    {
+      vector2d<T> dst(mCol, mRow);
+      to_dense(dst);
+      return dst;
+    }
+
+    //============================================
+    //                capacity
+    //============================================
+    inline size_type size() const noexcept { return {mCol, mRow}; }
+    inline size_t num() const noexcept { return mCol * mRow; }
+    inline size_t num_col() const noexcept { return mCol; }
+    inline size_t num_row() const noexcept { return mRow; }
+    inline bool empty() const noexcept { return num() == 0; }
+
+    inline size_t num_tile_col() const noexcept { return (mCol + TILE - 1) / TILE; }
+    inline size_t num_tile_row() const noexcept { return mTileRow; }
+
+    /**
+   * @Brief
+   * Returns the number of bytes of the compressed tiles, and the number of bytes used by the
+   * whole container including the cache of decompressed tiles.
+   * Modified tiles still in the cache are counted with their size before modification.
+  **/
+    size_t compressed_bytes() const noexcept
+    {
+      size_t n = 0;
+      for (const auto &t : mTiles)
+        n += t.capacity();
+      return n;
+    }
+
+    size_t memory() const noexcept
+    {
+      return sizeof(*this) + compressed_bytes() + mTiles.capacity() * sizeof(mTiles[0]) +
+             mCache.capacity() * sizeof(T) + mSlots.capacity() * sizeof(slot);
+    }
+
+    /**
+   * @Brief
+   * Returns the size of the uncompressed elements divided by the size of the compressed tiles.
+  **/
+    double compression_ratio() const noexcept
+    {
+      const size_t n = compressed_bytes();
+      return n > 0 ? double(num() * sizeof(T)) / double(n) : 0.0;
+    }
+
+    //============================================
+    //                operations
+    //============================================
+    /**
+   * @Brief
+   * Recompresses the modified tiles of the cache, which stay cached.
+  **/
+    void flush() const
+    {
+      for (size_t s = 0; s < mSlots.size(); ++s)
+        if (mSlots[s].dirty)
+        {
+          detail::compress_tile<T, TILE>(mCache.data() + s * tile_elements, mTiles[mSlots[s].tile]);
+          mSlots[s].dirty = false;
+        }
+    }
+
+    /**
+   * @Brief
+   * Sets the number of decompressed tiles kept in the cache (at least 1), flushing the cache.
+  **/
+    void set_cache_size(size_t n)
+    {
+      flush();
+      n = std::max<size_t>(n, 1);
+      mSlots.assign(n, slot());
+      mCache.assign(n * tile_elements, T());
+      mCache.shrink_to_fit();
+      mLast = 0;
+    }
+
+    inline size_t cache_size() const noexcept { return mSlots.size(); }
+
+  protected:
+    struct slot
+    {
+      size_t tile = size_t(-1); // cached tile, -1 if the slot is free
+      std::uint64_t used = 0;   // time of the last access
+      bool dirty = false;       // true if the tile was modified since it was decompressed
+    };
+
+    inline size_t tile_index(size_t col, size_t row) const noexcept
+    {
+      return (col / TILE) * mTileRow + row / TILE;
+    }
+
+    // returns the decompressed tile t, loading it in the least recently used slot if needed
+    T *fetch(size_t t, bool write) const
+    {
+      size_t s = mLast;
+      if (mSlots[s].tile != t)
+      {
+        s = 0;
+        for (size_t i = 0; i < mSlots.size(); ++i)
+        {
+          if (mSlots[i].tile == t)
+          {
+            s = i;
+            break;
+          }
+          if (mSlots[i].used < mSlots[s].used)
+            s = i;
+        }
+
+        if (mSlots[s].tile != t)
+        {
+          T *buf = mCache.data() + s * tile_elements;
+          if (mSlots[s].dirty)
+            detail::compress_tile<T, TILE>(buf, mTiles[mSlots[s].tile]);
+          detail::decompress_tile<T, TILE>(mTiles[t].data(), buf);
+          mSlots[s].tile = t;
+          mSlots[s].dirty = false;
+        }
+        mLast = s;
+      }
+
+      mSlots[s].used = ++mClock;
+      mSlots[s].dirty = mSlots[s].dirty || write;
+      return mCache.data() + s * tile_elements;
+    }
+
+    void check_range(size_t col, size_t row) const
+    {
+      if (col >= mCol || row >= mRow)
+        throw std::out_of_range("compressed_array2d::at");
+    }
+
+  protected:
+    size_t mCol;                                            // number of columns
+    size_t mRow;                                            // number of rows
+    size_t mTileRow;                                        // number of tiles along a column
+    mutable std::vector<std::vector<std::uint8_t>> mTiles;  // compressed tiles, column of tiles first
+    mutable std::vector<T> mCache;                          // decompressed tiles, slot s at s * tile_elements
+    mutable std::vector<slot> mSlots;                       // tile held by each slot of mCache
+    mutable std::uint64_t mClock;                           // access counter
+    mutable size_t mLast;                                   // slot of the last access
+  };
+}
+
+#endif
@@ -0,0 +1,370 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __PARALLEL_H__
+#define __PARALLEL_H__
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @Brief
+ * A work-stealing thread pool and a parallel_for built on top of it.
+ * 
+ * Every worker owns a queue of tasks : it pops the tasks it pushed itself from the back of its
+ * queue (the most recent, hence cache hot, first) and steals from the front of the queues of the
+ * other workers when its own queue is empty. Tasks pushed from outside the pool are dealt to the
+ * queues in turn. The workers sleep when no queue holds a task.
+ * 
+ * parallel_for splits a range into contiguous chunks, one per thread, the calling thread
+ * processing the first chunk. The split only depends on the range, the grain and the number
+ * of threads so that results are reproducible from one run to the next.
+ * parallel_for_dynamic splits a range into chunks of grain elements, which are balanced across
+ * the threads by stealing : it suits loops whose cost varies from one element to the other.
+ * A thread waiting for its chunks helps executing queued tasks, which makes nested calls safe.
+ * 
+ * example:
+ * -------
+ * parallel_for(0, n, 1024, [&](size_t begin, size_t end) {
+ *   for (size_t i = begin; i < end; ++i)
+ *     out[i] = f(in[i]);
+ * });
+ */
+
+//===============================================================================================//
+//                                       CLASS DEFINITION                                        //
+//===============================================================================================//
+
+class ThreadPool
+{
+public:
+  typedef std::function<void()> Task;
+
+public:
+  // creates a pool with n - 1 worker threads, the calling thread being the nth one
+  ThreadPool(size_t n = std::thread::hardware_concurrency())
+      : mQueued(0), mNext(0), mStop(false)
+  {
+    n = std::max<size_t>(n, 1);
+    for (size_t i = 0; i < std::max<size_t>(n - 1, 1); ++i)
+      mQueues.emplace_back(new Queue());
+
+    mWorkers.reserve(n - 1);
+    for (size_t i = 1; i < n; ++i)
+      mWorkers.emplace_back([this, i]() { work(i - 1); });
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  virtual ~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStop = true;
+    }
+    mCondition.notify_all();
+    for (std::thread &t : mWorkers)
+      t.join();
+  }
+
+  /**
+   * @Brief
+   * Returns the pool shared by the whole program, sized after the number of hardware threads.
+  **/
+  static ThreadPool &global()
+  {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  /**
+   * @Brief
+   * Returns the number of threads working on a parallel_for, including the calling thread.
+  **/
+  inline size_t num_threads() const noexcept { return mWorkers.size() + 1; }
+
+  /**
+   * @Brief
+   * Queues a task to be executed by one of the workers. A worker of the pool queues it in its own queue.
+  **/
+  void push(Task task)
+  {
+    const size_t self = worker_index();
+    Queue &q = *mQueues[self != npos ? self : mNext++ % mQueues.size()];
+
+    // counted before being queued so that mQueued never underflows
+    ++mQueued;
+    {
+      std::lock_guard<std::mutex> lock(q.mutex);
+      q.tasks.emplace_back(std::move(task));
+    }
+
+    // a sleeping worker checks mQueued while holding mMutex, the notification cannot be missed
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+    }
+    mCondition.notify_one();
+  }
+
+  /**
+   * @Brief
+   * Pops and executes one queued task, stealing it from another queue if needed.
+   * Returns false if all the queues were empty.
+  **/
+  bool run_one()
+  {
+    Task task;
+    if (!pop(worker_index(), task))
+      return false;
+    task();
+    return true;
+  }
+
+  /**
+   * @Brief
+   * Calls f(b, e) on contiguous sub-ranges [b, e) covering [begin, end), one per thread.
+   * Sub-ranges hold at least grain elements, except the last one. f must be thread safe.
+   * If f throws, the first exception is rethrown once all the sub-ranges are done.
+  **/
+  template <typename F>
+  void parallel_for(size_t begin, size_t end, size_t grain, F &&f)
+  {
+    if (end <= begin)
+      return;
+
+    grain = std::max<size_t>(grain, 1);
+    const size_t n = end - begin;
+    const size_t nchunk = std::min(num_threads(), (n + grain - 1) / grain);
+
+    // chunk size rounded up to a multiple of the grain
+    const size_t chunk = ((n + nchunk - 1) / nchunk + grain - 1) / grain * grain;
+    run_chunks(begin, end, chunk, f);
+  }
+
+  /**
+   * @Brief
+   * Calls f(b, e) on the sub-ranges [begin + k * grain, begin + (k + 1) * grain) covering [begin, end).
+   * The sub-ranges are queued as separate tasks balanced across the threads by stealing.
+   * f must be thread safe. If f throws, the first exception is rethrown once all the sub-ranges are done.
+  **/
+  template <typename F>
+  void parallel_for_dynamic(size_t begin, size_t end, size_t grain, F &&f)
+  {
+    if (end <= begin)
+      return;
+
+    grain = std::max<size_t>(grain, 1);
+    if (num_threads() == 1)
+    {
+      for (size_t b = begin; b < end; b += std::min(grain, end - b))
+        f(b, b + std::min(grain, end - b));
+      return;
+    }
+    run_chunks(begin, end, grain, f);
+  }
+
+protected:
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  static constexpr size_t npos = size_t(-1);
+
+  // index of the calling thread among the workers of this pool, npos for other threads
+  size_t worker_index() const noexcept
+  {
+    const std::pair<const ThreadPool *, size_t> &w = current_worker();
+    return (w.first == this) ? w.second : npos;
+  }
+
+  static std::pair<const ThreadPool *, size_t> &current_worker() noexcept
+  {
+    thread_local std::pair<const ThreadPool *, size_t> w(nullptr, npos);
+    return w;
+  }
+
+  // pops a task from the back of the queue self, or steals one from the front of another queue
+  bool pop(size_t self, Task &task)
+  {
+    if (mQueued == 0)
+      return false;
+
+    const size_t nq = mQueues.size();
+    if (self != npos)
+    {
+      Queue &q = *mQueues[self];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (!q.tasks.empty())
+      {
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+        --mQueued;
+        return true;
+      }
+    }
+
+    const size_t first = (self != npos) ? self + 1 : 0;
+    for (size_t k = 0; k < nq; ++k)
+    {
+      Queue &q = *mQueues[(first + k) % nq];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (!q.tasks.empty())
+      {
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        --mQueued;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // calls f on the chunks [b, b + chunk) of [begin, end), the calling thread processing the first one
+  template <typename F>
+  void run_chunks(size_t begin, size_t end, size_t chunk, F &f)
+  {
+    if (end - begin <= chunk)
+    {
+      f(begin, end);
+      return;
+    }
+
+    struct Sync
+    {
+      std::atomic<size_t> pending;
+      std::mutex mutex;
+      std::condition_variable done;
+      std::exception_ptr error;
+    } sync;
+    sync.pending = 0;
+
+    auto run = [&](size_t b, size_t e) {
+      try
+      {
+        f(b, e);
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(sync.mutex);
+        if (!sync.error)
+          sync.error = std::current_exception();
+      }
+    };
+
+    sync.pending = (end - begin - 1) / chunk;
+    for (size_t b = begin + chunk; b < end; b += chunk)
+    {
+      const std::pair<size_t, size_t> r(b, std::min(b + chunk, end));
+      push([&sync, &run, r]() {
+        run(r.first, r.second);
+
+        // sync lives on the stack of the caller, it must not be touched once pending reaches 0
+        std::lock_guard<std::mutex> lock(sync.mutex);
+        if (--sync.pending == 0)
+          sync.done.notify_all();
+      });
+    }
+
+    run(begin, std::min(begin + chunk, end));
+
+    // help with the queued tasks, then wait for the ones running on other threads
+    while (sync.pending > 0 && run_one())
+    {
+    }
+
+    std::unique_lock<std::mutex> lock(sync.mutex);
+    sync.done.wait(lock, [&sync]() { return sync.pending == 0; });
+
+    if (sync.error)
+      std::rethrow_exception(sync.error);
+  }
+
+  void work(size_t index)
+  {
+    current_worker() = {this, index};
+    for (;;)
+    {
+      Task task;
+      if (pop(index, task))
+      {
+        task();
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(mMutex);
+      mCondition.wait(lock, [this]() { return mStop || mQueued > 0; });
+      if (mStop && mQueued == 0)
+        return;
+    }
+  }
+
+protected:
+  std::vector<std::thread> mWorkers;          // worker threads
+  std::vector<std::unique_ptr<Queue>> mQueues; // one queue per worker
+  std::atomic<size_t> mQueued;                // number of queued tasks over all the queues
+  std::atomic<size_t> mNext;                  // queue receiving the next task pushed from outside the pool
+  std::mutex mMutex;                          // protects mStop, taken by the sleeping workers
+  std::condition_variable mCondition;
+  bool mStop; // set when the pool is destroyed
+};
+
+//===============================================================================================//
+//                                           FUNCTIONS                                           //
+//===============================================================================================//
+
+/**
+ * @Brief
+ * Calls f(b, e) on contiguous sub-ranges of [begin, end) using the global thread pool.
+**/
+template <typename F>
+inline void parallel_for(size_t begin, size_t end, size_t grain, F &&f)
+{
+  ThreadPool::global().parallel_for(begin, end, grain, std::forward<F>(f));
+}
+
+/**
+ * @Brief
+ * Calls f(b, e) on sub-ranges of grain elements of [begin, end), balanced across the threads of the global thread pool.
+**/
+template <typename F>
+inline void parallel_for_dynamic(size_t begin, size_t end, size_t grain, F &&f)
+{
+  ThreadPool::global().parallel_for_dynamic(begin, end, grain, std::forward<F>(f));
+}
+
+#endif
@@ -0,0 +1,128 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __SIMD_H__
+#define __SIMD_H__
+
+#include <cstddef>
+
+/**
+ * @Brief
+ * Helpers to write SIMD kernels with the GCC / Clang vector extensions and select
+ * the widest instruction set supported by the CPU at runtime.
+ * 
+ * A kernel is written once as an inline template over the vector width, then instantiated
+ * inside functions marked with SIMD_TARGET_AVX2 or SIMD_TARGET_AVX512 so that the compiler
+ * generates code for these instruction sets regardless of the -m flags.
+ * 
+ * example:
+ * -------
+ * switch (std::simd_isa_detect())
+ * {
+ * case std::simd_isa::AVX512: kernel_avx512(...); break;
+ * case std::simd_isa::AVX2: kernel_avx2(...); break;
+ * default: kernel_sse(...);
+ * }
+ */
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86 1
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#else
+#define SIMD_TARGET_AVX2
+#define SIMD_TARGET_AVX512
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMD_VECTOR_EXT 1
+#define SIMD_INLINE inline __attribute__((always_inline))
+#else
+#define SIMD_INLINE inline
+#endif
+
+namespace std
+{
+  enum class simd_isa
+  {
+    SCALAR = 0,
+    SSE = 1,
+    AVX2 = 2,
+    AVX512 = 3
+  };
+
+  /**
+   * @Brief
+   * Returns the widest instruction set supported by the CPU. The result is computed once.
+  **/
+  inline simd_isa simd_isa_detect() noexcept
+  {
+#ifdef SIMD_X86
+    static const simd_isa isa = []() {
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx512f"))
+        return simd_isa::AVX512;
+      if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return simd_isa::AVX2;
+      if (__builtin_cpu_supports("sse2"))
+        return simd_isa::SSE;
+      return simd_isa::SCALAR;
+    }();
+    return isa;
+#else
+    return simd_isa::SCALAR;
+#endif
+  }
+
+  inline const char *simd_isa_name(simd_isa isa) noexcept
+  {
+    switch (isa)
+    {
+    case simd_isa::SSE:
+      return "sse";
+    case simd_isa::AVX2:
+      return "avx2";
+    case simd_isa::AVX512:
+      return "avx512";
+    default:
+      return "scalar";
+    }
+  }
+
+#ifdef SIMD_VECTOR_EXT
+  /**
+   * @Brief
+   * A vector of BYTES / sizeof(T) elements of type T using the compiler vector extensions.
+  **/
+  template <typename T, size_t BYTES>
+  struct simd_vec
+  {
+    static constexpr size_t width = BYTES / sizeof(T);
+    typedef T type __attribute__((vector_size(BYTES)));
+  };
+#endif
+}
+
+#endif
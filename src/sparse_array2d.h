@@ -0,0 +1,636 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __SPARSE_ARRAY_2D__
+#define __SPARSE_ARRAY_2D__
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "array2d_view.h"
+#include "parallel.h"
+#include "vector2d.h"
+
+/**
+ * @Brief
+ * A 2d array storing only its non-zero elements, in compressed sparse column (CSC) format.
+ * 
+ * The non-zeros of each column are stored contiguously and sorted by row, the columns one after
+ * the other, matching the column major convention of array2d. Memory grows with the number of
+ * non-zeros : one value and one row index per non-zero, plus one offset per column.
+ * Elements are read with operator()(col, row), absent elements read as T(0). The array is built
+ * from a dense array or with a sparse_array2d::builder, and its structure is immutable afterwards;
+ * the values of the stored elements can still be modified.
+ * 
+ * Seen as a matrix with num_row() rows and num_col() columns, multiply computes y = A x in parallel.
+ * 
+ * example:
+ * -------
+ * std::sparse_array2d<float>::builder b(1000, 1000);
+ * b.add(3, 7, 1.f);                          // {col, row, value}, duplicates are summed
+ * b.add(999, 0, 2.f);
+ * std::sparse_array2d<float> s = b.build();
+ * 
+ * for (auto e : s)                           // non-zeros in column major order
+ *   std::cout << e.col << " " << e.row << " " << e.value << std::endl;
+ * 
+ * std::vector<float> x(1000, 1.f), y;
+ * s.multiply(x, y);                          // y[r] = sum_c s(c, r) * x[c]
+ */
+
+namespace std
+{
+  template <typename T, typename I = std::uint32_t>
+  class sparse_array2d
+  {
+    static_assert(std::is_integral<I>::value && std::is_unsigned<I>::value, "I must be an unsigned integer type");
+
+  public:
+    //============================================
+    //              Member Types
+    //============================================
+    typedef T value_type;
+    typedef I index_type;
+    typedef std::array<std::size_t, 2> size_type;
+
+    typedef value_type &reference;
+    typedef const value_type &const_reference;
+
+    typedef value_type *pointer;
+    typedef const value_type *const_pointer;
+
+    // a non-zero element as seen while iterating
+    struct entry
+    {
+      size_t col;
+      size_t row;
+      const T &value;
+    };
+
+    /**
+   * @Brief
+   * An iterator over the non-zero elements, in column major order.
+  **/
+    class const_iterator
+    {
+    public:
+      typedef std::forward_iterator_tag iterator_category;
+      typedef entry value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef void pointer;
+      typedef entry reference;
+
+      const_iterator() noexcept : mArray(nullptr), mCol(0), mIndex(0) {}
+      const_iterator(const sparse_array2d *a, size_t col, size_t index) noexcept
+          : mArray(a), mCol(col), mIndex(index)
+      {
+        skip();
+      }
+
+      inline reference operator*() const noexcept
+      {
+        return {mCol, size_t(mArray->mRowIdx[mIndex]), mArray->mValues[mIndex]};
+      }
+
+      inline const_iterator &operator++() noexcept
+      {
+        ++mIndex;
+        skip();
+        return *this;
+      }
+
+      inline const_iterator operator++(int) noexcept
+      {
+        const_iterator tmp(*this);
+        ++(*this);
+        return tmp;
+      }
+
+      inline bool operator==(const const_iterator &other) const noexcept { return mIndex == other.mIndex; }
+      inline bool operator!=(const const_iterator &other) const noexcept { return mIndex != other.mIndex; }
+
+    protected:
+      // moves to the column holding the current non-zero, skipping empty columns
+      inline void skip() noexcept
+      {
+        while (mCol < mArray->mCol && mIndex >= mArray->mColPtr[mCol + 1])
+          ++mCol;
+      }
+
+    protected:
+      const sparse_array2d *mArray;
+      size_t mCol;   // column of the current non-zero
+      size_t mIndex; // position of the current non-zero in the storage
+    };
+
+    /**
+   * @Brief
+   * Collects {col, row, value} triplets in any order and builds a sparse_array2d from them.
+   * Duplicated positions are summed.
+  **/
+    class builder
+    {
+    public:
+      builder(size_t col, size_t row)
+          : mCol(col), mRow(row), mSorted(true)
+      {
+        if (row > size_t(std::numeric_limits<I>::max()))
+          throw std::length_error("sparse_array2d::builder : too many rows for the index type");
+      }
+
+      // reserves the storage for n triplets
+      void reserve(size_t n)
+      {
+        mCols.reserve(n);
+        mRows.reserve(n);
+        mValues.reserve(n);
+      }
+
+      /**
+     * @Brief
+     * Adds value at {col, row}.
+     * If {col, row} is not within the range of the array, an exception of type std::out_of_range is thrown.
+    **/
+      void add(size_t col, size_t row, const T &value)
+      {
+        if (col >= mCol || row >= mRow)
+          throw std::out_of_range("sparse_array2d::builder::add");
+
+        // triplets added in column major order do not need to be sorted
+        if (!mCols.empty() && (col < mCols.back() || (col == mCols.back() && row < mRows.back())))
+          mSorted = false;
+
+        mCols.push_back(col);
+        mRows.push_back(I(row));
+        mValues.push_back(value);
+      }
+
+      inline size_t size() const noexcept { return mRows.size(); }
+
+      /**
+     * @Brief
+     * Returns the sparse array holding the added triplets, the builder is left empty.
+    **/
+      sparse_array2d build()
+      {
+        sparse_array2d s;
+        s.mCol = mCol;
+        s.mRow = mRow;
+        s.mColPtr.assign(mCol + 1, 0);
+
+        const size_t n = mRows.size();
+        for (size_t k = 0; k < n; ++k)
+          ++s.mColPtr[mCols[k] + 1];
+        for (size_t c = 0; c < mCol; ++c)
+          s.mColPtr[c + 1] += s.mColPtr[c];
+
+        if (mSorted)
+        {
+          s.mRowIdx = std::move(mRows);
+          s.mValues = std::move(mValues);
+        }
+        else
+        {
+          // radix sort : counting sort on the rows, then stable counting sort on the columns,
+          // duplicates stay in insertion order
+          std::vector<size_t> next(mRow + 1, 0);
+          for (size_t k = 0; k < n; ++k)
+            ++next[size_t(mRows[k]) + 1];
+          for (size_t r = 0; r < mRow; ++r)
+            next[r + 1] += next[r];
+
+          std::vector<size_t> byrow(n);
+          for (size_t k = 0; k < n; ++k)
+            byrow[next[mRows[k]]++] = k;
+
+          next.assign(s.mColPtr.begin(), s.mColPtr.end() - 1);
+          std::vector<size_t> order(n);
+          for (size_t k : byrow)
+            order[next[mCols[k]]++] = k;
+
+          s.mRowIdx.resize(n);
+          s.mValues.reserve(n);
+          for (size_t k = 0; k < n; ++k)
+          {
+            s.mRowIdx[k] = mRows[order[k]];
+            s.mValues.push_back(std::move(mValues[order[k]]));
+          }
+        }
+
+        s.merge_duplicates();
+        clear();
+        return s;
+      }
+
+      void clear() noexcept
+      {
+        mCols.clear();
+        mRows.clear();
+        mValues.clear();
+        mSorted = true;
+      }
+
+    protected:
+      size_t mCol;              // number of columns of the array
+      size_t mRow;              // number of rows of the array
+      std::vector<size_t> mCols; // column of each triplet
+      std::vector<I> mRows;     // row of each triplet
+      std::vector<T> mValues;   // value of each triplet
+      bool mSorted;             // true while the triplets are added in column major order
+    };
+
+  public:
+    //============================================
+    //              Initialisation
+    //============================================
+    sparse_array2d() noexcept
+        : mCol(0), mRow(0)
+    {
+    }
+
+    // an array of col x row zeros
+    sparse_array2d(size_t col, size_t row)
+        : mCol(col), mRow(row), mColPtr(col + 1, 0)
+    {
+      if (row > size_t(std::numeric_limits<I>::max()))
+        throw std::length_error("sparse_array2d : too many rows for the index type");
+    }
+
+    /**
+   * @Brief
+   * Builds a sparse copy of the dense 2d array src (array2d, vector2d or view), keeping the elements
+   * different from T(0).
+  **/
+    template <typename A, typename = detail::enable_2d_array<A>>
+    explicit sparse_array2d(const A &src)
+        : sparse_array2d(src.num_col(), src.num_row())
+    {
+      const size_t ld = detail::leading_dim(src);
+
+      for (size_t c = 0; c < mCol; ++c)
+      {
+        const auto *in = src.data() + c * ld;
+        for (size_t r0 = 0; r0 < mRow; r0 += dense_scan)
+        {
+          // blocks of zeros are skipped with a vectorized test
+          const size_t r1 = std::min(r0 + dense_scan, mRow);
+          size_t n = 0;
+          for (size_t r = r0; r < r1; ++r)
+            n += in[r] != T(0);
+          if (n == 0)
+            continue;
+
+          for (size_t r = r0; r < r1; ++r)
+            if (in[r] != T(0))
+            {
+              mRowIdx.push_back(I(r));
+              mValues.push_back(in[r]);
+            }
+        }
+        mColPtr[c + 1] = mValues.size();
+      }
+
+      mRowIdx.shrink_to_fit();
+      mValues.shrink_to_fit();
+    }
+
+    //============================================
+    //                Data Access
+    //============================================
+    /**
+   * @Brief
+   * Returns the element at {col, row}, T(0) if it is not stored, with bounds checking.
+   * If {col, row} is not within the range of the container, an exception of type std::out_of_range is thrown.
+  **/
+    T at(size_t col, size_t row) const
+    {
+      if (col >= mCol || row >= mRow)
+        throw std::out_of_range("sparse_array2d::at");
+      return (*this)(col, row);
+    }
+
+    /**
+   * @Brief
+   * Returns the element at {col, row}, T(0) if it is not stored. No bounds checking is performed.
+   * The row is searched by bisection among the non-zeros of the column.
+  **/
+    T operator()(size_t col, size_t row) const noexcept
+    {
+      const T *v = find(col, row);
+      return v != nullptr ? *v : T(0);
+    }
+
+    /**
+   * @Brief
+   * Returns a pointer to the stored element at {col, row}, nullptr if it is not stored.
+   * No bounds checking is performed.
+  **/
+    pointer find(size_t col, size_t row) noexcept
+    {
+      return const_cast<pointer>(static_cast<const sparse_array2d &>(*this).find(col, row));
+    }
+
+    const_pointer find(size_t col, size_t row) const noexcept
+    {
+      const I *first = mRowIdx.data() + mColPtr[col];
+      const I *last = mRowIdx.data() + mColPtr[col + 1];
+      const I *it = std::lower_bound(first, last, I(row));
+      if (it == last || *it != I(row))
+        return nullptr;
+      return mValues.data() + (it - mRowIdx.data());
+    }
+
+    /**
+   * @Brief
+   * Returns the compressed storage: the non-zeros of column c are at positions [col_ptr()[c], col_ptr()[c + 1])
+   * of row_index() and values(), sorted by row.
+  **/
+    inline const size_t *col_ptr() const noexcept { return mColPtr.data(); }
+    inline const I *row_index() const noexcept { return mRowIdx.data(); }
+    inline const_pointer values() const noexcept { return mValues.data(); }
+    inline pointer values() noexcept { return mValues.data(); }
+
+    //============================================
+    //                iterators
+    //============================================
+    /**
+   * @Brief
+   * Returns an iterator to the first non-zero element, in column major order.
+  **/
+    const_iterator begin() const noexcept { return const_iterator(this, 0, 0); }
+    const_iterator end() const noexcept { return const_iterator(this, mCol, nnz()); }
+
+    /**
+   * @Brief
+   * Returns an iterator to the first non-zero element of the ith column, and past the last one.
+   * If i is not within the range of the columns, an exception of type std::out_of_range is thrown.
+  **/
+    const_iterator begin_col(size_t i) const
+    {
+      check_col(i);
+      return const_iterator(this, i, mColPtr[i]);
+    }
+
+    const_iterator end_col(size_t i) const
+    {
+      check_col(i);
+      return const_iterator(this, i, mColPtr[i + 1]);
+    }
+
+    //============================================
+    //                capacity
+    //============================================
+    inline size_type size() const noexcept { return {mCol, mRow}; }
+    inline size_t num() const noexcept { return mCol * mRow; }
+    inline size_t num_col() const noexcept { return mCol; }
+    inline size_t num_row() const noexcept { return mRow; }
+    inline bool empty() const noexcept { return num() == 0; }
+
+    /**
+   * @Brief
+   * Returns the number of stored elements.
+  **/
+    inline size_t nnz() const noexcept { return mValues.size(); }
+
+    /**
+   * @Brief
+   * Returns the number of bytes used by the storage.
+  **/
+    inline size_t memory() const noexcept
+    {
+      return mColPtr.capacity() * sizeof(size_t) + mRowIdx.capacity() * sizeof(I) + mValues.capacity() * sizeof(T);
+    }
+
+    //============================================
+    //                operations
+    //============================================
+    /**
+   * @Brief
+   * Writes the array into the dense 2d array dst, absent elements being set to T(0).
+   * A vector2d destination is resized, otherwise if the dimensions of dst do not match,
+   * an exception of type std::length_error is thrown.
+  **/
+    template <typename A>
+    void to_dense(A &dst) const
+    {
+      if constexpr (std::is_same<A, vector2d<typename A::value_type>>::value)
+      {
+        if (dst.num_col() != mCol || dst.num_row() != mRow)
+          dst.resize(mCol, mRow);
+      }
+
+      if (dst.num_col() != mCol || dst.num_row() != mRow)
+        throw std::length_error("sparse_array2d::to_dense : dimension mismatch");
+
+      const size_t ld = detail::leading_dim(dst);
+      for (size_t c = 0; c < mCol; ++c)
+      {
+        auto *out = dst.data() + c * ld;
+        std::fill_n(out, mRow, T(0));
+        for (size_t k = mColPtr[c]; k < mColPtr[c + 1]; ++k)
+          out[mRowIdx[k]] = mValues[k];
+      }
+    }
+
+    vector2d<T> to_dense() const
+    {
+      vector2d<T> dst(mCol, mRow);
+      to_dense(dst);
+      return dst;
+    }
+
+    /**
+   * @Brief
+   * Computes y = A x, i.e. y[r] = sum_c A(c, r) * x[c], x holding num_col() elements and y num_row() elements.
+   * 
+   * The columns are split into ranges of similar numbers of non-zeros, one per thread. Each range is
+   * accumulated into its own vector, the vectors are then summed in range order : the result only
+   * depends on the number of threads of the pool.
+  **/
+    void multiply(const T *x, T *y) const
+    {
+      const size_t nchunk = std::max<size_t>(1, std::min(ThreadPool::global().num_threads(), nnz() / spmv_grain));
+      if (nchunk == 1)
+      {
+        std::fill_n(y, mRow, T(0));
+        accumulate(x, 0, mCol, y);
+        return;
+      }
+
+      // column ranges of about nnz() / nchunk non-zeros
+      std::vector<size_t> bounds(nchunk + 1, mCol);
+      bounds[0] = 0;
+      for (size_t k = 1; k < nchunk; ++k)
+        bounds[k] = size_t(std::lower_bound(mColPtr.begin(), mColPtr.end(), k * nnz() / nchunk) - mColPtr.begin());
+
+      // the first range is accumulated into y, the others into partial
+      std::vector<T> partial((nchunk - 1) * mRow);
+      parallel_for(0, nchunk, 1, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k)
+        {
+          T *out = k == 0 ? y : partial.data() + (k - 1) * mRow;
+          std::fill_n(out, mRow, T(0));
+          accumulate(x, bounds[k], bounds[k + 1], out);
+        }
+      });
+
+      parallel_for(0, mRow, 4096, [&](size_t begin, size_t end) {
+        for (size_t k = 1; k < nchunk; ++k)
+        {
+          const T *p = partial.data() + (k - 1) * mRow;
+          for (size_t r = begin; r < end; ++r)
+            y[r] += p[r];
+        }
+      });
+    }
+
+    /**
+   * @Brief
+   * Computes y = A x with containers, y is resized to num_row() elements.
+   * If x does not hold num_col() elements, an exception of type std::length_error is thrown.
+  **/
+    void multiply(const std::vector<T> &x, std::vector<T> &y) const
+    {
+      if (x.size() != mCol)
+        throw std::length_error("sparse_array2d::multiply : dimension mismatch");
+      y.resize(mRow);
+      multiply(x.data(), y.data());
+    }
+
+    /**
+   * @Brief
+   * Computes y = A^T x, i.e. y[c] = sum_r A(c, r) * x[r], x holding num_row() elements and y num_col() elements.
+   * Each element of y is a dot product over one column, computed in parallel without any temporary.
+  **/
+    void multiply_transposed(const T *x, T *y) const
+    {
+      parallel_for(0, mCol, std::max<size_t>(1, mCol * spmv_grain / std::max<size_t>(nnz(), 1)), [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c)
+        {
+          T s = T(0);
+          for (size_t k = mColPtr[c]; k < mColPtr[c + 1]; ++k)
+            s += mValues[k] * x[mRowIdx[k]];
+          y[c] = s;
+        }
+      });
+    }
+
+    void multiply_transposed(const std::vector<T> &x, std::vector<T> &y) const
+    {
+      if (x.size() != mRow)
+        throw std::length_error("sparse_array2d::multiply_transposed : dimension mismatch");
+      y.resize(mCol);
+      multiply_transposed(x.data(), y.data());
+    }
+
+    /**
+   * @Brief
+   * Exchanges the content of the container with other. No element is copied or moved.
+  **/
+    void swap(sparse_array2d &other) noexcept
+    {
+      std::swap(mCol, other.mCol);
+      std::swap(mRow, other.mRow);
+      mColPtr.swap(other.mColPtr);
+      mRowIdx.swap(other.mRowIdx);
+      mValues.swap(other.mValues);
+    }
+
+  protected:
+    // minimum number of non-zeros processed by a thread in a product
+    static constexpr size_t spmv_grain = 1 << 15;
+
+    // number of dense elements tested at once when looking for non-zeros
+    static constexpr size_t dense_scan = 32;
+
+    // y[r] += sum_c A(c, r) * x[c] for c in [c0, c1)
+    void accumulate(const T *x, size_t c0, size_t c1, T *y) const noexcept
+    {
+      for (size_t c = c0; c < c1; ++c)
+      {
+        const T xc = x[c];
+        for (size_t k = mColPtr[c]; k < mColPtr[c + 1]; ++k)
+          y[mRowIdx[k]] += mValues[k] * xc;
+      }
+    }
+
+    // sums the consecutive elements of a column sharing the same row, the rows being sorted
+    void merge_duplicates()
+    {
+      size_t k = 0;
+      size_t start = 0;
+      for (size_t c = 0; c < mCol; ++c)
+      {
+        const size_t end = mColPtr[c + 1];
+        for (size_t i = start; i < end; ++i)
+        {
+          if (k > mColPtr[c] && mRowIdx[k - 1] == mRowIdx[i])
+            mValues[k - 1] += mValues[i];
+          else
+          {
+            mRowIdx[k] = mRowIdx[i];
+            mValues[k] = std::move(mValues[i]);
+            ++k;
+          }
+        }
+        start = end;
+        mColPtr[c + 1] = k;
+      }
+      mRowIdx.resize(k);
+      mValues.erase(mValues.begin() + k, mValues.end());
+      mRowIdx.shrink_to_fit();
+      mValues.shrink_to_fit();
+    }
+
+    void check_col(size_t col) const
+    {
+      if (col >= mCol)
+        throw std::out_of_range("sparse_array2d::col");
+    }
+
+  protected:
+    size_t mCol;                // number of columns
+    size_t mRow;                // number of rows
+    std::vector<size_t> mColPtr; // mCol + 1 offsets, the non-zeros of column c are in [mColPtr[c], mColPtr[c + 1])
+    std::vector<I> mRowIdx;     // row of each non-zero
+    std::vector<T> mValues;     // value of each non-zero
+  };
+
+  template <typename T, typename I>
+  inline void swap(sparse_array2d<T, I> &a, sparse_array2d<T, I> &b) noexcept
+  {
+    a.swap(b);
+  }
+}
+
+#endif
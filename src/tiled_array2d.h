@@ -0,0 +1,265 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __TILED_ARRAY_2D__
+#define __TILED_ARRAY_2D__
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+
+#include "array2d_view.h"
+#include "vector2d.h"
+
+/**
+ * @Brief
+ * A runtime-sized 2d array stored in square tiles of TILE x TILE elements.
+ * 
+ * The tiles are stored one after the other in column major order, and the elements of a tile are
+ * stored in column major order. Elements that are close in 2d are therefore close in memory, which
+ * suits stencils and neighborhood queries better than a plain column major layout.
+ * The logical interface is the one of vector2d : operator()(col, row), at(col, row), fill...
+ * The dimensions are rounded up to a multiple of TILE in storage, the padding is never exposed.
+ * 
+ * TILE must be a power of two so that the element lookup only uses shifts and masks.
+ * Element access through operator() does not vectorize : sweeps over the whole array should work
+ * one tile at a time on tile(), and local queries on offsets from an element of the same tile.
+ * 
+ * example:
+ * -------
+ * std::vector2d<float> src(1920, 1080);
+ * std::tiled_array2d<float, 8> t(src.num_col(), src.num_row());
+ * t.from_col_major(src);
+ * float lap = t(c - 1, r) + t(c + 1, r) + t(c, r - 1) + t(c, r + 1) - 4.f * t(c, r);
+ * t.to_col_major(src);
+ */
+
+namespace std
+{
+  template <typename T, size_t TILE = 8>
+  class tiled_array2d
+  {
+    static_assert(TILE > 0 && (TILE & (TILE - 1)) == 0, "TILE must be a power of two");
+
+  public:
+    //============================================
+    //              Member Types
+    //============================================
+    typedef T value_type;
+    typedef std::array<std::size_t, 2> size_type;
+
+    typedef value_type &reference;
+    typedef const value_type &const_reference;
+
+    typedef value_type *pointer;
+    typedef const value_type *const_pointer;
+
+    static constexpr size_t tile_size = TILE;
+    static constexpr size_t tile_elements = TILE * TILE;
+
+  public:
+    //============================================
+    //              Initialisation
+    //============================================
+    tiled_array2d() noexcept
+        : mCol(0), mRow(0), mTileRow(0), mTileStride(0)
+    {
+    }
+
+    tiled_array2d(size_t col, size_t row, const T &value = T())
+        : mCol(col), mRow(row), mTileRow((row + TILE - 1) / TILE), mTileStride(mTileRow * tile_elements),
+          mTiles(mTileRow * ((col + TILE - 1) / TILE), tile_elements, value)
+    {
+    }
+
+    /**
+   * @Brief
+   * Builds a tiled copy of the 2d array src (array2d, vector2d or view).
+  **/
+    template <typename A>
+    explicit tiled_array2d(const A &src)
+        : tiled_array2d(src.num_col(), src.num_row())
+    {
+      from_col_major(src);
+    }
+
+    //============================================
+    //                Data Access
+    //============================================
+    /**
+   * @Brief
+   * Returns a reference to the element at specified location {col, row}, with bounds checking.
+   * If {col, row} is not within the range of the container, an exception of type std::out_of_range is thrown.
+  **/
+    reference at(size_t col, size_t row)
+    {
+      check_range(col, row);
+      return (*this)(col, row);
+    }
+
+    const_reference at(size_t col, size_t row) const
+    {
+      check_range(col, row);
+      return (*this)(col, row);
+    }
+
+    /**
+   * @Brief
+   * Returns a reference to the element at specified location {col, row}. No bounds checking is performed.
+  **/
+    reference operator()(size_t col, size_t row) noexcept
+    {
+      return mTiles.data()[offset(col, row)];
+    }
+
+    const_reference operator()(size_t col, size_t row) const noexcept
+    {
+      return mTiles.data()[offset(col, row)];
+    }
+
+    /**
+   * @Brief
+   * Returns a pointer to the first element of the tile {tc, tr}, i.e. of the element {tc * TILE, tr * TILE}.
+   * The TILE x TILE elements of the tile are contiguous and stored in column major order.
+   * No bounds checking is performed.
+  **/
+    pointer tile(size_t tc, size_t tr) noexcept
+    {
+      return mTiles.data() + tc * mTileStride + tr * tile_elements;
+    }
+
+    const_pointer tile(size_t tc, size_t tr) const noexcept
+    {
+      return mTiles.data() + tc * mTileStride + tr * tile_elements;
+    }
+
+    /**
+   * @Brief
+   * Returns a pointer to the storage, i.e. to the first tile. The storage is aligned on 64 bytes.
+  **/
+    pointer data() noexcept { return mTiles.data(); }
+    const_pointer data() const noexcept { return mTiles.data(); }
+
+    //============================================
+    //                capacity
+    //============================================
+    inline size_type size() const noexcept { return {mCol, mRow}; }
+    inline size_t num() const noexcept { return mCol * mRow; }
+    inline size_t num_col() const noexcept { return mCol; }
+    inline size_t num_row() const noexcept { return mRow; }
+    inline bool empty() const noexcept { return num() == 0; }
+
+    /**
+   * @Brief
+   * Returns the number of tiles along a row and along a column.
+  **/
+    inline size_t num_tile_col() const noexcept { return (mCol + TILE - 1) / TILE; }
+    inline size_t num_tile_row() const noexcept { return mTileRow; }
+
+    /**
+   * @Brief
+   * Returns the number of elements between the first elements of the tiles {tc, tr} and {tc + 1, tr}.
+  **/
+    inline size_t tile_stride() const noexcept { return mTileStride; }
+
+    //============================================
+    //                operations
+    //============================================
+    /**
+   * @Brief
+   * Assigns the given value value to all elements in the array.
+  **/
+    void fill(const T &value)
+    {
+      mTiles.fill(value);
+    }
+
+    /**
+   * @Brief
+   * Copies the elements of the column major 2d array src into the tiles, one tile column at a time.
+   * If the dimensions do not match, an exception of type std::length_error is thrown.
+  **/
+    template <typename A>
+    void from_col_major(const A &src)
+    {
+      if (src.num_col() != mCol || src.num_row() != mRow)
+        throw std::length_error("tiled_array2d::from_col_major : dimension mismatch");
+
+      const size_t ld = detail::leading_dim(src);
+      for (size_t c = 0; c < mCol; ++c)
+      {
+        const auto *in = src.data() + c * ld;
+        T *out = tile(c / TILE, 0) + (c % TILE) * TILE;
+        for (size_t r = 0; r < mRow; r += TILE, out += tile_elements)
+          std::copy_n(in + r, std::min(TILE, mRow - r), out);
+      }
+    }
+
+    /**
+   * @Brief
+   * Copies the elements of the tiles into the column major 2d array dst.
+   * If the dimensions do not match, an exception of type std::length_error is thrown.
+  **/
+    template <typename A>
+    void to_col_major(A &dst) const
+    {
+      if (dst.num_col() != mCol || dst.num_row() != mRow)
+        throw std::length_error("tiled_array2d::to_col_major : dimension mismatch");
+
+      const size_t ld = detail::leading_dim(dst);
+      for (size_t c = 0; c < mCol; ++c)
+      {
+        auto *out = dst.data() + c * ld;
+        const T *in = tile(c / TILE, 0) + (c % TILE) * TILE;
+        for (size_t r = 0; r < mRow; r += TILE, in += tile_elements)
+          std::copy_n(in, std::min(TILE, mRow - r), out + r);
+      }
+    }
+
+  protected:
+    // position of the element {col, row} in the storage, TILE being a power of two the divisions
+    // and modulos are shifts and masks
+    inline size_t offset(size_t col, size_t row) const noexcept
+    {
+      return (col / TILE) * mTileStride + (row / TILE) * tile_elements + (col % TILE) * TILE + (row % TILE);
+    }
+
+    void check_range(size_t col, size_t row) const
+    {
+      if (col >= mCol || row >= mRow)
+        throw std::out_of_range("tiled_array2d::at");
+    }
+
+  protected:
+    size_t mCol;          // number of columns
+    size_t mRow;          // number of rows
+    size_t mTileRow;      // number of tiles along a column
+    size_t mTileStride;   // number of elements between the tiles {tc, tr} and {tc + 1, tr}
+    vector2d<T> mTiles;   // tile t is column t, unpadded so that the tiles are contiguous
+  };
+}
+
+#endif
@@ -0,0 +1,754 @@
+/**
+  *
+  * MIT License
+  *
+  * Copyright (c) 2021 Georges Nader
+  *
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  *
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  */
+
+#ifndef __VECTOR_2D__
+#define __VECTOR_2D__
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+#include "array2d.h"
+
+/**
+ * @Brief
+ * A runtime-sized 2d column major array with an interface similar to std::array2d.
+ * The elements are stored in a single heap allocated buffer aligned on 64 bytes.
+ * 
+ * A vector2d can also wrap an external buffer without copying it, in which case
+ * it does not own the memory and will not release it.
+ * 
+ * Columns can be padded to a pitch (or leading dimension) larger than the number of rows,
+ * column i starting at data() + i * ld(). Pitched arrays created with vector2d::pitched() have
+ * every column aligned on 64 bytes, and a pitch chosen to avoid cache set conflicts when
+ * walking along a row of an array whose column size is a power of two.
+ * 
+ * example:
+ * -------
+ * std::vector2d<float> arr0(2, 3);
+ * std::vector2d<float> arr1(2, 3, {1, 2, 3, 4, 5, 6});
+ * std::vector2d<float> arr2(ptr, 2, 3); // no copy, ptr must outlive arr2
+ * std::vector2d<float> arr3 = std::vector2d<float>::pitched(1024, 1024); // ld() == 1040
+ */
+
+namespace std
+{
+  template <typename T>
+  class vector2d
+  {
+  public:
+    //============================================
+    //              Member Types
+    //============================================
+    typedef T value_type;
+    typedef std::array<std::size_t, 2> size_type;
+
+    typedef value_type &reference;
+    typedef const value_type &const_reference;
+
+    typedef value_type *pointer;
+    typedef const value_type *const_pointer;
+
+    typedef block_iterator<value_type> iterator;
+    typedef block_iterator<const value_type> const_iterator;
+
+    typedef pointer col_iterator;
+    typedef const_pointer const_col_iterator;
+
+    static constexpr std::size_t alignment = 64;
+
+  public:
+    //============================================
+    //              Initialisation
+    //============================================
+    vector2d() noexcept
+        : mData(nullptr), mCol(0), mRow(0), mLd(0), mOwner(true)
+    {
+    }
+
+    vector2d(size_t col, size_t row)
+        : vector2d(col, row, row, T())
+    {
+    }
+
+    vector2d(size_t col, size_t row, const T &value)
+        : vector2d(col, row, row, value)
+    {
+    }
+
+    vector2d(size_t col, size_t row, const std::initializer_list<T> &list)
+        : vector2d(col, row)
+    {
+      iterator itr = begin();
+      iterator finish = end();
+      for (const_reference l : list)
+      {
+        if (itr == finish)
+          break;
+        *itr++ = l;
+      }
+    }
+
+    /**
+   * @Brief
+   * Wraps the external buffer ptr of col columns of row elements stored in column major order,
+   * consecutive columns being ld elements apart (ld = row if ld is 0).
+   * No copy is performed: the buffer is not owned and must outlive the vector2d.
+  **/
+    vector2d(pointer ptr, size_t col, size_t row, size_t ld = 0) noexcept
+        : mData(ptr), mCol(col), mRow(row), mLd(ld == 0 ? row : ld), mOwner(false)
+    {
+    }
+
+    template <size_t COL, size_t ROW>
+    explicit vector2d(const array2d<T, COL, ROW> &other)
+        : mData(nullptr), mCol(COL), mRow(ROW), mLd(ROW), mOwner(true)
+    {
+      copy_from(other.data(), ROW);
+    }
+
+    /**
+   * @Brief
+   * Returns a col x row array whose columns are ld elements apart and aligned on 64 bytes.
+   * If ld is 0, it is computed by auto_pitch(). If ld is smaller than row, an exception of type
+   * std::length_error is thrown.
+  **/
+    static vector2d pitched(size_t col, size_t row, size_t ld = 0)
+    {
+      if (ld == 0)
+        ld = auto_pitch(row);
+      if (ld < row)
+        throw std::length_error("vector2d::pitched : the pitch is smaller than the number of rows");
+      return vector2d(col, row, ld, T());
+    }
+
+    /**
+   * @Brief
+   * Returns the smallest pitch larger than row that is a multiple of 64 bytes, adding one cache line
+   * when the pitch would be a multiple of 512 bytes so that consecutive columns do not map to the
+   * same cache sets. Returns row if 64 is not a multiple of the element size.
+  **/
+    static constexpr size_t auto_pitch(size_t row) noexcept
+    {
+      if (alignment % sizeof(T) != 0)
+        return row;
+
+      const size_t line = alignment / sizeof(T);
+      size_t ld = (row + line - 1) / line * line;
+      if ((ld * sizeof(T)) % 512 == 0)
+        ld += line;
+      return ld;
+    }
+
+    /**
+   * @Brief
+   * Allocates an array with the dimensions of an element-wise expression and evaluates it (see array2d_expr.h).
+  **/
+    template <typename E>
+    vector2d(const array2d_expr<E> &expr)
+        : vector2d(expr.num_col(), expr.num_row())
+    {
+      expr.assign_to(*this);
+    }
+
+    // copy constructor : always performs a deep copy keeping the pitch, even if other wraps an external buffer
+    vector2d(const vector2d &other)
+        : mData(nullptr), mCol(other.mCol), mRow(other.mRow), mLd(other.mLd), mOwner(true)
+    {
+      copy_from(other.mData, other.mLd);
+    }
+
+    vector2d(vector2d &&other) noexcept
+        : mData(other.mData), mCol(other.mCol), mRow(other.mRow), mLd(other.mLd), mOwner(other.mOwner)
+    {
+      other.mData = nullptr;
+      other.mCol = 0;
+      other.mRow = 0;
+      other.mLd = 0;
+      other.mOwner = true;
+    }
+
+    virtual ~vector2d()
+    {
+      release();
+    }
+
+    vector2d &operator=(const vector2d &other)
+    {
+      if (this != &other)
+      {
+        vector2d tmp(other);
+        swap(tmp);
+      }
+      return *this;
+    }
+
+    vector2d &operator=(vector2d &&other) noexcept
+    {
+      if (this != &other)
+      {
+        release();
+        mData = other.mData;
+        mCol = other.mCol;
+        mRow = other.mRow;
+        mLd = other.mLd;
+        mOwner = other.mOwner;
+
+        other.mData = nullptr;
+        other.mCol = 0;
+        other.mRow = 0;
+        other.mLd = 0;
+        other.mOwner = true;
+      }
+      return *this;
+    }
+
+    /**
+   * @Brief
+   * Evaluates an element-wise expression into the array in a single pass (see array2d_expr.h).
+   * The array is resized to the dimensions of the expression if needed.
+  **/
+    template <typename E>
+    vector2d &operator=(const array2d_expr<E> &expr)
+    {
+      if (mCol != expr.num_col() || mRow != expr.num_row())
+        resize(expr.num_col(), expr.num_row());
+      expr.assign_to(*this);
+      return *this;
+    }
+
+    //============================================
+    //                Data Access
+    //============================================
+    /**
+   * @Brief
+   * Returns a reference to the element at specified location {col, row}, with bounds checking.
+   * If {col, row} is not within the range of the container, an exception of type std::out_of_range is thrown.
+  **/
+    reference at(size_t col, size_t row)
+    {
+      check_range(col, row);
+      return mData[col * mLd + row];
+    }
+
+    const_reference at(size_t col, size_t row) const
+    {
+      check_range(col, row);
+      return mData[col * mLd + row];
+    }
+
+    /**
+   * @Brief
+   * Returns a reference to the element at specified location i, with bounds checking.
+   * If i is not within the range of the container, an exception of type std::out_of_range is thrown.
+   * 
+   * i is the index of the element in a column-major ordering.
+  **/
+    reference at(size_t i)
+    {
+      if (i >= num())
+        throw std::out_of_range("vector2d::at");
+      return mData[offset(i)];
+    }
+
+    const_reference at(size_t i) const
+    {
+      if (i >= num())
+        throw std::out_of_range("vector2d::at");
+      return mData[offset(i)];
+    }
+
+    /**
+   * @Brief
+   * Returns a reference to the element at specified location {col, row}. No bounds checking is performed.
+  **/
+    reference operator()(size_t col, size_t row) noexcept
+    {
+      return mData[col * mLd + row];
+    }
+
+    const_reference operator()(size_t col, size_t row) const noexcept
+    {
+      return mData[col * mLd + row];
+    }
+
+    /**
+   * @Brief
+   * Returns a reference to the element at specified location i. No bounds checking is performed.
+   * 
+   * i is the index of the element in a column-major ordering.
+  **/
+    reference operator()(size_t i) noexcept
+    {
+      return mData[offset(i)];
+    }
+
+    const_reference operator()(size_t i) const noexcept
+    {
+      return mData[offset(i)];
+    }
+
+    reference operator[](size_t i) noexcept
+    {
+      return mData[offset(i)];
+    }
+
+    const_reference operator[](size_t i) const noexcept
+    {
+      return mData[offset(i)];
+    }
+
+    /**
+   * @Brief
+   * Returns a reference to the first element in the container.
+  **/
+    reference front()
+    {
+      return at(0, 0);
+    }
+
+    const_reference front() const
+    {
+      return at(0, 0);
+    }
+
+    /**
+   * @Brief
+   * Returns a reference to the last element in the container.
+  **/
+    reference back()
+    {
+      return at(mCol - 1, mRow - 1);
+    }
+
+    const_reference back() const
+    {
+      return at(mCol - 1, mRow - 1);
+    }
+
+    /**
+   * @Brief
+   * Returns pointer to the underlying array serving as element storage.
+   * The buffer is aligned on 64 bytes when it is owned by the container.
+   * Column i starts at data() + i * ld(), the range [data(); data() + num()) is only valid
+   * if the array is contiguous.
+  **/
+    pointer data() noexcept
+    {
+      return mData;
+    }
+
+    const_pointer data() const noexcept
+    {
+      return mData;
+    }
+
+    /**
+   * @Brief
+   * Returns the pitch (or leading dimension) of the array, i.e. the distance between the first elements of two
+   * consecutive columns. Equal to num_row() unless the columns are padded.
+  **/
+    inline size_t ld() const noexcept { return mLd; }
+
+    /**
+   * @Brief
+   * Returns true if the columns are not padded, i.e. the elements are contiguous.
+  **/
+    inline bool contiguous() const noexcept { return mLd == mRow || mCol <= 1; }
+
+    /**
+   * @Brief
+   * Returns a view over the elements of the ith column (see array2d_view.h).
+   * If i is not within the range of the columns, an exception of type std::out_of_range is thrown.
+  **/
+    col_view<T> col(size_t i)
+    {
+      return col_view<T>(*this, i);
+    }
+
+    col_view<const T> col(size_t i) const
+    {
+      return col_view<const T>(*this, i);
+    }
+
+    /**
+   * @Brief
+   * Returns a view over the elements of the ith row (see array2d_view.h).
+   * If i is not within the range of the rows, an exception of type std::out_of_range is thrown.
+  **/
+    row_view<T> row(size_t i)
+    {
+      return row_view<T>(*this, i);
+    }
+
+    row_view<const T> row(size_t i) const
+    {
+      return row_view<const T>(*this, i);
+    }
+
+    /**
+   * @Brief
+   * Returns a view over the nc x nr block starting at {c0, r0} (see array2d_view.h).
+   * If the block is not within the range of the array, an exception of type std::out_of_range is thrown.
+  **/
+    block_view<T> block(size_t c0, size_t r0, size_t nc, size_t nr)
+    {
+      return block_view<T>(*this, c0, r0, nc, nr);
+    }
+
+    block_view<const T> block(size_t c0, size_t r0, size_t nc, size_t nr) const
+    {
+      return block_view<const T>(*this, c0, r0, nc, nr);
+    }
+
+    /**
+   * @Brief
+   * Returns true if the container owns its storage, false if it wraps an external buffer.
+  **/
+    inline bool owner() const noexcept { return mOwner; }
+
+    //============================================
+    //                iterators
+    //============================================
+    /**
+   * @Brief
+   * Returns an iterator to the first element of the array.
+  **/
+    iterator begin() noexcept
+    {
+      return iterator(mData, mRow, mLd, 0);
+    }
+
+    const_iterator begin() const noexcept
+    {
+      return const_iterator(mData, mRow, mLd, 0);
+    }
+
+    /**
+   * @Brief
+   * Returns an iterator to the last element of the array.
+  **/
+    iterator end() noexcept
+    {
+      return iterator(mData, mRow, mLd, std::ptrdiff_t(num()));
+    }
+
+    const_iterator end() const noexcept
+    {
+      return const_iterator(mData, mRow, mLd, std::ptrdiff_t(num()));
+    }
+
+    /**
+   * @Brief
+   * Returns an iterator to the first element of the ith coloum.
+   * If i is not within the range of the columns, an exception of type std::out_of_range is thrown.
+  **/
+    col_iterator begin_col(size_t i)
+    {
+      check_col(i);
+      return mData + i * mLd;
+    }
+
+    const_col_iterator begin_col(size_t i) const
+    {
+      check_col(i);
+      return mData + i * mLd;
+    }
+
+    /**
+   * @Brief
+   * Returns an iterator to the last element of the ith column.
+   * If i is not within the range of the columns, an exception of type std::out_of_range is thrown.
+   * 
+   * if the array is contiguous and i is not the last columns, that is is the equal to begin_col(i+1)
+  **/
+    col_iterator end_col(size_t i)
+    {
+      check_col(i);
+      return mData + i * mLd + mRow;
+    }
+
+    const_col_iterator end_col(size_t i) const
+    {
+      check_col(i);
+      return mData + i * mLd + mRow;
+    }
+
+    //============================================
+    //                capacity
+    //============================================
+    /**
+   * @Brief
+   * Returns the 2d size of the array.
+  **/
+    inline size_type size() const noexcept { return {mCol, mRow}; }
+
+    /**
+   * @Brief
+   * Returns the size of a column.
+  **/
+    inline size_t size_col() const noexcept { return mRow; }
+
+    /**
+   * @Brief
+   * Returns the size of a row.
+  **/
+    inline size_t size_row() const noexcept { return mCol; }
+
+    /**
+   * @Brief
+   * Returns the number of elements in the 2d array.
+  **/
+    inline size_t num() const noexcept { return mCol * mRow; }
+    inline size_t max_size() const noexcept { return mCol * mRow; }
+
+    /**
+   * @Brief
+   * Returns the number of columns.
+  **/
+    inline size_t num_col() const noexcept { return mCol; }
+
+    /**
+   * @Brief
+   * Returns the number of row.
+  **/
+    inline size_t num_row() const noexcept { return mRow; }
+
+    /**
+   * @Brief
+   * checks whether the number of elemets is 0.
+  **/
+    inline bool empty() const noexcept { return num() == 0; }
+
+    //============================================
+    //                operations
+    //============================================
+    /**
+   * @Brief
+   * Assigns the given value value to all elements in the array.
+  **/
+    void fill(const T &value)
+    {
+      if (contiguous())
+        std::fill_n(mData, num(), value);
+      else
+        for (size_t c = 0; c < mCol; ++c)
+          std::fill_n(mData + c * mLd, mRow, value);
+    }
+
+    /**
+   * @Brief
+   * Copies the n first elements of src into the array, in column-major order.
+   * If n is larger than the number of elements, an exception of type std::length_error is thrown.
+  **/
+    void assign(const_pointer src, size_t n)
+    {
+      if (n > num())
+        throw std::length_error("vector2d::assign");
+
+      if (contiguous())
+        detail::bulk_copy(src, n, mData);
+      else
+        for (size_t c = 0; c * mRow < n; ++c)
+          detail::bulk_copy(src + c * mRow, std::min(mRow, n - c * mRow), mData + c * mLd);
+    }
+
+    /**
+   * @Brief
+   * Copies the elements from a strided buffer: element {col, row} is read from src[col * col_stride + row * row_stride].
+   * A row-major buffer has a col_stride of 1 and a row_stride of num_col(), a pitched column-major buffer
+   * has a col_stride equal to its pitch and a row_stride of 1.
+  **/
+    void assign(const_pointer src, std::ptrdiff_t col_stride, std::ptrdiff_t row_stride)
+    {
+      detail::strided_copy(mCol, mRow, src, col_stride, row_stride, mData, std::ptrdiff_t(mLd), 1);
+    }
+
+    /**
+   * @Brief
+   * Copies the elements of the array into dst, in column-major order and without padding.
+   * dst must hold at least num() elements.
+  **/
+    void copy_to(pointer dst) const
+    {
+      detail::strided_copy(mCol, mRow, mData, std::ptrdiff_t(mLd), 1, dst, std::ptrdiff_t(mRow), 1);
+    }
+
+    /**
+   * @Brief
+   * Copies the elements of the array into a strided buffer: element {col, row} is written to dst[col * col_stride + row * row_stride].
+  **/
+    void copy_to(pointer dst, std::ptrdiff_t col_stride, std::ptrdiff_t row_stride) const
+    {
+      detail::strided_copy(mCol, mRow, mData, std::ptrdiff_t(mLd), 1, dst, col_stride, row_stride);
+    }
+
+    /**
+   * @Brief
+   * Changes the dimensions of the array. Nothing happens if the dimensions do not change. The storage of an
+   * unpadded array is kept when the number of elements does not change, otherwise it is reallocated without
+   * padding and the elements are value initialized.
+   * A container wrapping an external buffer always allocates its own storage and stops referencing the buffer.
+  **/
+    void resize(size_t col, size_t row)
+    {
+      if (col == mCol && row == mRow)
+        return;
+
+      // a padded array, even with a single column, owns more than num() elements
+      if (mOwner && mLd == mRow && col * row == num())
+      {
+        mCol = col;
+        mRow = row;
+        mLd = row;
+        return;
+      }
+
+      vector2d tmp(col, row);
+      swap(tmp);
+    }
+
+    /**
+   * @Brief
+   * Exchanges the content of the container with other. No element is copied or moved.
+  **/
+    void swap(vector2d &other) noexcept
+    {
+      std::swap(mData, other.mData);
+      std::swap(mCol, other.mCol);
+      std::swap(mRow, other.mRow);
+      std::swap(mLd, other.mLd);
+      std::swap(mOwner, other.mOwner);
+    }
+
+  protected:
+    // allocates col columns of ld elements and initializes them with value
+    vector2d(size_t col, size_t row, size_t ld, const T &value)
+        : mData(nullptr), mCol(col), mRow(row), mLd(ld), mOwner(true)
+    {
+      mData = allocate(storage());
+      try
+      {
+        std::uninitialized_fill_n(mData, storage(), value);
+      }
+      catch (...)
+      {
+        deallocate(mData);
+        throw;
+      }
+    }
+
+    // number of elements of the storage, padding included
+    inline size_t storage() const noexcept { return mCol * mLd; }
+
+    // position in the storage of the ith element in column major order
+    inline size_t offset(size_t i) const noexcept
+    {
+      if (mLd == mRow)
+        return i;
+      const size_t col = i / mRow;
+      return col * mLd + (i - col * mRow);
+    }
+
+    static pointer allocate(size_t n)
+    {
+      if (n == 0)
+        return nullptr;
+      return static_cast<pointer>(::operator new(n * sizeof(T), std::align_val_t(alignment)));
+    }
+
+    static void deallocate(pointer ptr) noexcept
+    {
+      if (ptr != nullptr)
+        ::operator delete(ptr, std::align_val_t(alignment));
+    }
+
+    // copies the elements of src whose columns are ld elements apart, mLd must be set.
+    // the padding of src is never read, it may lie outside of a wrapped buffer.
+    void copy_from(const_pointer src, size_t ld)
+    {
+      mData = allocate(storage());
+      try
+      {
+        if (ld == mRow && mLd == mRow)
+          std::uninitialized_copy_n(src, storage(), mData);
+        else
+        {
+          std::uninitialized_value_construct_n(mData, storage());
+          for (size_t c = 0; c < mCol; ++c)
+            std::copy_n(src + c * ld, mRow, mData + c * mLd);
+        }
+      }
+      catch (...)
+      {
+        deallocate(mData);
+        mData = nullptr;
+        throw;
+      }
+    }
+
+    void release() noexcept
+    {
+      if (mOwner && mData != nullptr)
+      {
+        std::destroy_n(mData, storage());
+        deallocate(mData);
+      }
+      mData = nullptr;
+    }
+
+    void check_range(size_t col, size_t row) const
+    {
+      if (col >= mCol || row >= mRow)
+        throw std::out_of_range("vector2d::at");
+    }
+
+    void check_col(size_t col) const
+    {
+      if (col >= mCol)
+        throw std::out_of_range("vector2d::col");
+    }
+
+  protected:
+    pointer mData; // column major storage, aligned on 64 bytes when owned
+    size_t mCol;   // number of columns
+    size_t mRow;   // number of rows
+    size_t mLd;    // distance between two consecutive columns, >= mRow
+    bool mOwner;   // false if mData wraps an external buffer
+  };
+
+  template <typename T>
+  inline void swap(vector2d<T> &a, vector2d<T> &b) noexcept
+  {
+    a.swap(b);
+  }
+}
+
+#endif